@@ -1,5 +1,6 @@
 #include "ADIOSDataAdaptor.h"
 #include "ConfigurableAnalysis.h"
+#include "DataRequirements.h"
 #include "Timer.h"
 #include "Error.h"
 
@@ -7,6 +8,7 @@
 
 #include <mpi.h>
 #include <iostream>
+#include <sstream>
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
 #include <vtkDataSet.h>
@@ -32,18 +34,27 @@ int main(int argc, char **argv)
 {
   int rank, size;
   MPI_Comm comm = MPI_COMM_WORLD;
-  MPI_Init (&argc, &argv);
+  // reading ahead uses a helper thread that makes ADIOS calls
+  int threadLevel = 0;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &threadLevel);
   MPI_Comm_rank(comm, &rank);
   MPI_Comm_size(comm, &size);
 
   std::string input;
   std::string readmethod("bp");
   std::string config_file;
+  unsigned long readAheadBudget = 0;
+  std::string roi;
+  std::string blockAssignment("contiguous");
 
   opts::Options ops(argc, argv);
   ops >> opts::Option('r', "readmethod", readmethod, "specify read method: bp, bp_aggregate, dataspaces, dimes, or flexpath ")
-      >> opts::Option('f', "config", config_file, "Sensei analysis configuration xml (required)");
+      >> opts::Option('f', "config", config_file, "Sensei analysis configuration xml (required)")
+      >> opts::Option("read-ahead-budget", readAheadBudget, "limit the data read ahead to this many MB per rank (0 for no limit)")
+      >> opts::Option("block-assignment", blockAssignment, "assign the blocks written to the ranks reading: contiguous, round_robin, or balanced")
+      >> opts::Option("roi", roi, "read only the part of a mesh inside a region of interest, given as \"mesh x0 x1 y0 y1 z0 z1\"");
 
+  bool readAhead = ops >> opts::Present("read-ahead", "read the next time step while the current one is analyzed");
   bool log = ops >> opts::Present("log", "generate time and memory usage log");
   bool shortlog = ops >> opts::Present("shortlog", "generate a summary time and memory usage log");
   bool showHelp = ops >> opts::Present('h', "help", "show help");
@@ -74,6 +85,13 @@ int main(int argc, char **argv)
   // open the ADIOS stream using the ADIOS adaptor
   DataAdaptorPtr dataAdaptor = DataAdaptorPtr::New();
   dataAdaptor->SetCommunicator(comm);
+  if (dataAdaptor->SetBlockAssignment(blockAssignment))
+    MPI_Abort(comm, 1);
+
+  // read ahead is enabled before the stream is opened
+  dataAdaptor->SetReadAheadBudget(readAheadBudget);
+  dataAdaptor->SetReadAhead(readAhead);
+
   if (dataAdaptor->Open(readmethod, input))
     {
     SENSEI_ERROR("Failed to open \"" << input << "\"")
@@ -91,6 +109,33 @@ int main(int argc, char **argv)
     MPI_Abort(comm, 1);
     }
 
+  // read only the meshes and arrays the analyses use. when one of them
+  // may use any of the data the requirements are empty and all of it is
+  // read. the region of interest restricts the reads of its mesh, when
+  // the analyses give no arrays it alone doesn't limit the arrays read
+  sensei::DataRequirements reqs;
+  analysisAdaptor->GetDataRequirements(reqs);
+
+  if (!roi.empty())
+    {
+    std::istringstream iss(roi);
+    std::string meshName;
+    double bounds[6] = {0.0};
+    iss >> meshName;
+    for (int i = 0; i < 6; ++i)
+      iss >> bounds[i];
+
+    if (iss.fail())
+      {
+      SENSEI_ERROR("Invalid region of interest \"" << roi << "\"")
+      MPI_Abort(comm, 1);
+      }
+
+    reqs.SetRegionOfInterest(meshName, bounds);
+    }
+
+  dataAdaptor->SetDataRequirements(reqs);
+
   // read from the ADIOS stream until all steps have been
   // processed
   unsigned int nSteps = 0;
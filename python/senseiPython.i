@@ -266,7 +266,7 @@ VTK_DERIVED(ConfigurableAnalysis)
     // invoke the C++ method
     double hmin = 0.0;
     double hmax = 0.0;
-    std::vector<unsigned int> hist;
+    std::vector<uint64_t> hist;
     if (self->GetHistogram(hmin, hmax, hist))
       {
       PyErr_Format(PyExc_RuntimeError,
@@ -278,7 +278,7 @@ VTK_DERIVED(ConfigurableAnalysis)
     PyObject *retTup = PyTuple_New(3);
     PyTuple_SetItem(retTup, 0, senseiPyObject::PyTT<double>::NewObject(hmin));
     PyTuple_SetItem(retTup, 1, senseiPyObject::PyTT<double>::NewObject(hmax));
-    PyTuple_SetItem(retTup, 2, senseiPySequence::NewList<unsigned int>(hist));
+    PyTuple_SetItem(retTup, 2, senseiPySequence::NewList<uint64_t>(hist));
 
     return retTup;
   }
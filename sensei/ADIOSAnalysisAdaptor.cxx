@@ -27,27 +27,387 @@
 #include <vtkInformation.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkPoints.h>
 #include <vtkSmartPointer.h>
 
 #include <mpi.h>
 #include <adios.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include <vector>
 
+namespace
+{
+
+// buffers that hold the arrays of a snapshot. the buffers are kept from
+// step to step so that once the sizes are steady making a snapshot does
+// not allocate memory for the bulk of the data
+class StagingPool
+{
+public:
+  StagingPool() : Next(0) {}
+
+  // makes the buffers available for reuse. arrays returned by Copy
+  // since the last call must no longer be in use
+  void Reset() { this->Next = 0; }
+
+  // returns a new array of the same type, shape, and values as da whose
+  // values are held in one of the buffers
+  vtkDataArray *Copy(vtkDataArray *da);
+
+private:
+  std::vector<std::vector<char>> Buffers;
+  size_t Next;
+};
+
+// --------------------------------------------------------------------------
+vtkDataArray *StagingPool::Copy(vtkDataArray *da)
+{
+  if (this->Next == this->Buffers.size())
+    this->Buffers.emplace_back();
+
+  std::vector<char> &buffer = this->Buffers[this->Next];
+  ++this->Next;
+
+  vtkIdType n_vals = da->GetNumberOfTuples()*da->GetNumberOfComponents();
+  size_t n_bytes = n_vals*da->GetDataTypeSize();
+  if (buffer.size() < n_bytes)
+    buffer.resize(n_bytes);
+
+  if (n_bytes)
+    memcpy(buffer.data(), da->GetVoidPointer(0), n_bytes);
+
+  // the array does not own the buffer
+  vtkDataArray *copy = da->NewInstance();
+  copy->SetName(da->GetName());
+  copy->SetNumberOfComponents(da->GetNumberOfComponents());
+  copy->SetVoidArray(buffer.data(), n_vals, 1);
+
+  return copy;
+}
+
+// --------------------------------------------------------------------------
+vtkCellArray *stageCells(vtkCellArray *cells, StagingPool *pool)
+{
+  vtkIdTypeArray *data =
+    static_cast<vtkIdTypeArray*>(pool->Copy(cells->GetData()));
+
+  vtkCellArray *copy = vtkCellArray::New();
+  copy->SetCells(cells->GetNumberOfCells(), data);
+  data->Delete();
+
+  return copy;
+}
+
+// --------------------------------------------------------------------------
+// returns a copy of the dataset that shares nothing the simulation could
+// change. the arrays are copied into the pool or, if the pool is null,
+// shared
+vtkDataSet *stageDataSet(vtkDataSet *ds, StagingPool *pool)
+{
+  vtkDataSet *copy = ds->NewInstance();
+  copy->ShallowCopy(ds);
+
+  if (!pool)
+    return copy;
+
+  // point and cell data. adding an array replaces the one of the same
+  // name
+  int atts[2] = {vtkDataObject::POINT, vtkDataObject::CELL};
+  for (int j = 0; j < 2; ++j)
+    {
+    vtkDataSetAttributes *dsa = copy->GetAttributes(atts[j]);
+    for (int i = 0, n = dsa->GetNumberOfArrays(); i < n; ++i)
+      {
+      vtkDataArray *da = dsa->GetArray(i);
+      if (!da)
+        continue;
+
+      vtkDataArray *staged = pool->Copy(da);
+      dsa->AddArray(staged);
+      staged->Delete();
+      }
+    }
+
+  // points
+  vtkPointSet *ps = dynamic_cast<vtkPointSet*>(copy);
+  if (ps && ps->GetPoints())
+    {
+    vtkDataArray *data = pool->Copy(ps->GetPoints()->GetData());
+
+    vtkPoints *pts = vtkPoints::New();
+    pts->SetData(data);
+    data->Delete();
+
+    ps->SetPoints(pts);
+    pts->Delete();
+    }
+
+  // cells
+  if (vtkUnstructuredGrid *ug = dynamic_cast<vtkUnstructuredGrid*>(copy))
+    {
+    if (ug->GetCells())
+      {
+      vtkUnsignedCharArray *types = static_cast<vtkUnsignedCharArray*>(
+        pool->Copy(ug->GetCellTypesArray()));
+
+      vtkIdTypeArray *locs = static_cast<vtkIdTypeArray*>(
+        pool->Copy(ug->GetCellLocationsArray()));
+
+      vtkCellArray *cells = stageCells(ug->GetCells(), pool);
+
+      ug->SetCells(types, locs, cells);
+
+      types->Delete();
+      locs->Delete();
+      cells->Delete();
+      }
+    }
+  else if (vtkPolyData *pd = dynamic_cast<vtkPolyData*>(copy))
+    {
+    vtkCellArray *cells = nullptr;
+    if (pd->GetVerts())
+      {
+      cells = stageCells(pd->GetVerts(), pool);
+      pd->SetVerts(cells);
+      cells->Delete();
+      }
+    if (pd->GetLines())
+      {
+      cells = stageCells(pd->GetLines(), pool);
+      pd->SetLines(cells);
+      cells->Delete();
+      }
+    if (pd->GetPolys())
+      {
+      cells = stageCells(pd->GetPolys(), pool);
+      pd->SetPolys(cells);
+      cells->Delete();
+      }
+    if (pd->GetStrips())
+      {
+      cells = stageCells(pd->GetStrips(), pool);
+      pd->SetStrips(cells);
+      cells->Delete();
+      }
+    }
+
+  return copy;
+}
+
+// --------------------------------------------------------------------------
+// returns a snapshot of the data object, see stageDataSet
+vtkDataObject *stageDataObject(vtkDataObject *dobj, StagingPool *pool)
+{
+  if (vtkCompositeDataSet *cd = dynamic_cast<vtkCompositeDataSet*>(dobj))
+    {
+    // copy the tree then replace the leaves
+    vtkCompositeDataSet *copy = cd->NewInstance();
+    copy->ShallowCopy(cd);
+
+    vtkSmartPointer<vtkCompositeDataIterator> it;
+    it.TakeReference(copy->NewIterator());
+
+    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+      {
+      if (vtkDataSet *ds = dynamic_cast<vtkDataSet*>(it->GetCurrentDataObject()))
+        {
+        vtkDataSet *staged = stageDataSet(ds, pool);
+        copy->SetDataSet(it, staged);
+        staged->Delete();
+        }
+      }
+
+    return copy;
+    }
+  else if (vtkDataSet *ds = dynamic_cast<vtkDataSet*>(dobj))
+    {
+    return stageDataSet(ds, pool);
+    }
+
+  SENSEI_ERROR("Can't snapshot a " << dobj->GetClassName())
+  return nullptr;
+}
+
+}
+
 namespace sensei
 {
 
+// a background thread that writes snapshots of the data in the order
+// they are submitted
+struct ADIOSAnalysisAdaptor::AsyncWriter
+{
+  // the data of one step
+  struct Step
+  {
+    Step() : TimeStep(0), Time(0.0) {}
+    ~Step() { this->Release(); }
+
+    void Release()
+    {
+      for (size_t i = 0; i < this->Objects.size(); ++i)
+        this->Objects[i]->Delete();
+      this->Objects.clear();
+      this->ObjectNames.clear();
+    }
+
+    unsigned long TimeStep;
+    double Time;
+    std::vector<std::string> ObjectNames;
+    std::vector<vtkDataObject*> Objects;
+    StagingPool Pool;
+  };
+
+  AsyncWriter() : Comm(MPI_COMM_NULL), Stop(false), Error(0) {}
+
+  // returns a step to fill in, waiting while depth steps are in flight
+  Step *Acquire(size_t depth);
+
+  // queues a step for writing
+  void Submit(Step *step);
+
+  // returns a step that was not submitted
+  void Discard(Step *step);
+
+  // returns and clears the error flag
+  int TakeError();
+
+  // writes queued steps until stopped
+  void Run(ADIOSAnalysisAdaptor *adaptor);
+
+  // waits for the queued steps to be written and stops the thread
+  void Finish();
+
+  // the writer's collective calls are made on a private communicator
+  // so that they can't be matched with those made by the analyses on
+  // the main thread
+  MPI_Comm Comm;
+  std::thread Thread;
+  std::mutex Mutex;
+  std::condition_variable Changed;
+  std::vector<std::unique_ptr<Step>> Steps;
+  std::deque<Step*> Pending;
+  std::vector<Step*> Free;
+  bool Stop;
+  int Error;
+};
+
+//----------------------------------------------------------------------------
+ADIOSAnalysisAdaptor::AsyncWriter::Step *
+ADIOSAnalysisAdaptor::AsyncWriter::Acquire(size_t depth)
+{
+  timer::MarkEvent mark("ADIOSAnalysisAdaptor::Wait");
+
+  std::unique_lock<std::mutex> lock(this->Mutex);
+
+  // apply back pressure, the step being written counts as in flight
+  this->Changed.wait(lock,
+    [this,depth]{ return this->Pending.size() < depth; });
+
+  if (this->Free.empty())
+    {
+    this->Steps.emplace_back(new Step);
+    return this->Steps.back().get();
+    }
+
+  Step *step = this->Free.back();
+  this->Free.pop_back();
+
+  return step;
+}
+
+//----------------------------------------------------------------------------
+void ADIOSAnalysisAdaptor::AsyncWriter::Submit(Step *step)
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->Pending.push_back(step);
+  this->Changed.notify_all();
+}
+
+//----------------------------------------------------------------------------
+void ADIOSAnalysisAdaptor::AsyncWriter::Discard(Step *step)
+{
+  step->Release();
+
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->Free.push_back(step);
+}
+
+//----------------------------------------------------------------------------
+int ADIOSAnalysisAdaptor::AsyncWriter::TakeError()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  int error = this->Error;
+  this->Error = 0;
+  return error;
+}
+
+//----------------------------------------------------------------------------
+void ADIOSAnalysisAdaptor::AsyncWriter::Finish()
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  this->Stop = true;
+  this->Changed.notify_all();
+  lock.unlock();
+
+  this->Thread.join();
+}
+
+//----------------------------------------------------------------------------
+void ADIOSAnalysisAdaptor::AsyncWriter::Run(ADIOSAnalysisAdaptor *adaptor)
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  while (true)
+    {
+    this->Changed.wait(lock,
+      [this]{ return this->Stop || !this->Pending.empty(); });
+
+    // stopped and drained
+    if (this->Pending.empty())
+      break;
+
+    // the step stays queued while it is written so that it is counted
+    // as in flight
+    Step *step = this->Pending.front();
+    lock.unlock();
+
+    int ierr = adaptor->WriteTimestep(this->Comm, step->TimeStep,
+      step->Time, step->ObjectNames, step->Objects);
+
+    // release the snapshot but keep the staging buffers
+    step->Release();
+
+    lock.lock();
+    if (ierr)
+      this->Error = 1;
+    this->Pending.pop_front();
+    this->Free.push_back(step);
+    this->Changed.notify_all();
+    }
+}
+
 //----------------------------------------------------------------------------
 senseiNewMacro(ADIOSAnalysisAdaptor);
 
 //----------------------------------------------------------------------------
 ADIOSAnalysisAdaptor::ADIOSAnalysisAdaptor() : MaxBufferSize(500),
-    Schema(nullptr), Method("MPI"), FileName("sensei.bp")
+    Schema(nullptr), Method("MPI"), FileName("sensei.bp"), AsyncDepth(0),
+    ZeroCopy(0), Writer(nullptr)
 {
 }
 
 //----------------------------------------------------------------------------
 ADIOSAnalysisAdaptor::~ADIOSAnalysisAdaptor()
 {
+  this->FinalizeWriter();
 }
 
 //-----------------------------------------------------------------------------
@@ -57,6 +417,62 @@ int ADIOSAnalysisAdaptor::SetDataRequirements(const DataRequirements &reqs)
   return 0;
 }
 
+//-----------------------------------------------------------------------------
+int ADIOSAnalysisAdaptor::SetCompression(int association,
+  const std::string &arrayName, const std::string &stages, double tolerance)
+{
+  std::map<std::string, int> stageIds;
+  stageIds["quantize"] = senseiADIOS::COMPRESSION_QUANTIZE;
+  stageIds["shuffle"] = senseiADIOS::COMPRESSION_SHUFFLE;
+  stageIds["lz"] = senseiADIOS::COMPRESSION_LZ;
+
+  if ((association != vtkDataObject::POINT) &&
+    (association != vtkDataObject::CELL))
+    {
+    SENSEI_ERROR("Compression applies to point and cell data arrays")
+    return -1;
+    }
+
+  // the stages are separated by commas and may be padded with spaces
+  int stageMask = senseiADIOS::COMPRESSION_NONE;
+  std::istringstream iss(stages);
+  std::string stage;
+  while (std::getline(iss, stage, ','))
+    {
+    stage.erase(0, stage.find_first_not_of(" \t"));
+    stage.erase(stage.find_last_not_of(" \t") + 1);
+    if (stage.empty())
+      continue;
+
+    std::map<std::string, int>::iterator it = stageIds.find(stage);
+    if (it == stageIds.end())
+      {
+      SENSEI_ERROR("Unsupported compression stage requested \""
+        << stage << "\"")
+      return -1;
+      }
+
+    stageMask |= it->second;
+    }
+
+  if ((stageMask & senseiADIOS::COMPRESSION_QUANTIZE) && !(tolerance > 0.0))
+    {
+    SENSEI_ERROR("Quantization of \"" << arrayName << "\" requires a "
+      "positive tolerance")
+    return -1;
+    }
+
+  Compression comp;
+  comp.Association = association;
+  comp.ArrayName = arrayName;
+  comp.Stages = stageMask;
+  comp.Tolerance = tolerance;
+
+  this->Compressions.push_back(comp);
+
+  return 0;
+}
+
 //-----------------------------------------------------------------------------
 int ADIOSAnalysisAdaptor::AddDataRequirement(const std::string &meshName,
   int association, const std::vector<std::string> &arrays)
@@ -161,13 +577,118 @@ bool ADIOSAnalysisAdaptor::Execute(DataAdaptor* dataAdaptor)
   unsigned long timeStep = dataAdaptor->GetDataTimeStep();
   double time = dataAdaptor->GetDataTime();
 
-  if (this->InitializeADIOS(objectNames, objects) ||
-    this->WriteTimestep(timeStep, time, objectNames, objects))
+  if (this->InitializeADIOS(objectNames, objects))
     return false;
 
+  if (this->AsyncDepth > 0)
+    {
+    if (this->SubmitTimestep(timeStep, time, objectNames, objects))
+      return false;
+    }
+  else
+    {
+    timer::MarkEvent mark("ADIOSAnalysisAdaptor::WriteTimestep");
+    if (this->WriteTimestep(this->GetCommunicator(), timeStep, time,
+      objectNames, objects))
+      return false;
+    }
+
+  // in asynchronous mode these are the steps written so far
+  this->ReportCompression();
+
   return true;
 }
 
+//----------------------------------------------------------------------------
+int ADIOSAnalysisAdaptor::SubmitTimestep(unsigned long timeStep,
+  double time, const std::vector<std::string> &objectNames,
+  const std::vector<vtkDataObject*> &objects)
+{
+  if (!this->Writer)
+    {
+    // the writer makes collective calls concurrently with the simulation
+    int provided = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&provided);
+    if (provided < MPI_THREAD_MULTIPLE)
+      {
+      SENSEI_WARNING("Asynchronous writes require MPI_THREAD_MULTIPLE. "
+        "Writes will be synchronous")
+      this->AsyncDepth = 0;
+      timer::MarkEvent mark("ADIOSAnalysisAdaptor::WriteTimestep");
+      return this->WriteTimestep(this->GetCommunicator(), timeStep, time,
+        objectNames, objects);
+      }
+
+    this->Writer = new AsyncWriter;
+    MPI_Comm_dup(this->GetCommunicator(), &this->Writer->Comm);
+    this->Writer->Thread = std::thread(&AsyncWriter::Run, this->Writer, this);
+    }
+
+  AsyncWriter::Step *step = this->Writer->Acquire(this->AsyncDepth);
+
+  // report a failure of an earlier step
+  int error = this->Writer->TakeError();
+  if (error)
+    {
+    SENSEI_ERROR("Failed to write a previous step to \""
+      << this->FileName << "\"")
+    }
+
+  timer::MarkEvent mark("ADIOSAnalysisAdaptor::Snapshot");
+
+  step->TimeStep = timeStep;
+  step->Time = time;
+  step->ObjectNames = objectNames;
+  step->Pool.Reset();
+
+  StagingPool *pool = this->ZeroCopy ? nullptr : &step->Pool;
+
+  size_t n_objects = objects.size();
+  for (size_t i = 0; i < n_objects; ++i)
+    {
+    vtkDataObject *copy = stageDataObject(objects[i], pool);
+    if (!copy)
+      {
+      SENSEI_ERROR("Failed to snapshot \"" << objectNames[i] << "\"")
+      this->Writer->Discard(step);
+      return -1;
+      }
+    step->Objects.push_back(copy);
+    }
+
+  this->Writer->Submit(step);
+
+  return error ? -1 : 0;
+}
+
+//----------------------------------------------------------------------------
+int ADIOSAnalysisAdaptor::FinalizeWriter()
+{
+  if (!this->Writer)
+    return 0;
+
+  timer::MarkEvent mark("ADIOSAnalysisAdaptor::FinalizeWriter");
+
+  this->Writer->Finish();
+
+  MPI_Comm_free(&this->Writer->Comm);
+
+  this->ReportCompression();
+
+  int error = this->Writer->TakeError();
+
+  delete this->Writer;
+  this->Writer = nullptr;
+
+  if (error)
+    {
+    SENSEI_ERROR("Failed to write a step to \"" << this->FileName << "\"")
+    return -1;
+    }
+
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 int ADIOSAnalysisAdaptor::InitializeADIOS(
   const std::vector<std::string> &objectNames,
@@ -196,6 +717,17 @@ int ADIOSAnalysisAdaptor::InitializeADIOS(
     // define ADIOS variables
     this->Schema = new senseiADIOS::DataObjectCollectionSchema;
 
+    size_t n_comps = this->Compressions.size();
+    for (size_t i = 0; i < n_comps; ++i)
+      {
+      senseiADIOS::CompressionSpec spec;
+      spec.Stages = this->Compressions[i].Stages;
+      spec.Tolerance = this->Compressions[i].Tolerance;
+
+      this->Schema->SetCompression(this->Compressions[i].Association,
+        this->Compressions[i].ArrayName, spec);
+      }
+
     if (this->Schema->DefineVariables(this->GetCommunicator(), gHandle, objectNames, objects))
       {
       SENSEI_ERROR("Failed to define variables")
@@ -205,6 +737,24 @@ int ADIOSAnalysisAdaptor::InitializeADIOS(
   return 0;
 }
 
+//----------------------------------------------------------------------------
+void ADIOSAnalysisAdaptor::ReportCompression()
+{
+  if (!this->Schema)
+    return;
+
+  senseiADIOS::CompressionStatistics stats;
+  this->Schema->TakeCompressionStatistics(stats);
+  if (!stats.RawBytes)
+    return;
+
+  timer::MarkValue("ADIOSAnalysisAdaptor::CompressionRatio",
+    double(stats.RawBytes)/std::max<uint64_t>(stats.CompressedBytes, 1), "x");
+
+  timer::MarkValue("ADIOSAnalysisAdaptor::CompressionThroughput",
+    stats.RawBytes/1048576.0/std::max(stats.Time, 1.0e-9), "MB/s");
+}
+
 //----------------------------------------------------------------------------
 int ADIOSAnalysisAdaptor::FinalizeADIOS()
 {
@@ -219,34 +769,45 @@ int ADIOSAnalysisAdaptor::Finalize()
 {
   timer::MarkEvent mark("ADIOSAnalysisAdaptor::Finalize");
 
+  // complete the writes in flight
+  int ierr = this->FinalizeWriter();
+
   if (this->Schema)
     this->FinalizeADIOS();
 
   delete this->Schema;
   this->Schema = nullptr;
 
-  return 0;
+  return ierr;
 }
 
 //----------------------------------------------------------------------------
-int ADIOSAnalysisAdaptor::WriteTimestep(unsigned long timeStep,
-  double time, const std::vector<std::string> &objectNames,
+int ADIOSAnalysisAdaptor::WriteTimestep(MPI_Comm comm,
+  unsigned long timeStep, double time,
+  const std::vector<std::string> &objectNames,
   const std::vector<vtkDataObject*> &objects)
 {
-  timer::MarkEvent mark("ADIOSAnalysisAdaptor::WriteTimestep");
+  // in asynchronous mode this is called from the writer thread, where
+  // the timer can't be used and comm is the writer's
+
+  // the size is found before the file is opened so that nothing is
+  // left open when it fails
+  uint64_t group_size = this->Schema->GetSize(comm, objectNames, objects);
+
+  if (group_size == static_cast<uint64_t>(-1))
+    {
+    SENSEI_ERROR("Failed to get the size of step " << timeStep)
+    return -1;
+    }
 
   int64_t handle = 0;
 
   adios_open(&handle, "sensei", this->FileName.c_str(),
-    timeStep == 0 ? "w" : "a", this->GetCommunicator());
-
-  uint64_t group_size = this->Schema->GetSize(
-    this->GetCommunicator(), objectNames, objects);
+    timeStep == 0 ? "w" : "a", comm);
 
   adios_group_size(handle, group_size, &group_size);
 
-  if (this->Schema->Write(this->GetCommunicator(), handle,
-    timeStep, time, objectNames, objects))
+  if (this->Schema->Write(comm, handle, timeStep, time, objectNames, objects))
     {
     SENSEI_ERROR("Failed to write step " << timeStep
       << " to \"" << this->FileName << "\"")
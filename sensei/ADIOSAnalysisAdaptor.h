@@ -52,6 +52,39 @@ public:
   std::string GetFileName() const
   { return this->FileName; }
 
+  /// @brief Write in the background.
+  ///
+  /// When depth is greater than 0, Execute takes a snapshot of the data
+  /// and returns while a background thread writes the snapshots in
+  /// order. At most depth steps are in flight, when there are more
+  /// Execute waits for the oldest to be written. This requires MPI to
+  /// have been initialized with MPI_THREAD_MULTIPLE, otherwise writes
+  /// are made synchronously. The default is 0, synchronous writes.
+  void SetAsynchronous(int depth)
+  { this->AsyncDepth = depth; }
+
+  /// @brief Share the simulation's arrays with the snapshot.
+  ///
+  /// By default a snapshot copies the arrays into staging buffers that
+  /// are reused from step to step, so that the simulation may modify
+  /// its data once Execute returns. When the simulation leaves its
+  /// arrays unmodified until they have been written the copy may be
+  /// skipped. The default is 0.
+  void SetZeroCopy(int val)
+  { this->ZeroCopy = val; }
+
+  /// @brief Compress a point or cell data array as it is written.
+  ///
+  /// stages is a comma separated list of "quantize", "shuffle", and
+  /// "lz", which are applied in that order. quantize is lossy, it applies
+  /// to float and double arrays and keeps the values within tolerance of
+  /// the originals. The others are lossless. When arrayName is empty the
+  /// stages apply to the arrays of the association that have none of
+  /// their own. Takes affect on first Execute. The compression ratio and
+  /// throughput are reported in the timer log.
+  int SetCompression(int association, const std::string &arrayName,
+    const std::string &stages, double tolerance);
+
   /// data requirements tell the adaptor what to push
   /// if none are given then all data is pushed.
   int SetDataRequirements(const DataRequirements &reqs);
@@ -71,19 +104,46 @@ protected:
   int InitializeADIOS(const std::vector<std::string> &objectNames,
     const std::vector<vtkDataObject*> &objects);
 
-  // writes the data collection
-  int WriteTimestep(unsigned long timeStep, double time,
+  // writes the data collection. all collective calls are made on comm
+  int WriteTimestep(MPI_Comm comm, unsigned long timeStep, double time,
     const std::vector<std::string> &objectNames,
     const std::vector<vtkDataObject*> &dobjects);
 
+  // snapshots the data collection and queues it for the writer thread
+  int SubmitTimestep(unsigned long timeStep, double time,
+    const std::vector<std::string> &objectNames,
+    const std::vector<vtkDataObject*> &dobjects);
+
+  // waits for queued steps to be written, stops the writer thread and
+  // frees its communicator
+  int FinalizeWriter();
+
   // shuts down ADIOS
   int FinalizeADIOS();
 
+  // logs the ratio and throughput of the arrays compressed since the
+  // last report
+  void ReportCompression();
+
   unsigned int MaxBufferSize;
   senseiADIOS::DataObjectCollectionSchema *Schema;
   sensei::DataRequirements Requirements;
   std::string Method;
   std::string FileName;
+  int AsyncDepth;
+  int ZeroCopy;
+
+  struct Compression
+  {
+    int Association;
+    std::string ArrayName;
+    int Stages;
+    double Tolerance;
+  };
+  std::vector<Compression> Compressions;
+
+  struct AsyncWriter;
+  AsyncWriter *Writer;
 
 
 private:
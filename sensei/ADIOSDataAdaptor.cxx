@@ -15,6 +15,7 @@
 #include <vtkDataSet.h>
 
 #include <sstream>
+#include <thread>
 
 namespace sensei
 {
@@ -46,14 +47,65 @@ static bool good(ObjectMapType &objMap, const ObjectMapIterType &it)
   return objMap.end() != it;
 }
 
+// returns true if all of the local datasets have the named array
+static bool hasArray(vtkDataObject *dobj, int association,
+  const std::string &arrayName)
+{
+  if (vtkCompositeDataSet *cd = vtkCompositeDataSet::SafeDownCast(dobj))
+    {
+    vtkCompositeDataIterator *iter = cd->NewIterator();
+    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
+      {
+      if (!hasArray(iter->GetCurrentDataObject(), association, arrayName))
+        {
+        iter->Delete();
+        return false;
+        }
+      }
+    iter->Delete();
+    return true;
+    }
+  else if (vtkDataSet *ds = dynamic_cast<vtkDataSet*>(dobj))
+    {
+    return ds->GetAttributes(association)->GetArray(arrayName.c_str());
+    }
+  return false;
+}
+
+// a time step read ahead of the current one
+struct ReadAheadStep
+{
+  ReadAheadStep() : Error(0), EndOfStream(0), Complete(0),
+    TimeStep(0), Time(0.0) {}
+
+  int Error;
+  int EndOfStream;
+  int Complete;
+  unsigned long TimeStep;
+  double Time;
+  std::vector<std::string> ObjectNames;
+  ObjectMapType ObjectMap;
+};
+
 
 struct ADIOSDataAdaptor::InternalsType
 {
-  InternalsType() : Stream() {}
+  InternalsType() : Comm(MPI_COMM_NULL), Stream(), ReadAhead(0),
+    ReadAheadBudget(0) {}
 
+  // when reading ahead the stream is opened, and read, on a duplicate of
+  // the communicator so that the collective calls made by the helper
+  // thread can't be matched with the analysis'
+  MPI_Comm Comm;
   senseiADIOS::InputStream Stream;
   senseiADIOS::DataObjectCollectionSchema Schema;
   ObjectMapType ObjectMap;
+
+  int ReadAhead;
+  unsigned long ReadAheadBudget;
+  DataRequirements Requirements;
+  std::thread Reader;
+  ReadAheadStep Next;
 };
 
 
@@ -69,9 +121,87 @@ ADIOSDataAdaptor::ADIOSDataAdaptor() : Internals(nullptr)
 //----------------------------------------------------------------------------
 ADIOSDataAdaptor::~ADIOSDataAdaptor()
 {
+  if (this->Internals->Reader.joinable())
+    this->Internals->Reader.join();
+
+  if (this->Internals->Comm != MPI_COMM_NULL)
+    MPI_Comm_free(&this->Internals->Comm);
+
   delete this->Internals;
 }
 
+//----------------------------------------------------------------------------
+void ADIOSDataAdaptor::SetReadAhead(int val)
+{
+  if (val)
+    {
+    // the helper thread reads from the stream while the analysis may be
+    // making MPI calls of its own
+    int threadLevel = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&threadLevel);
+    if (threadLevel < MPI_THREAD_MULTIPLE)
+      {
+      SENSEI_WARNING("Reading ahead requires MPI_THREAD_MULTIPLE. "
+        "Data will be read on demand")
+      val = 0;
+      }
+    else if (this->Internals->Stream.File &&
+      (this->Internals->Comm == MPI_COMM_NULL))
+      {
+      SENSEI_WARNING("Reading ahead must be enabled before Open. "
+        "Data will be read on demand")
+      val = 0;
+      }
+    }
+
+  this->Internals->ReadAhead = val;
+}
+
+//----------------------------------------------------------------------------
+void ADIOSDataAdaptor::SetReadAheadBudget(unsigned long budget)
+{
+  this->Internals->ReadAheadBudget = budget;
+}
+
+//----------------------------------------------------------------------------
+int ADIOSDataAdaptor::SetBlockAssignment(const std::string &method)
+{
+  std::map<std::string, int> assignments;
+  assignments["contiguous"] = senseiADIOS::BLOCK_ASSIGNMENT_CONTIGUOUS;
+  assignments["round_robin"] = senseiADIOS::BLOCK_ASSIGNMENT_ROUND_ROBIN;
+  assignments["balanced"] = senseiADIOS::BLOCK_ASSIGNMENT_BALANCED;
+
+  std::map<std::string, int>::iterator it = assignments.find(method);
+  if (it == assignments.end())
+    {
+    SENSEI_ERROR("Unsupported block assignment requested \"" << method << "\"")
+    return -1;
+    }
+
+  this->Internals->Schema.SetBlockAssignment(it->second);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int ADIOSDataAdaptor::SetDataRequirements(const DataRequirements &reqs)
+{
+  this->Internals->Requirements = reqs;
+
+  // restrict the reads to the regions of interest
+  this->Internals->Schema.ClearRegionsOfInterest();
+
+  MeshRequirementsIterator mit = reqs.GetMeshRequirementsIterator();
+  for (; mit; ++mit)
+    {
+    double bounds[6] = {0.0};
+    if (!reqs.GetRegionOfInterest(mit.MeshName(), bounds))
+      this->Internals->Schema.SetRegionOfInterest(mit.MeshName(), bounds);
+    }
+
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 void ADIOSDataAdaptor::EnableDynamicMesh(const std::string &meshName, int val)
 {
@@ -111,7 +241,11 @@ int ADIOSDataAdaptor::Open(ADIOS_READ_METHOD method, const std::string& fileName
 {
   timer::MarkEvent mark("ADIOSDataAdaptor::Open");
 
-  if (this->Internals->Stream.Open(this->GetCommunicator(), method, fileName))
+  if (this->Internals->ReadAhead && (this->Internals->Comm == MPI_COMM_NULL))
+    MPI_Comm_dup(this->GetCommunicator(), &this->Internals->Comm);
+
+  if (this->Internals->Stream.Open(this->GetStreamCommunicator(),
+    method, fileName))
     {
     SENSEI_ERROR("Failed to open \"" << fileName << "\"")
     return -1;
@@ -124,14 +258,28 @@ int ADIOSDataAdaptor::Open(ADIOS_READ_METHOD method, const std::string& fileName
   return 0;
 }
 
+//----------------------------------------------------------------------------
+MPI_Comm ADIOSDataAdaptor::GetStreamCommunicator()
+{
+  return this->Internals->Comm != MPI_COMM_NULL ?
+    this->Internals->Comm : this->GetCommunicator();
+}
+
 //----------------------------------------------------------------------------
 int ADIOSDataAdaptor::Close()
 {
   timer::MarkEvent mark("ADIOSDataAdaptor::Close");
 
+  if (this->Internals->Reader.joinable())
+    this->Internals->Reader.join();
+
+  this->Internals->Next = ReadAheadStep();
   this->Internals->ObjectMap.clear();
   this->Internals->Stream.Close();
 
+  if (this->Internals->Comm != MPI_COMM_NULL)
+    MPI_Comm_free(&this->Internals->Comm);
+
   return 0;
 }
 
@@ -140,6 +288,9 @@ int ADIOSDataAdaptor::Advance()
 {
   timer::MarkEvent mark("ADIOSDataAdaptor::Advance");
 
+  if (this->Internals->ReadAhead)
+    return this->FinishReadAhead();
+
   if (this->Internals->Stream.AdvanceTimeStep())
     return -1;
 
@@ -158,7 +309,7 @@ int ADIOSDataAdaptor::UpdateTimeStep()
   unsigned long timeStep = 0;
   double time = 0.0;
 
-  if (this->Internals->Schema.ReadTimeStep(this->GetCommunicator(),
+  if (this->Internals->Schema.ReadTimeStep(this->GetStreamCommunicator(),
     this->Internals->Stream, timeStep, time))
     {
     SENSEI_ERROR("Failed to update time step")
@@ -170,7 +321,7 @@ int ADIOSDataAdaptor::UpdateTimeStep()
 
   // update the available meshes
   std::vector<std::string> names;
-  if (this->Internals->Schema.ReadObjectNames(this->GetCommunicator(),
+  if (this->Internals->Schema.ReadObjectNames(this->GetStreamCommunicator(),
     this->Internals->Stream, names))
     {
     SENSEI_ERROR("Failed to update object names")
@@ -245,9 +396,25 @@ int ADIOSDataAdaptor::GetMesh(const std::string &meshName,
     return 0;
     }
 
+  // a mesh that was read ahead is used when it has the requested
+  // geometry and topology
+  if (pmesh && this->Internals->ReadAhead &&
+    (structureOnly || !metadata.StructureOnly))
+    {
+    mesh = pmesh.GetPointer();
+    return 0;
+    }
+
+  // while the next step is read ahead the stream has moved on
+  if (this->Internals->Reader.joinable())
+    {
+    SENSEI_ERROR("Mesh \"" << meshName << "\" was not read ahead. "
+      "Add it to the data requirements")
+    return -1;
+    }
+
   // other wise we need to read the mesh at the current time step
-  if (this->Internals->Schema.ReadObject(this->GetCommunicator(),
-    this->Internals->Stream, meshName, mesh, structureOnly))
+  if (this->ReadMesh(meshName, structureOnly, mesh, metadata))
     {
     SENSEI_ERROR("Failed to read mesh \"" << meshName << "\"")
     return -1;
@@ -256,6 +423,20 @@ int ADIOSDataAdaptor::GetMesh(const std::string &meshName,
   // cache the mesh
   pmesh = mesh;
 
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int ADIOSDataAdaptor::ReadMesh(const std::string &meshName,
+  bool structureOnly, vtkDataObject *&mesh, MeshMetadata &metadata)
+{
+  if (this->Internals->Schema.ReadObject(this->GetStreamCommunicator(),
+    this->Internals->Stream, meshName, mesh, structureOnly))
+    {
+    SENSEI_ERROR("Failed to read mesh \"" << meshName << "\"")
+    return -1;
+    }
+
   // get the ghost layer metadata
   int nGhostCellLayers = 0;
   int nGhostNodeLayers = 0;
@@ -269,7 +450,7 @@ int ADIOSDataAdaptor::GetMesh(const std::string &meshName,
   // cell data arrays
   std::set<std::string> cellArrays;
 
-  if (this->Internals->Schema.ReadArrayNames(this->GetCommunicator(),
+  if (this->Internals->Schema.ReadArrayNames(this->GetStreamCommunicator(),
     this->Internals->Stream, meshName, mesh, vtkDataObject::CELL, cellArrays))
     {
     SENSEI_ERROR("Failed to read cell associated array names")
@@ -278,7 +459,7 @@ int ADIOSDataAdaptor::GetMesh(const std::string &meshName,
 
   // point data arrays
   std::set<std::string> pointArrays;
-  if (this->Internals->Schema.ReadArrayNames(this->GetCommunicator(),
+  if (this->Internals->Schema.ReadArrayNames(this->GetStreamCommunicator(),
     this->Internals->Stream, meshName, mesh, vtkDataObject::POINT, pointArrays))
     {
     SENSEI_ERROR("Failed to read point associated array names")
@@ -384,7 +565,20 @@ int ADIOSDataAdaptor::AddArray(vtkDataObject* mesh,
     return -1;
     }
 
-  if (this->Internals->Schema.ReadArray(this->GetCommunicator(),
+  // arrays that were read ahead are already on the mesh
+  if (this->Internals->ReadAhead && hasArray(mesh, association, arrayName))
+    return 0;
+
+  // while the next step is read ahead the stream has moved on
+  if (this->Internals->Reader.joinable())
+    {
+    SENSEI_ERROR(<< VTKUtils::GetAttributesName(association)
+      << " data array \"" << arrayName << "\" on mesh \"" << meshName
+      << "\" was not read ahead. Add it to the data requirements")
+    return -1;
+    }
+
+  if (this->Internals->Schema.ReadArray(this->GetStreamCommunicator(),
     this->Internals->Stream, meshName, mesh, association, arrayName))
     {
     SENSEI_ERROR("Failed to read " << VTKUtils::GetAttributesName(association)
@@ -395,6 +589,54 @@ int ADIOSDataAdaptor::AddArray(vtkDataObject* mesh,
   return 0;
 }
 
+//----------------------------------------------------------------------------
+int ADIOSDataAdaptor::AddArrays(vtkDataObject* mesh,
+  const std::string &meshName, int association,
+  const std::vector<std::string> &arrayNames)
+{
+  timer::MarkEvent mark("ADIOSDataAdaptor::AddArrays");
+
+  // the mesh should never be null. there must have been an error
+  // upstream.
+  if (!mesh)
+    {
+    SENSEI_ERROR("Invalid mesh object")
+    return -1;
+    }
+
+  // arrays that were read ahead are already on the mesh
+  std::vector<std::string> missing;
+  unsigned int nArrays = arrayNames.size();
+  for (unsigned int i = 0; i < nArrays; ++i)
+    {
+    if (!this->Internals->ReadAhead ||
+      !hasArray(mesh, association, arrayNames[i]))
+      missing.push_back(arrayNames[i]);
+    }
+
+  if (missing.empty())
+    return 0;
+
+  // while the next step is read ahead the stream has moved on
+  if (this->Internals->Reader.joinable())
+    {
+    SENSEI_ERROR(<< VTKUtils::GetAttributesName(association)
+      << " data array \"" << missing[0] << "\" on mesh \"" << meshName
+      << "\" was not read ahead. Add it to the data requirements")
+    return -1;
+    }
+
+  if (this->Internals->Schema.ReadArrays(this->GetStreamCommunicator(),
+    this->Internals->Stream, meshName, mesh, association, missing))
+    {
+    SENSEI_ERROR("Failed to read " << VTKUtils::GetAttributesName(association)
+      << " data arrays from mesh \"" << meshName << "\"")
+    return -1;
+    }
+
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 int ADIOSDataAdaptor::GetNumberOfArrays(const std::string &meshName,
   int association, unsigned int &numberOfArrays)
@@ -498,6 +740,175 @@ int ADIOSDataAdaptor::ReleaseData()
       setObject(it, nullptr);
     }
 
+  // the analysis is done with the stream's current step, the next may
+  // be read
+  if (this->Internals->ReadAhead)
+    return this->StartReadAhead();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int ADIOSDataAdaptor::StartReadAhead()
+{
+  if (this->Internals->Reader.joinable() || this->Internals->Next.EndOfStream)
+    return 0;
+
+  this->Internals->Reader =
+    std::thread(&ADIOSDataAdaptor::ReadAheadTimeStep, this);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void ADIOSDataAdaptor::ReadAheadTimeStep()
+{
+  MPI_Comm comm = this->GetStreamCommunicator();
+  senseiADIOS::InputStream &stream = this->Internals->Stream;
+  senseiADIOS::DataObjectCollectionSchema &schema = this->Internals->Schema;
+
+  ReadAheadStep &step = this->Internals->Next;
+  step = ReadAheadStep();
+
+  if (stream.AdvanceTimeStep())
+    {
+    step.EndOfStream = 1;
+    return;
+    }
+
+  if (schema.ReadTimeStep(comm, stream, step.TimeStep, step.Time) ||
+    schema.ReadObjectNames(comm, stream, step.ObjectNames))
+    {
+    SENSEI_ERROR("Failed to read ahead the time step")
+    step.Error = 1;
+    return;
+    }
+
+  // the meshes to read and whether or not they are structure only. when
+  // no requirements are given all of the data is read
+  const DataRequirements &reqs = this->Internals->Requirements;
+
+  std::vector<std::pair<std::string, bool>> meshes;
+  if (reqs.Empty())
+    {
+    unsigned int nNames = step.ObjectNames.size();
+    for (unsigned int i = 0; i < nNames; ++i)
+      meshes.push_back(std::make_pair(step.ObjectNames[i], false));
+    }
+  else
+    {
+    MeshRequirementsIterator mit = reqs.GetMeshRequirementsIterator();
+    for (; mit; ++mit)
+      meshes.push_back(std::make_pair(mit.MeshName(), mit.StructureOnly()));
+    }
+
+  // the budget is in MB, sizes are tracked in kB
+  unsigned long budget = 1024*this->Internals->ReadAheadBudget;
+  unsigned long size = 0;
+
+  unsigned int nMeshes = meshes.size();
+  for (unsigned int i = 0; i < nMeshes; ++i)
+    {
+    const std::string &meshName = meshes[i].first;
+
+    if (budget && (size >= budget))
+      return;
+
+    ObjectType &obj = step.ObjectMap[meshName];
+    MeshMetadata &metadata = getMetadata(obj);
+    metadata.MeshName = meshName;
+
+    vtkDataObject *mesh = nullptr;
+    if (this->ReadMesh(meshName, meshes[i].second, mesh, metadata))
+      {
+      SENSEI_ERROR("Failed to read ahead mesh \"" << meshName << "\"")
+      step.Error = 1;
+      return;
+      }
+    setObject(obj, mesh);
+
+    int associations[] = {vtkDataObject::POINT, vtkDataObject::CELL};
+    for (int j = 0; j < 2; ++j)
+      {
+      int association = associations[j];
+
+      std::vector<std::string> arrays;
+      if (reqs.Empty())
+        arrays = metadata.GetArrayNames(association);
+      else
+        reqs.GetRequiredArrays(meshName, association, arrays);
+
+      if (arrays.empty())
+        continue;
+
+      if (budget && (size + mesh->GetActualMemorySize() >= budget))
+        return;
+
+      if (schema.ReadArrays(comm, stream, meshName, mesh, association, arrays))
+        {
+        SENSEI_ERROR("Failed to read ahead "
+          << VTKUtils::GetAttributesName(association)
+          << " data arrays on mesh \"" << meshName << "\"")
+        step.Error = 1;
+        return;
+        }
+      }
+
+    size += mesh->GetActualMemorySize();
+    }
+
+  step.Complete = 1;
+}
+
+//----------------------------------------------------------------------------
+int ADIOSDataAdaptor::FinishReadAhead()
+{
+  // the next step is read now if ReleaseData did not start it
+  if (this->StartReadAhead())
+    return -1;
+
+  if (this->Internals->Reader.joinable())
+    this->Internals->Reader.join();
+
+  ReadAheadStep &step = this->Internals->Next;
+  if (step.EndOfStream)
+    return -1;
+
+  if (step.Error)
+    {
+    SENSEI_ERROR("Failed to read ahead the next time step")
+    return -1;
+    }
+
+  this->SetDataTimeStep(step.TimeStep);
+  this->SetDataTime(step.Time);
+
+  // add new objects, preserving the metadata of the others
+  unsigned int nNames = step.ObjectNames.size();
+  for (unsigned int i = 0; i < nNames; ++i)
+    {
+    this->Internals->ObjectMap.insert(std::make_pair(step.ObjectNames[i],
+      ObjectType(vtkDataObjectPtr(), MeshMetadata(step.ObjectNames[i]))));
+    }
+
+  // make the meshes that were read current
+  ObjectMapIterType it = step.ObjectMap.begin();
+  ObjectMapIterType end = step.ObjectMap.end();
+  for (; it != end; ++it)
+    {
+    ObjectType &obj = this->Internals->ObjectMap[getObjectName(it)];
+    int staticMesh = getMetadata(obj).StaticMesh;
+    obj = it->second;
+    getMetadata(obj).StaticMesh = staticMesh;
+    }
+  step.ObjectMap.clear();
+
+  // when all of the required data was read the following step can be
+  // read while this one is analyzed, otherwise the stream is needed to
+  // read the rest of this step
+  if (step.Complete)
+    return this->StartReadAhead();
+
   return 0;
 }
 
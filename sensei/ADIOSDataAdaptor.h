@@ -2,6 +2,7 @@
 #define ADIOSDataAdaptor_h
 
 #include "DataAdaptor.h"
+#include "DataRequirements.h"
 
 #include <mpi.h>
 #include <adios.h>
@@ -13,6 +14,8 @@
 namespace sensei
 {
 
+struct MeshMetadata;
+
 class ADIOSDataAdaptor : public DataAdaptor
 {
 public:
@@ -34,6 +37,48 @@ public:
   // advance the stream to the next available time step
   int Advance();
 
+  /// @brief Read the next time step while the current one is analyzed.
+  ///
+  /// When enabled, after ReleaseData, or in Advance when the current step
+  /// was read ahead completely, a helper thread advances the stream and
+  /// reads the meshes and arrays named by the data requirements. Advance
+  /// waits for it and makes that step current. While a step is being
+  /// read ahead the stream is no longer at the current step and only the
+  /// data that was read ahead may be accessed. The stream is read on a
+  /// duplicate of the communicator so that the helper thread's collective
+  /// calls are kept apart from the analysis', for this read ahead must be
+  /// enabled before Open. This requires MPI to have been initialized with
+  /// MPI_THREAD_MULTIPLE, otherwise data is read on demand. The default
+  /// is 0, read on demand.
+  void SetReadAhead(int val);
+
+  /// @brief Limit the data read ahead, in MB per rank.
+  ///
+  /// Once the limit is reached the remaining meshes and arrays of the
+  /// step are read on demand once it is current, and the following step
+  /// is not read until ReleaseData. The limit is checked before each
+  /// mesh and each of its point and cell array groups is read, so the
+  /// data read ahead may exceed it by one mesh or one group of arrays.
+  /// The default is 0, no limit.
+  void SetReadAheadBudget(unsigned long budget);
+
+  /// @brief Set how the blocks written are assigned to the ranks reading.
+  ///
+  /// One of "contiguous", ranges of block ids, "round_robin", the ids
+  /// dealt out in turn, or "balanced", the blocks assigned largest first
+  /// to the rank with the fewest bytes. The number of ranks reading need
+  /// not match the number writing, each rank reads its blocks into a
+  /// composite dataset. The default is "contiguous".
+  int SetBlockAssignment(const std::string &method);
+
+  /// data requirements tell the adaptor what to read ahead
+  /// if none are given then all data is read ahead. requirements that
+  /// give no arrays, such as those holding only a region of interest,
+  /// also read all of the data ahead. when a mesh has a region of interest
+  /// only the blocks intersecting it are read, and image data blocks are
+  /// cropped to it, whether or not reading ahead.
+  int SetDataRequirements(const DataRequirements &reqs);
+
   /// @breif Gets the number of meshes a simulation can provide
   ///
   /// The caller passes a reference to an integer variable in the first
@@ -119,6 +164,22 @@ public:
   int AddArray(vtkDataObject* mesh, const std::string &meshName,
     int association, const std::string &arrayName) override;
 
+  /// @brief Adds the vector of field arrays to the mesh.
+  ///
+  /// The reads of all of the arrays, on all of the local blocks, are
+  /// scheduled and then made together rather than one by one.
+  ///
+  /// @param[in] mesh the VTK object returned from GetMesh
+  /// @param[in] meshName the name of the mesh on which the arrays are stored
+  /// @param[in] association field association; one of
+  ///            vtkDataObject::FieldAssociations or vtkDataObject::AttributeTypes.
+  /// @param[in] arrayNames a vector of array names to add
+  /// @returns zero if successful, non zero if an error occurred
+  int AddArrays(vtkDataObject* mesh, const std::string &meshName,
+    int association, const std::vector<std::string> &arrayNames) override;
+
+  using DataAdaptor::AddArrays;
+
   /// @brief Return the number of field arrays available.
   ///
   /// This method will return the number of field arrays available. For data
@@ -168,6 +229,24 @@ protected:
   int GetGhostLayers(const std::string &meshName,
       int &nGhostCellLayers, int &nGhostNodeLayers);
 
+  // reads the named mesh, and its metadata, at the stream's current step
+  int ReadMesh(const std::string &meshName, bool structureOnly,
+    vtkDataObject *&mesh, MeshMetadata &metadata);
+
+  // starts reading ahead the next step, unless it is already being read
+  int StartReadAhead();
+
+  // advances the stream and reads the required data into the read ahead
+  // step. this runs on the helper thread and must not use the timer
+  void ReadAheadTimeStep();
+
+  // waits for the step being read ahead and makes it current
+  int FinishReadAhead();
+
+  // the communicator the stream is read on. a duplicate when reading
+  // ahead
+  MPI_Comm GetStreamCommunicator();
+
 private:
   struct InternalsType;
   InternalsType *Internals;
@@ -1,4 +1,6 @@
 #include "ADIOSSchema.h"
+#include "CellLocationKernels.h"
+#include "CompressionKernels.h"
 #include "VTKUtils.h"
 #include "Error.h"
 
@@ -46,12 +48,20 @@
 #include <adios.h>
 #include <adios_read.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <vector>
 #include <map>
 #include <set>
 #include <string>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <tuple>
+#include <cstdio>
+#include <cstring>
 
 namespace senseiADIOS
 {
@@ -419,6 +429,31 @@ unsigned int getNumberOfDatasets(MPI_Comm comm, vtkDataObject *dobj,
 
 
 
+// --------------------------------------------------------------------------
+PathCache::PathList &PathCache::Define(unsigned int doid, unsigned int dsid)
+{
+  PathList &paths = this->Paths[KeyType(doid, dsid)];
+  paths.clear();
+  return paths;
+}
+
+// --------------------------------------------------------------------------
+const PathCache::PathList *PathCache::Find(unsigned int doid,
+  unsigned int dsid) const
+{
+  std::map<KeyType, PathList>::const_iterator it =
+    this->Paths.find(KeyType(doid, dsid));
+
+  if (it == this->Paths.end())
+    {
+    SENSEI_ERROR("No variables were defined for data object "
+      << doid << " dataset " << dsid)
+    return nullptr;
+    }
+
+  return &it->second;
+}
+
 // --------------------------------------------------------------------------
 int Schema::DefineVariables(MPI_Comm comm, int64_t gh, unsigned int doid,
   vtkDataObject *dobj)
@@ -580,11 +615,16 @@ public:
 
   static uint64_t GetSize(const std::string &str);
 
+  // returns the path of the length of the string at path
+  static std::string GetLengthPath(const std::string &path);
+
   static int Write(uint64_t fh, const std::string &path,
-    const std::string &str);
+    const std::string &len_path, const char *str);
 
-  static int Read(InputStream &iStream, ADIOS_SELECTION *sel,
-    const std::string &path, std::string &str);
+  // schedules the reads of the string at path. func is called with
+  // the string once it has been read
+  static int Read(InputStream &iStream, const std::string &path,
+    const std::function<int(const std::string&)> &func);
 };
 
 // --------------------------------------------------------------------------
@@ -593,13 +633,19 @@ uint64_t StringSchema::GetSize(const std::string &str)
   return str.size() + 1 + sizeof(int);
 }
 
+// --------------------------------------------------------------------------
+std::string StringSchema::GetLengthPath(const std::string &path)
+{
+  return path + "_len";
+}
+
 // --------------------------------------------------------------------------
 int StringSchema::DefineVariables(int64_t gh, const std::string &path)
 {
   // a second variable holding the local, global, length is required
   // for writing. according to trhe docs you could write a constant
   // string literal, but that only works with BP and not FLEXPATH
-  std::string len = path + "_len";
+  std::string len = StringSchema::GetLengthPath(path);
   adios_define_var(gh, len.c_str(), "", adios_integer,
     "", "", "0");
 
@@ -611,44 +657,43 @@ int StringSchema::DefineVariables(int64_t gh, const std::string &path)
 }
 
 // --------------------------------------------------------------------------
-int StringSchema::Read(InputStream &iStream, ADIOS_SELECTION *sel,
-  const std::string &path, std::string &result)
+int StringSchema::Read(InputStream &iStream, const std::string &path,
+  const std::function<int(const std::string&)> &func)
 {
-  // get metadata
-  ADIOS_VARINFO *vinfo = adios_inq_var(iStream.File, path.c_str());
-  if (!vinfo)
-    {
-    SENSEI_ERROR("ADIOS stream is missing \"" << path << "\"")
-    return -1;
-    }
+  // the length, which includes the terminator, is read first and then
+  // the string
+  std::shared_ptr<int> len = std::make_shared<int>(0);
 
-  // allocate a buffer
-  char *tmp = static_cast<char*>(malloc(vinfo->dims[0]));
+  iStream.Defer([&iStream, path, len, func]() -> int
+  {
+    if (*len < 0)
+      {
+      SENSEI_ERROR("Invalid length " << *len << " of string at \""
+        << path << "\"")
+      return -1;
+      }
+
+    std::shared_ptr<std::vector<char>> str =
+      std::make_shared<std::vector<char>>(*len + 1, '\0');
 
-  // read it
-  adios_schedule_read(iStream.File, sel, path.c_str(), 0, 1, tmp);
-  if (adios_perform_reads(iStream.File, 1))
+    iStream.Defer([str, func]() -> int
     {
-    SENSEI_ERROR("Failed to read string at \"" << path << "\"")
-    return -1;
-    }
+      return func(str->data());
+    });
 
-  // clean up and pass string back
-  adios_free_varinfo(vinfo);
-  result = tmp;
-  free(tmp);
+    return iStream.ScheduleRead(path, str->data());
+  });
 
-  return 0;
+  return iStream.ScheduleRead(StringSchema::GetLengthPath(path), len.get());
 }
 
 // --------------------------------------------------------------------------
 int StringSchema::Write(uint64_t fh, const std::string &path,
-  const std::string &str)
+  const std::string &len_path, const char *str)
 {
-  std::string len = path + "_len";
-  int n = str.size() + 1;
-  if (adios_write(fh, len.c_str(), &n) ||
-    adios_write(fh, path.c_str(), str.c_str()))
+  int n = strlen(str) + 1;
+  if (adios_write(fh, len_path.c_str(), &n) ||
+    adios_write(fh, path.c_str(), str))
     {
     SENSEI_ERROR("Failed to write string at \"" << path << "\"")
     return -1;
@@ -658,6 +703,18 @@ int StringSchema::Write(uint64_t fh, const std::string &path,
 
 
 
+// indices of the cached paths of image data
+enum
+{
+  EXTENT_LEN = 0,
+  EXTENT,
+  ORIGIN_LEN,
+  ORIGIN,
+  SPACING_LEN,
+  SPACING,
+  EXTENT_NUMBER_OF_PATHS
+};
+
 // --------------------------------------------------------------------------
 int Extent3DSchema::DefineVariables(int64_t gh, unsigned int doid,
   unsigned int dsid, vtkDataSet *ds)
@@ -669,29 +726,35 @@ int Extent3DSchema::DefineVariables(int64_t gh, unsigned int doid,
 
     std::string dataset_id = oss.str();
 
-    std::string path_len = dataset_id + "/extent_len";
-    adios_define_var(gh, path_len.c_str(), "", adios_integer, "", "", "");
+    PathCache::PathList &paths = this->Paths.Define(doid, dsid);
+    paths.resize(EXTENT_NUMBER_OF_PATHS);
+
+    paths[EXTENT_LEN] = dataset_id + "/extent_len";
+    adios_define_var(gh, paths[EXTENT_LEN].c_str(), "", adios_integer,
+      "", "", "");
 
     // /data_object_<id>/dataset_<id>/extent
-    std::string path = dataset_id + "/extent";
-    adios_define_var(gh, path.c_str(), "", adios_integer,
-      path_len.c_str(), path_len.c_str(), "0");
+    paths[EXTENT] = dataset_id + "/extent";
+    adios_define_var(gh, paths[EXTENT].c_str(), "", adios_integer,
+      paths[EXTENT_LEN].c_str(), paths[EXTENT_LEN].c_str(), "0");
 
-    path_len = dataset_id + "/origin_len";
-    adios_define_var(gh, path_len.c_str(), "", adios_integer, "", "", "");
+    paths[ORIGIN_LEN] = dataset_id + "/origin_len";
+    adios_define_var(gh, paths[ORIGIN_LEN].c_str(), "", adios_integer,
+      "", "", "");
 
     // /data_object_<id>/dataset_<id>/origin
-    path = dataset_id + "/origin";
-    adios_define_var(gh, path.c_str(), "", adios_double,
-      path_len.c_str(), path_len.c_str(), "0");
+    paths[ORIGIN] = dataset_id + "/origin";
+    adios_define_var(gh, paths[ORIGIN].c_str(), "", adios_double,
+      paths[ORIGIN_LEN].c_str(), paths[ORIGIN_LEN].c_str(), "0");
 
-    path_len = dataset_id + "/spacing_len";
-    adios_define_var(gh, path_len.c_str(), "", adios_integer, "", "", "");
+    paths[SPACING_LEN] = dataset_id + "/spacing_len";
+    adios_define_var(gh, paths[SPACING_LEN].c_str(), "", adios_integer,
+      "", "", "");
 
     // /data_object_<id>/dataset_<id>/spacing
-    path = dataset_id + "/spacing";
-    adios_define_var(gh, path.c_str(), "", adios_double,
-      path_len.c_str(), path_len.c_str(), "0");
+    paths[SPACING] = dataset_id + "/spacing";
+    adios_define_var(gh, paths[SPACING].c_str(), "", adios_double,
+      paths[SPACING_LEN].c_str(), paths[SPACING_LEN].c_str(), "0");
     }
   return 0;
 }
@@ -712,39 +775,33 @@ int Extent3DSchema::Write(int64_t fh, unsigned int doid, unsigned int dsid,
 {
   if (vtkImageData *img = dynamic_cast<vtkImageData*>(ds))
     {
-    std::ostringstream oss;
-    oss << "data_object_" << doid << "/dataset_" << dsid << "/";
-    std::string dataset_id = oss.str();
+    const PathCache::PathList *paths = this->Paths.Find(doid, dsid);
+    if (!paths)
+      return -1;
 
     // extent
     int extent_len = 6;
-    std::string path = dataset_id + "extent_len";
-    adios_write(fh, path.c_str(), &extent_len);
+    adios_write(fh, (*paths)[EXTENT_LEN].c_str(), &extent_len);
 
-    path = dataset_id + "extent";
     int extent[6] = {0};
     img->GetExtent(extent);
-    adios_write(fh, path.c_str(), extent);
+    adios_write(fh, (*paths)[EXTENT].c_str(), extent);
 
     // origin
     int origin_len = 3;
-    path = dataset_id + "origin_len";
-    adios_write(fh, path.c_str(), &origin_len);
+    adios_write(fh, (*paths)[ORIGIN_LEN].c_str(), &origin_len);
 
-    path = dataset_id + "origin";
     double origin[3] = {0.0};
     img->GetOrigin(origin);
-    adios_write(fh, path.c_str(), origin);
+    adios_write(fh, (*paths)[ORIGIN].c_str(), origin);
 
     // spacing
     int spacing_len = 3;
-    path = dataset_id + "spacing_len";
-    adios_write(fh, path.c_str(), &spacing_len);
+    adios_write(fh, (*paths)[SPACING_LEN].c_str(), &spacing_len);
 
-    path = dataset_id + "spacing";
     double spacing[3] = {0.0};
     img->GetSpacing(spacing);
-    adios_write(fh, path.c_str(), spacing);
+    adios_write(fh, (*paths)[SPACING].c_str(), spacing);
     }
   return 0;
 }
@@ -753,52 +810,46 @@ int Extent3DSchema::Write(int64_t fh, unsigned int doid, unsigned int dsid,
 int Extent3DSchema::Read(MPI_Comm comm, InputStream &iStream,
   unsigned int doid, unsigned int dsid, vtkDataSet *&ds)
 {
+  (void)comm;
+
   if (vtkImageData *img = dynamic_cast<vtkImageData*>(ds))
     {
     std::ostringstream oss;
     oss << "data_object_" << doid << "/dataset_" << dsid << "/";
     std::string dataset_id = oss.str();
 
-    ADIOS_SELECTION *sel = nullptr;
-    if (!streamIsFileBased(iStream.ReadMethod))
-      {
-      int rank = 0;
-      MPI_Comm_rank(comm, &rank);
-      sel = adios_selection_writeblock(rank);
-      if (!sel)
-        {
-        SENSEI_ERROR("Failed to make the selction")
-        return -1;
-        }
-      }
+    struct Geometry
+    {
+      int Extent[6];
+      double Origin[3];
+      double Spacing[3];
+    };
 
-    // extent
-    std::string path = dataset_id + "extent";
-    int extent[6] = {0};
-    adios_schedule_read(iStream.File, sel, path.c_str(), 0, 1, extent);
+    std::shared_ptr<Geometry> geom = std::make_shared<Geometry>();
 
-    // origin
-    path = dataset_id + "origin";
-    double origin[3] = {0.0};
-    adios_schedule_read(iStream.File, sel, path.c_str(), 0, 1, origin);
+    iStream.Defer([&iStream, img, geom, doid, dsid]() -> int
+    {
+      // crop to the region of interest
+      int sub_extent[6] = {0};
+      iStream.Region.Select(doid, dsid, geom->Extent, geom->Origin,
+        geom->Spacing, sub_extent);
+
+      img->SetExtent(sub_extent);
+      img->SetOrigin(geom->Origin);
+      img->SetSpacing(geom->Spacing);
+      return 0;
+    });
 
+    // extent
+    // origin
     // spacing
-    path = dataset_id + "spacing";
-    double spacing[3] = {0.0};
-    adios_schedule_read(iStream.File, sel, path.c_str(), 0, 1, spacing);
-
-    if (adios_perform_reads(iStream.File, 1))
+    if (iStream.ScheduleRead(dataset_id + "extent", geom->Extent) ||
+      iStream.ScheduleRead(dataset_id + "origin", geom->Origin) ||
+      iStream.ScheduleRead(dataset_id + "spacing", geom->Spacing))
       {
       SENSEI_ERROR("Failed to read extents")
       return -1;
       }
-
-    if (sel)
-      adios_selection_delete(sel);
-
-    img->SetExtent(extent);
-    img->SetOrigin(origin);
-    img->SetSpacing(spacing);
     }
   return 0;
 }
@@ -819,6 +870,420 @@ template<> struct datasetAttributeString<vtkDataObject::CELL>
   static std::string str(){ return "cell";  }
 };
 
+// indices of the cached paths of dataset attributes. the number of
+// arrays is followed by the paths of each array
+enum
+{
+  NUMBER_OF_ARRAYS = 0,
+  ARRAY_NAME = 0,
+  ARRAY_NAME_LEN,
+  ARRAY_NUMBER_OF_ELEMENTS,
+  ARRAY_NUMBER_OF_COMPONENTS,
+  ARRAY_ELEMENT_TYPE,
+  ARRAY_COMPRESSION,
+  ARRAY_COMPRESSED_SIZE,
+  ARRAY_COMPRESSED_DATA,
+  ARRAY_DATA,
+  ARRAY_NUMBER_OF_PATHS
+};
+
+// returns the index of the given path of array i
+inline
+size_t arrayPathId(int i, int path)
+{
+  return 1 + i*ARRAY_NUMBER_OF_PATHS + path;
+}
+
+using CompressionMapType = std::map<std::string, CompressionSpec>;
+
+// returns the compression of the named array, its own or the one given
+// for all arrays, or nullptr if it is written as is
+const CompressionSpec *findCompression(const CompressionMapType &comp,
+  const char *name)
+{
+  if (comp.empty())
+    return nullptr;
+
+  CompressionMapType::const_iterator it = comp.find(name ? name : "");
+  if (it == comp.end())
+    it = comp.find("");
+
+  if ((it == comp.end()) || (it->second.Stages == COMPRESSION_NONE))
+    return nullptr;
+
+  return &it->second;
+}
+
+// --------------------------------------------------------------------------
+// returns the largest number of bytes compressArray produces for n values
+// of size bytes
+uint64_t getCompressedBound(uint64_t n, uint64_t size)
+{
+  return sizeof(sensei::CompressionKernels::QuantizeHeader) +
+    sensei::CompressionKernels::LZBound(n*size);
+}
+
+// --------------------------------------------------------------------------
+// compresses the values of the array into buf, which is grown to hold
+// getCompressedBound bytes, and returns the number of bytes written in
+// n_bytes. the stages applied are returned in stages. quantization is
+// skipped for arrays that are not float or double and for values it
+// can't bound, shuffling for single byte values, and lz when it does not
+// reduce the size. when quantized, buf starts with the QuantizeHeader
+void compressArray(vtkDataArray *array, const CompressionSpec &spec,
+  std::vector<unsigned char> &buf, std::vector<unsigned char> (&work)[2],
+  uint64_t &n_bytes, int &stages)
+{
+  size_t n = array->GetNumberOfTuples()*array->GetNumberOfComponents();
+  size_t size = array->GetDataTypeSize();
+  const unsigned char *src =
+    static_cast<const unsigned char*>(array->GetVoidPointer(0));
+
+  size_t bound = getCompressedBound(n, size);
+  if (buf.size() < bound)
+    buf.resize(bound);
+
+  for (int i = 0; i < 2; ++i)
+    {
+    if (work[i].size() < n*size)
+      work[i].resize(n*size);
+    }
+
+  unsigned char *out = buf.data();
+  stages = COMPRESSION_NONE;
+
+  if (spec.Stages & COMPRESSION_QUANTIZE)
+    {
+    sensei::CompressionKernels::QuantizeHeader header;
+    int ierr = -1;
+    if (array->GetDataType() == VTK_FLOAT)
+      ierr = sensei::CompressionKernels::Quantize(
+        reinterpret_cast<const float*>(src), n, spec.Tolerance, header,
+        work[0].data());
+    else if (array->GetDataType() == VTK_DOUBLE)
+      ierr = sensei::CompressionKernels::Quantize(
+        reinterpret_cast<const double*>(src), n, spec.Tolerance, header,
+        work[0].data());
+
+    if (!ierr)
+      {
+      memcpy(out, &header, sizeof(header));
+      out += sizeof(header);
+      src = work[0].data();
+      size = header.CodeSize;
+      stages |= COMPRESSION_QUANTIZE;
+      }
+    }
+
+  if ((spec.Stages & COMPRESSION_SHUFFLE) && (size > 1))
+    {
+    sensei::CompressionKernels::Shuffle(src, n, size, work[1].data());
+    src = work[1].data();
+    stages |= COMPRESSION_SHUFFLE;
+    }
+
+  size_t n_values = n*size;
+  if (spec.Stages & COMPRESSION_LZ)
+    {
+    size_t n_lz = sensei::CompressionKernels::LZCompress(src, n_values, out);
+    if (n_lz < n_values)
+      {
+      out += n_lz;
+      stages |= COMPRESSION_LZ;
+      }
+    }
+
+  if (!(stages & COMPRESSION_LZ))
+    {
+    memcpy(out, src, n_values);
+    out += n_values;
+    }
+
+  n_bytes = out - buf.data();
+}
+
+// --------------------------------------------------------------------------
+// reverses compressArray, decoding the n_bytes of buf, compressed with the
+// given stages, into the n values of the array's type at out
+int decompressArray(const unsigned char *buf, uint64_t n_bytes, int stages,
+  int type, size_t n, void *out)
+{
+  vtkSmartPointer<vtkDataArray> tmp;
+  tmp.TakeReference(vtkDataArray::CreateDataArray(type));
+  if (!tmp)
+    return -1;
+  size_t size = tmp->GetDataTypeSize();
+
+  sensei::CompressionKernels::QuantizeHeader header;
+  if (stages & COMPRESSION_QUANTIZE)
+    {
+    if ((n_bytes < sizeof(header)) ||
+      ((type != VTK_FLOAT) && (type != VTK_DOUBLE)))
+      return -1;
+
+    memcpy(&header, buf, sizeof(header));
+    buf += sizeof(header);
+    n_bytes -= sizeof(header);
+
+    size = header.CodeSize;
+    if ((size != 1) && (size != 2) && (size != 4))
+      return -1;
+    }
+
+  size_t n_values = n*size;
+  std::vector<unsigned char> work[2];
+
+  // the codes, or the values when not quantized
+  unsigned char *dest = static_cast<unsigned char*>(out);
+  if (stages & COMPRESSION_QUANTIZE)
+    {
+    work[0].resize(n_values);
+    dest = work[0].data();
+    }
+
+  const unsigned char *src = buf;
+  if (stages & COMPRESSION_LZ)
+    {
+    unsigned char *lz_out = dest;
+    if (stages & COMPRESSION_SHUFFLE)
+      {
+      work[1].resize(n_values);
+      lz_out = work[1].data();
+      }
+    if (sensei::CompressionKernels::LZDecompress(src, n_bytes, lz_out,
+      n_values))
+      return -1;
+    src = lz_out;
+    }
+  else if (n_bytes != n_values)
+    {
+    return -1;
+    }
+
+  if (stages & COMPRESSION_SHUFFLE)
+    sensei::CompressionKernels::Unshuffle(src, n, size, dest);
+  else if (src != dest)
+    memcpy(dest, src, n_values);
+
+  if (stages & COMPRESSION_QUANTIZE)
+    {
+    if (type == VTK_FLOAT)
+      sensei::CompressionKernels::Dequantize(dest, n, header,
+        static_cast<float*>(out));
+    else
+      sensei::CompressionKernels::Dequantize(dest, n, header,
+        static_cast<double*>(out));
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+// computes the runs of contiguous tuples that make up the sub extent of
+// an image dataset's point or cell data. each run is given by the index
+// of its first tuple in the data of the whole extent and its length.
+// consecutive runs are merged
+void getRuns(const RegionOfInterest::Crop &crop, bool cell_data,
+  std::vector<std::pair<uint64_t, uint64_t>> &runs)
+{
+  int lo[3] = {0};
+  int len[3] = {0};
+  int sub_lo[3] = {0};
+  int sub_len[3] = {0};
+  for (int i = 0; i < 3; ++i)
+    {
+    int hi = crop.Extent[2*i+1];
+    int sub_hi = crop.SubExtent[2*i+1];
+
+    lo[i] = crop.Extent[2*i];
+    sub_lo[i] = crop.SubExtent[2*i];
+
+    // a flat direction has one layer of cells
+    if (cell_data)
+      {
+      hi = std::max(lo[i], hi - 1);
+      sub_hi = std::max(sub_lo[i], sub_hi - 1);
+      }
+
+    len[i] = hi - lo[i] + 1;
+    sub_len[i] = sub_hi - sub_lo[i] + 1;
+    }
+
+  for (int k = 0; k < sub_len[2]; ++k)
+    {
+    for (int j = 0; j < sub_len[1]; ++j)
+      {
+      uint64_t start = (static_cast<uint64_t>(sub_lo[2] - lo[2] + k)*len[1]
+        + sub_lo[1] - lo[1] + j)*len[0] + sub_lo[0] - lo[0];
+
+      if (!runs.empty() && (runs.back().first + runs.back().second == start))
+        runs.back().second += sub_len[0];
+      else
+        runs.push_back(std::make_pair(start, uint64_t(sub_len[0])));
+      }
+    }
+}
+
+// --------------------------------------------------------------------------
+// schedules the read of a compressed array stored at array_path and its
+// decoding into array. a compressed array is read whole, when runs are
+// given it is decoded into a temporary and the values of the tuples in
+// the runs are copied
+int readCompressedArray(InputStream &iStream, const std::string &array_path,
+  vtkDataArray *array, vtkIdType n_elem, int stages, uint64_t n_bytes,
+  const std::vector<std::pair<uint64_t, uint64_t>> &runs)
+{
+  std::shared_ptr<std::vector<unsigned char>> buf =
+    std::make_shared<std::vector<unsigned char>>(n_bytes);
+
+  vtkSmartPointer<vtkDataArray> dest = array;
+
+  iStream.Defer([buf, dest, n_elem, stages, runs, array_path]() -> int
+  {
+    int type = dest->GetDataType();
+
+    vtkSmartPointer<vtkDataArray> whole = dest;
+    if (!runs.empty())
+      {
+      whole.TakeReference(vtkDataArray::CreateDataArray(type));
+      whole->SetNumberOfComponents(dest->GetNumberOfComponents());
+      whole->SetNumberOfTuples(n_elem/dest->GetNumberOfComponents());
+      }
+
+    if (decompressArray(buf->data(), buf->size(), stages, type, n_elem,
+      whole->GetVoidPointer(0)))
+      {
+      SENSEI_ERROR("Failed to decompress \"" << array_path << "\"")
+      return -1;
+      }
+
+    if (!runs.empty())
+      {
+      // the tuples inside the region of interest
+      uint64_t tuple_size =
+        dest->GetNumberOfComponents()*dest->GetDataTypeSize();
+      const char *src = static_cast<const char*>(whole->GetVoidPointer(0));
+      char *out = static_cast<char*>(dest->GetVoidPointer(0));
+      size_t n_runs = runs.size();
+      for (size_t i = 0; i < n_runs; ++i)
+        {
+        memcpy(out, src + runs[i].first*tuple_size, runs[i].second*tuple_size);
+        out += runs[i].second*tuple_size;
+        }
+      }
+
+    return 0;
+  });
+
+  // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/compressed_data
+  return iStream.ScheduleRead(array_path + "/compressed_data", buf->data());
+}
+
+// --------------------------------------------------------------------------
+// schedules the reads of the array stored at array_path. the number and
+// type of its elements and its compression are read first and then the
+// data. the array is named and added to dsa once it has been read. when
+// a crop is given only the values of the tuples in its sub extent are
+// read
+int readArray(InputStream &iStream, const std::string &array_path,
+  const std::string &name, vtkDataSetAttributes *dsa,
+  const RegionOfInterest::Crop *crop, bool cell_data)
+{
+  struct Metadata
+  {
+    vtkIdType NumberOfElements;
+    int NumberOfComponents;
+    int ElementType;
+    int Compression;
+    unsigned long CompressedSize;
+  };
+
+  std::shared_ptr<Metadata> md = std::make_shared<Metadata>();
+
+  // the runs are computed now since the crop's record may change
+  // before the reads are made
+  std::vector<std::pair<uint64_t, uint64_t>> runs;
+  if (crop)
+    getRuns(*crop, cell_data, runs);
+
+  iStream.Defer([&iStream, md, array_path, name, dsa, runs]() -> int
+  {
+    vtkSmartPointer<vtkDataArray> array;
+    array.TakeReference(vtkDataArray::CreateDataArray(md->ElementType));
+    if (!array || (md->NumberOfComponents < 1))
+      {
+      SENSEI_ERROR("Invalid metadata for data array \"" << name << "\"")
+      return -1;
+      }
+
+    vtkIdType n_tuples = md->NumberOfElements/md->NumberOfComponents;
+    if (!runs.empty())
+      {
+      n_tuples = 0;
+      size_t n_runs = runs.size();
+      for (size_t i = 0; i < n_runs; ++i)
+        n_tuples += runs[i].second;
+      }
+
+    array->SetNumberOfComponents(md->NumberOfComponents);
+    array->SetNumberOfTuples(n_tuples);
+    array->SetName(name.c_str());
+
+    iStream.Defer([array, dsa]() -> int
+    {
+      dsa->AddArray(array);
+      return 0;
+    });
+
+    if (md->Compression != COMPRESSION_NONE)
+      return readCompressedArray(iStream, array_path, array,
+        md->NumberOfElements, md->Compression, md->CompressedSize, runs);
+
+    // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/data
+    if (runs.empty())
+      return iStream.ScheduleRead(array_path + "/data",
+        array->GetVoidPointer(0));
+
+    // the tuples inside the region of interest
+    uint64_t n_comps = md->NumberOfComponents;
+    uint64_t tuple_size = n_comps*array->GetDataTypeSize();
+    char *buf = static_cast<char*>(array->GetVoidPointer(0));
+    size_t n_runs = runs.size();
+    for (size_t i = 0; i < n_runs; ++i)
+      {
+      if (iStream.ScheduleRead(array_path + "/data", runs[i].first*n_comps,
+        runs[i].second*n_comps, buf))
+        return -1;
+      buf += runs[i].second*tuple_size;
+      }
+    return 0;
+  });
+
+  // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/number_of_elements
+  // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/number_of_components
+  // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/element_type
+  if (iStream.ScheduleRead(array_path + "/number_of_elements",
+      &md->NumberOfElements) ||
+    iStream.ScheduleRead(array_path + "/number_of_components",
+      &md->NumberOfComponents) ||
+    iStream.ScheduleRead(array_path + "/element_type", &md->ElementType))
+    return -1;
+
+  // streams written before revision 7 store the arrays uncompressed and
+  // have no compression variables
+  // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/compression
+  // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/compressed_size
+  md->Compression = COMPRESSION_NONE;
+  md->CompressedSize = 0;
+  if ((iStream.Revision >= 7) &&
+    (iStream.ScheduleRead(array_path + "/compression", &md->Compression) ||
+    iStream.ScheduleRead(array_path + "/compressed_size",
+      &md->CompressedSize)))
+    return -1;
+
+  return 0;
+}
+
 template<int att_t>
 struct DatasetAttributesSchema<att_t>::InternalsType
 {
@@ -826,6 +1291,19 @@ struct DatasetAttributesSchema<att_t>::InternalsType
   using NameIdMapType = std::map<std::string, IdMapType>;
   using MeshMapType = std::map<unsigned int, NameIdMapType>;
   MeshMapType NameIdMap;
+
+  // the compression of the arrays written, by array name
+  CompressionMapType Compression;
+
+  // the compressed arrays by data object, dataset, and array id. these
+  // are reused from step to step
+  using BufferKeyType = std::tuple<unsigned int, unsigned int, int>;
+  std::map<BufferKeyType, std::vector<unsigned char>> Buffers;
+  std::vector<unsigned char> Work[2];
+
+  // totals of the arrays compressed since they were last taken
+  std::mutex StatisticsMutex;
+  CompressionStatistics Statistics;
 };
 
 // --------------------------------------------------------------------------
@@ -857,12 +1335,18 @@ int DatasetAttributesSchema<att_t>::DefineVariables(int64_t gh,
 
     std::string att_path = dataset_id + att_type;
 
+    vtkDataSetAttributes* dsa = ds->GetAttributes(att_t);
+    int n_arrays = dsa->GetNumberOfArrays();
+
+    PathCache::PathList &paths = this->Paths.Define(doid, dsid);
+    paths.resize(arrayPathId(n_arrays, 0));
+
     // /data_object_<id>/dataset_<id>/<att_type>/number_of_arrays
-    std::string path = att_path + "number_of_arrays";
+    std::string &path = paths[NUMBER_OF_ARRAYS];
+    path = att_path + "number_of_arrays";
     adios_define_var(gh, path.c_str(), "", adios_integer, "", "", "");
 
-    vtkDataSetAttributes* dsa = ds->GetAttributes(att_t);
-    for (int i = 0, max = dsa->GetNumberOfArrays(); i < max; ++i)
+    for (int i = 0; i < n_arrays; ++i)
       {
       vtkDataArray* array = dsa->GetArray(i);
       oss.str("");
@@ -872,23 +1356,54 @@ int DatasetAttributesSchema<att_t>::DefineVariables(int64_t gh,
       std::string array_path = att_path + array_id;
 
       // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/name
-      StringSchema::DefineVariables(gh, array_path + "/name");
+      std::string &name_path = paths[arrayPathId(i, ARRAY_NAME)];
+      name_path = array_path + "/name";
+      StringSchema::DefineVariables(gh, name_path);
+
+      paths[arrayPathId(i, ARRAY_NAME_LEN)] =
+        StringSchema::GetLengthPath(name_path);
 
       // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/number_of_elements
-      std::string elem_path = array_path + "/number_of_elements";
+      std::string &elem_path = paths[arrayPathId(i, ARRAY_NUMBER_OF_ELEMENTS)];
+      elem_path = array_path + "/number_of_elements";
       adios_define_var(gh, elem_path.c_str(), "", adiosIdType(), "", "", "");
 
       // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/number_of_components
-      path = array_path + "/number_of_components";
-      adios_define_var(gh, path.c_str(), "", adios_integer, "", "", "");
+      std::string &comp_path = paths[arrayPathId(i, ARRAY_NUMBER_OF_COMPONENTS)];
+      comp_path = array_path + "/number_of_components";
+      adios_define_var(gh, comp_path.c_str(), "", adios_integer, "", "", "");
 
       // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/element_type
-      path = array_path + "/element_type";
-      adios_define_var(gh, path.c_str(), "", adios_integer, "", "", "");
+      std::string &type_path = paths[arrayPathId(i, ARRAY_ELEMENT_TYPE)];
+      type_path = array_path + "/element_type";
+      adios_define_var(gh, type_path.c_str(), "", adios_integer, "", "", "");
+
+      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/compression
+      std::string &cmp_path = paths[arrayPathId(i, ARRAY_COMPRESSION)];
+      cmp_path = array_path + "/compression";
+      adios_define_var(gh, cmp_path.c_str(), "", adios_integer, "", "", "");
+
+      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/compressed_size
+      std::string &csize_path = paths[arrayPathId(i, ARRAY_COMPRESSED_SIZE)];
+      csize_path = array_path + "/compressed_size";
+      adios_define_var(gh, csize_path.c_str(), "", adios_unsigned_long,
+        "", "", "");
+
+      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/compressed_data
+      // an array that is compressed is written here unless none of the
+      // stages apply, in which case it is written to data
+      if (findCompression(this->Internals->Compression, array->GetName()))
+        {
+        std::string &cdata_path = paths[arrayPathId(i, ARRAY_COMPRESSED_DATA)];
+        cdata_path = array_path + "/compressed_data";
+        adios_define_var(gh, cdata_path.c_str(), "", adios_unsigned_byte,
+          csize_path.c_str(), csize_path.c_str(), "0");
+        }
 
       // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/data
-      path = array_path + "/data";
-      adios_define_var(gh, path.c_str(), "", adiosType(array),
+      std::string &data_path = paths[arrayPathId(i, ARRAY_DATA)];
+      data_path = array_path + "/data";
+      adios_define_var(gh, data_path.c_str(), "", adiosType(array),
         elem_path.c_str(), elem_path.c_str(), "0");
       }
     }
@@ -905,19 +1420,26 @@ uint64_t DatasetAttributesSchema<att_t>::GetSize(vtkDataSet *ds)
     {
     vtkDataSetAttributes* dsa = ds->GetAttributes(att_t);
 
-    // per array offset and length
+    // per array offset, length, and compression
     int number_of_arrays = dsa->GetNumberOfArrays();
-    size = number_of_arrays*(2*sizeof(int) + sizeof(vtkIdType));
+    size = number_of_arrays*(3*sizeof(int) + sizeof(vtkIdType) +
+      sizeof(unsigned long));
 
-    // size of the arrays themselves
+    // size of the arrays themselves. compressed arrays are given the
+    // most they may take
     for (int i = 0; i < number_of_arrays; ++i)
       {
       vtkDataArray *da = dsa->GetArray(i);
 
       size += StringSchema::GetSize(da->GetName());
 
-      size += da->GetNumberOfTuples()*
-        da->GetNumberOfComponents()*da->GetElementComponentSize();
+      uint64_t n_elem = da->GetNumberOfTuples()*da->GetNumberOfComponents();
+      uint64_t elem_size = da->GetElementComponentSize();
+
+      if (findCompression(this->Internals->Compression, da->GetName()))
+        size += getCompressedBound(n_elem, elem_size);
+      else
+        size += n_elem*elem_size;
       }
     }
 
@@ -933,48 +1455,105 @@ int DatasetAttributesSchema<att_t>::Write(int64_t fh,
     {
     vtkDataSetAttributes* dsa = ds->GetAttributes(att_t);
 
-    std::ostringstream oss;
-    oss << "data_object_" << doid << "/dataset_" << dsid << "/";
-    std::string dataset_id = oss.str();
+    const PathCache::PathList *paths = this->Paths.Find(doid, dsid);
+    if (!paths)
+      return -1;
 
-    std::string att_type = datasetAttributeString<att_t>::str() + "_data/";
-    std::string att_path = dataset_id + att_type;
+    // the arrays must be those the variables were defined for
+    int n_arrays = dsa->GetNumberOfArrays();
+    if (arrayPathId(n_arrays, 0) != paths->size())
+      {
+      SENSEI_ERROR("Variables were defined for "
+        << (paths->size() - 1)/ARRAY_NUMBER_OF_PATHS << " "
+        << datasetAttributeString<att_t>::str() << " data arrays but data "
+        "object " << doid << " dataset " << dsid << " has " << n_arrays)
+      return -1;
+      }
 
     // /data_object_<id>/dataset_<id>/<att_type>/number_of_arrays
-    int n_arrays = dsa->GetNumberOfArrays();
-    std::string path = att_path + "number_of_arrays";
-    adios_write(fh, path.c_str(), &n_arrays);
+    adios_write(fh, (*paths)[NUMBER_OF_ARRAYS].c_str(), &n_arrays);
+
+    CompressionStatistics stats;
 
     for (int i = 0; i < n_arrays; ++i)
       {
       vtkDataArray* array = dsa->GetArray(i);
-      oss.str("");
-      oss << "array_" << i;
-
-      std::string array_id = oss.str();
-      std::string array_path = att_path + array_id;
 
       // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/name
-      StringSchema::Write(fh, array_path + "/name", array->GetName());
+      StringSchema::Write(fh, (*paths)[arrayPathId(i, ARRAY_NAME)],
+        (*paths)[arrayPathId(i, ARRAY_NAME_LEN)], array->GetName());
 
       // /data_objevct_<id>/dataset_<id>/<att_type>/array_<i>/number_of_elements
       vtkIdType n_elem = array->GetNumberOfTuples()*array->GetNumberOfComponents();
-      std::string elem_path = array_path + "/number_of_elements";
-      adios_write(fh, elem_path.c_str(), &n_elem);
+      adios_write(fh, (*paths)[arrayPathId(i, ARRAY_NUMBER_OF_ELEMENTS)].c_str(),
+        &n_elem);
 
       // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/number_of_components
-      path = array_path + "/number_of_components";
       int n_comp = array->GetNumberOfComponents();
-      adios_write(fh, path.c_str(), &n_comp);
+      adios_write(fh, (*paths)[arrayPathId(i, ARRAY_NUMBER_OF_COMPONENTS)].c_str(),
+        &n_comp);
 
       // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/element_type
-      path = array_path + "/element_type";
       int elem_type = array->GetDataType();
-      adios_write(fh, path.c_str(), &elem_type);
+      adios_write(fh, (*paths)[arrayPathId(i, ARRAY_ELEMENT_TYPE)].c_str(),
+        &elem_type);
+
+      // the array is compressed into a buffer that is kept until the
+      // next step
+      int stages = COMPRESSION_NONE;
+      uint64_t n_bytes = 0;
+      unsigned char *compressed_data = nullptr;
+
+      const CompressionSpec *spec =
+        findCompression(this->Internals->Compression, array->GetName());
+      if (spec)
+        {
+        std::chrono::high_resolution_clock::time_point t0 =
+          std::chrono::high_resolution_clock::now();
+
+        std::vector<unsigned char> &buf = this->Internals->Buffers[
+          typename InternalsType::BufferKeyType(doid, dsid, i)];
+
+        compressArray(array, *spec, buf, this->Internals->Work,
+          n_bytes, stages);
+
+        std::chrono::high_resolution_clock::time_point t1 =
+          std::chrono::high_resolution_clock::now();
 
-      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>
-      path = array_path + "/data";
-      adios_write(fh, path.c_str(), array->GetVoidPointer(0));
+        uint64_t raw_bytes = n_elem*array->GetDataTypeSize();
+        stats.RawBytes += raw_bytes;
+        stats.CompressedBytes += stages ? n_bytes : raw_bytes;
+        stats.Time += std::chrono::duration<double>(t1 - t0).count();
+
+        if (stages != COMPRESSION_NONE)
+          compressed_data = buf.data();
+        else
+          n_bytes = 0;
+        }
+
+      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/compression
+      adios_write(fh, (*paths)[arrayPathId(i, ARRAY_COMPRESSION)].c_str(),
+        &stages);
+
+      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/compressed_size
+      unsigned long compressed_size = n_bytes;
+      adios_write(fh, (*paths)[arrayPathId(i, ARRAY_COMPRESSED_SIZE)].c_str(),
+        &compressed_size);
+
+      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/compressed_data
+      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/data
+      if (stages != COMPRESSION_NONE)
+        adios_write(fh, (*paths)[arrayPathId(i, ARRAY_COMPRESSED_DATA)].c_str(),
+          compressed_data);
+      else
+        adios_write(fh, (*paths)[arrayPathId(i, ARRAY_DATA)].c_str(),
+          array->GetVoidPointer(0));
+      }
+
+    if (stats.RawBytes)
+      {
+      std::lock_guard<std::mutex> lock(this->Internals->StatisticsMutex);
+      this->Internals->Statistics.Add(stats);
       }
     }
 
@@ -986,6 +1565,8 @@ template<int att_t>
 int DatasetAttributesSchema<att_t>::Read(MPI_Comm comm, InputStream &iStream,
   unsigned int doid, unsigned int dsid, vtkDataSet *&ds)
 {
+  (void)comm;
+
   if (ds)
     {
     vtkDataSetAttributes* dsa = ds->GetAttributes(att_t);
@@ -997,79 +1578,33 @@ int DatasetAttributesSchema<att_t>::Read(MPI_Comm comm, InputStream &iStream,
     std::string att_type = datasetAttributeString<att_t>::str() + "_data/";
     std::string att_path = dataset_id + att_type;
 
-    // /data_object_<id>/dataset_<id>/<att_type>/number_of_arrays
-    int n_arrays = 0;
-    std::string path = att_path + "number_of_arrays";
-    if (adiosInq(iStream, att_path, n_arrays))
-      return -1;
+    // the number of arrays is read first, then their names, and then
+    // the arrays
+    std::shared_ptr<int> n_arrays = std::make_shared<int>(0);
 
-    ADIOS_SELECTION *sel = nullptr;
-    if (!streamIsFileBased(iStream.ReadMethod))
-      {
-      int rank = 0;
-      MPI_Comm_rank(comm, &rank);
-      sel = adios_selection_writeblock(rank);
-      if (!sel)
-        {
-        SENSEI_ERROR("Failed to make the selction")
-        return -1;
-        }
-      }
-
-    for (int i = 0; i < n_arrays; ++i)
-      {
-      oss.str("");
-      oss << "array_" << i;
-
-      std::string array_id = oss.str();
-      std::string array_path = att_path + array_id;
-
-      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/name
-      std::string name;
-      path = array_path + "/name";
-      if (StringSchema::Read(iStream, sel, path, name))
-        return -1;
-
-      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/number_of_elements
-      vtkIdType n_elem = 0;
-      path = array_path + "/number_of_elements";
-      if (adiosInq(iStream, path, n_elem))
-        return -1;
-
-      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/number_of_components
-      int n_comp = 0;
-      path = array_path + "/number_of_components";
-      if (adiosInq(iStream, path, n_comp))
-        return -1;
-
-      // /dataset_<id>/<att_type>/array_<i>/element_type
-      int elem_type = 0;
-      path = array_path + "/element_type";
-      if (adiosInq(iStream, path, elem_type))
-        return -1;
-
-      // /data_object_<id>//dataset_<id>/<att_type>/array_<i>/data
-      path = array_path + "/data";
-      vtkDataArray *array = vtkDataArray::CreateDataArray(elem_type);
-      array->SetNumberOfComponents(n_comp);
-      array->SetNumberOfTuples(n_elem/n_comp);
-      array->SetName(name.c_str());
-      adios_schedule_read(iStream.File, sel, path.c_str(),
-        0, 1, array->GetVoidPointer(0));
-      dsa->AddArray(array);
-      array->Delete();
-
-      if (adios_perform_reads(iStream.File, 1))
+    iStream.Defer([&iStream, n_arrays, att_path, dsa, doid, dsid]() -> int
+    {
+      for (int i = 0; i < *n_arrays; ++i)
         {
-        SENSEI_ERROR("Failed to read data for "
-          << datasetAttributeString<att_t>::str() << " data array \""
-          << array->GetName() << "\"")
-        return -1;
+        std::ostringstream oss;
+        oss << att_path << "array_" << i;
+        std::string array_path = oss.str();
+
+        // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/name
+        if (StringSchema::Read(iStream, array_path + "/name",
+          [&iStream, array_path, dsa, doid, dsid](const std::string &name) -> int
+          {
+            return readArray(iStream, array_path, name, dsa,
+              iStream.Region.Find(doid, dsid), att_t == vtkDataObject::CELL);
+          }))
+          return -1;
         }
+      return 0;
+    });
 
-      }
-    if (sel)
-      adios_selection_delete(sel);
+    // /data_object_<id>/dataset_<id>/<att_type>/number_of_arrays
+    if (iStream.ScheduleRead(att_path + "number_of_arrays", n_arrays.get()))
+      return -1;
     }
   return 0;
 }
@@ -1115,6 +1650,8 @@ int DatasetAttributesSchema<att_t>::ReadArrayNames(MPI_Comm comm,
   InputStream &iStream, unsigned int doid, unsigned int dsid, vtkDataSet *ds,
   std::set<std::string> &array_names)
 {
+  (void)comm;
+
   std::ostringstream oss;
   oss << "data_object_" << doid << "/dataset_" << dsid << "/";
   std::string dataset_id = oss.str();
@@ -1122,49 +1659,38 @@ int DatasetAttributesSchema<att_t>::ReadArrayNames(MPI_Comm comm,
   std::string att_type = datasetAttributeString<att_t>::str() + "_data/";
   std::string att_path = dataset_id + att_type;
 
-  // /data_object_<id>/dataset_<id>/<att_type>/number_of_arrays
-  int n_arrays = 0;
-  std::string path = att_path + "number_of_arrays";
-  if (adiosInq(iStream, path, n_arrays))
-    return -1;
+  // the number of arrays is read first and then their names
+  std::shared_ptr<int> n_arrays = std::make_shared<int>(0);
 
-  ADIOS_SELECTION *sel = nullptr;
-  if (!streamIsFileBased(iStream.ReadMethod))
-    {
-    int rank = 0;
-    MPI_Comm_rank(comm, &rank);
-    sel = adios_selection_writeblock(rank);
-    if (!sel)
+  iStream.Defer([this, &iStream, &array_names, n_arrays, att_path,
+    doid, dsid, ds]() -> int
+  {
+    for (int i = 0; i < *n_arrays; ++i)
       {
-      SENSEI_ERROR("Failed to make the selction")
-      return -1;
-      }
-    }
-
-  for (int i = 0; i < n_arrays; ++i)
-    {
-    oss.str("");
-    oss << "array_" << i;
-
-    std::string array_id = oss.str();
-    std::string array_path = att_path + array_id;
+      std::ostringstream oss;
+      oss << att_path << "array_" << i << "/name";
 
-    // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/name
-    std::string name;
-    path = array_path + "/name";
-    if (StringSchema::Read(iStream, sel, path, name))
-      return -1;
+      // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/name
+      if (StringSchema::Read(iStream, oss.str(),
+        [this, &array_names, doid, dsid, ds, i](const std::string &name) -> int
+        {
+          // add to list of arrays
+          array_names.insert(name);
 
-    // add to list of arrays
-    array_names.insert(name);
+          // cacahe the array id by block and name
+          if (ds)
+            this->Internals->NameIdMap[doid][name][dsid] = i;
 
-    // cacahe the array id by block and name
-    if (ds)
-      this->Internals->NameIdMap[doid][name][dsid] = i;
-    }
+          return 0;
+        }))
+        return -1;
+      }
+    return 0;
+  });
 
-  if (sel)
-    adios_selection_delete(sel);
+  // /data_object_<id>/dataset_<id>/<att_type>/number_of_arrays
+  if (iStream.ScheduleRead(att_path + "number_of_arrays", n_arrays.get()))
+    return -1;
 
   return 0;
 }
@@ -1188,11 +1714,13 @@ int DatasetAttributesSchema<att_t>::ReadArray(MPI_Comm comm,
 
 
   // may need to build the name map, if the user never called
-  // ReadArrayNames
+  // ReadArrayNames. the names are needed to schedule the reads of the
+  // arrays and are read now
   std::set<std::string> tmp;
   if (((this->Internals->NameIdMap.find(doid) == this->Internals->NameIdMap.end())
     || this->Internals->NameIdMap[doid].empty()) &&
-    this->ReadArrayNames(comm, iStream, doid, dobj, tmp))
+    (this->ReadArrayNames(comm, iStream, doid, dobj, tmp) ||
+    iStream.PerformReads()))
     return -1;
 
   // if the given object is a simple dataset then id is the MPI rank.
@@ -1257,59 +1785,13 @@ int DatasetAttributesSchema<att_t>::ReadArray(MPI_Comm comm,
       << datasetAttributeString<att_t>::str() << "_data/"
       << "array_" << array_id;
 
-    std::string array_path = oss.str();
-
-    // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/number_of_elements
-    vtkIdType n_elem = 0;
-    std::string path = array_path + "/number_of_elements";
-    if (adiosInq(iStream, path, n_elem))
-      return -1;
-
-    // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/number_of_components
-    int n_comp = 0;
-    path = array_path + "/number_of_components";
-    if (adiosInq(iStream, path, n_comp))
-      return -1;
-
-    // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/element_type
-    int elem_type = 0;
-    path = array_path + "/element_type";
-    if (adiosInq(iStream, path, elem_type))
-      return -1;
-
-    ADIOS_SELECTION *sel = nullptr;
-    if (!streamIsFileBased(iStream.ReadMethod))
-      {
-      int rank = 0;
-      MPI_Comm_rank(comm, &rank);
-      sel = adios_selection_writeblock(rank);
-      if (!sel)
-        {
-        SENSEI_ERROR("Failed to make the selction")
-        return -1;
-        }
-      }
-
-    // /data_object_<id>/dataset_<id>/<att_type>/array_<i>/data
-    path = array_path + "/data";
-    vtkDataArray *array = vtkDataArray::CreateDataArray(elem_type);
-    array->SetNumberOfComponents(n_comp);
-    array->SetNumberOfTuples(n_elem/n_comp);
-    array->SetName(array_name.c_str());
-    adios_schedule_read(iStream.File, sel, path.c_str(),
-      0, 1, array->GetVoidPointer(0));
-    dsa->AddArray(array);
-    array->Delete();
-
-    if (adios_perform_reads(iStream.File, 1))
+    if (readArray(iStream, oss.str(), array_name, dsa,
+      iStream.Region.Find(doid, dsid), att_t == vtkDataObject::CELL))
       {
       SENSEI_ERROR("Failed to read " << datasetAttributeString<att_t>::str()
         << " data array \"" << array_name << "\"")
       return -1;
       }
-
-    if (sel)
-      adios_selection_delete(sel);
     }
 
   return 0;
@@ -1317,6 +1799,35 @@ int DatasetAttributesSchema<att_t>::ReadArray(MPI_Comm comm,
 
 
 
+// --------------------------------------------------------------------------
+template<int att_t>
+void DatasetAttributesSchema<att_t>::SetCompression(
+  const std::string &array_name, const CompressionSpec &spec)
+{
+  this->Internals->Compression[array_name] = spec;
+}
+
+// --------------------------------------------------------------------------
+template<int att_t>
+void DatasetAttributesSchema<att_t>::TakeCompressionStatistics(
+  CompressionStatistics &stats)
+{
+  std::lock_guard<std::mutex> lock(this->Internals->StatisticsMutex);
+  stats.Add(this->Internals->Statistics);
+  this->Internals->Statistics = CompressionStatistics();
+}
+
+
+
+// indices of the cached paths of points
+enum
+{
+  POINTS_NUMBER_OF_ELEMENTS = 0,
+  POINTS_ELEM_TYPE,
+  POINTS_DATA,
+  POINTS_NUMBER_OF_PATHS
+};
+
 // --------------------------------------------------------------------------
 int PointsSchema::DefineVariables(int64_t gh, unsigned int doid,
   unsigned int dsid, vtkDataSet *ds)
@@ -1327,19 +1838,25 @@ int PointsSchema::DefineVariables(int64_t gh, unsigned int doid,
     oss << "data_object_" << doid << "/dataset_" << dsid << "/points/";
     std::string dataset_id = oss.str();
 
+    PathCache::PathList &paths = this->Paths.Define(doid, dsid);
+    paths.resize(POINTS_NUMBER_OF_PATHS);
+
     // /data_object_<id>/dataset_<id>/points/number_of_elements
-    std::string path_len = dataset_id + "number_of_elements";
+    std::string &path_len = paths[POINTS_NUMBER_OF_ELEMENTS];
+    path_len = dataset_id + "number_of_elements";
     adios_define_var(gh, path_len.c_str(), "", adios_unsigned_long, "", "", "");
 
     // /data_object_<id>/dataset_<id>/points/elem_type
-    std::string path = dataset_id + "elem_type";
+    std::string &path = paths[POINTS_ELEM_TYPE];
+    path = dataset_id + "elem_type";
     adios_define_var(gh, path.c_str(), "", adios_integer, "", "", "");
 
     // /data_object_<id>/dataset_<id>/points/data
     vtkDataArray *pts = ps->GetPoints()->GetData();
 
-    path = dataset_id + "data";
-    adios_define_var(gh, path.c_str(), "", adiosType(pts),
+    std::string &path_data = paths[POINTS_DATA];
+    path_data = dataset_id + "data";
+    adios_define_var(gh, path_data.c_str(), "", adiosType(pts),
       path_len.c_str(), path_len.c_str(), "0");
     }
   return 0;
@@ -1361,25 +1878,23 @@ int PointsSchema::Write(int64_t fh, unsigned int doid, unsigned int dsid,
 {
   if (vtkPointSet *ps = dynamic_cast<vtkPointSet*>(ds))
     {
-    std::ostringstream oss;
-    oss << "data_object_" << doid << "/dataset_" << dsid << "/points/";
-    std::string dataset_id = oss.str();
+    const PathCache::PathList *paths = this->Paths.Find(doid, dsid);
+    if (!paths)
+      return -1;
 
     // /data_object_<id>/dataset_<id>/points/number_of_elements
     unsigned long number_of_elements = 3*ds->GetNumberOfPoints();
-    std::string path = dataset_id + "number_of_elements";
-    adios_write(fh, path.c_str(), &number_of_elements);
+    adios_write(fh, (*paths)[POINTS_NUMBER_OF_ELEMENTS].c_str(),
+      &number_of_elements);
 
     vtkDataArray *pts = ps->GetPoints()->GetData();
 
     // /data_object_<id>/dataset_<id>/points/type
-    path = dataset_id + "elem_type";
     int points_type = pts->GetDataType();
-    adios_write(fh, path.c_str(), &points_type);
+    adios_write(fh, (*paths)[POINTS_ELEM_TYPE].c_str(), &points_type);
 
     // /data_object_<id>/dataset_<id>/points/data
-    path = dataset_id + "data";
-    adios_write(fh, path.c_str(), pts->GetVoidPointer(0));
+    adios_write(fh, (*paths)[POINTS_DATA].c_str(), pts->GetVoidPointer(0));
     }
   return 0;
 }
@@ -1388,62 +1903,61 @@ int PointsSchema::Write(int64_t fh, unsigned int doid, unsigned int dsid,
 int PointsSchema::Read(MPI_Comm comm, InputStream &iStream, unsigned int doid,
   unsigned int dsid, vtkDataSet *&ds)
 {
+  (void)comm;
+
   if (vtkPointSet *ps = dynamic_cast<vtkPointSet*>(ds))
     {
     std::ostringstream oss;
     oss << "data_object_" << doid << "/dataset_" << dsid << "/points/";
     std::string dataset_id = oss.str();
 
-    // /data_object_<id>/dataset_<id>/points/number_of_elements
-    unsigned long number_of_elements = 0;
-    std::string path = dataset_id + "number_of_elements";
-    if (adiosInq(iStream, path, number_of_elements))
-      return -1;
-
-    // /data_object_<id>/dataset_<id>/points/type
-    int elem_type = 0;
-    path = dataset_id + "elem_type";
-    if (adiosInq(iStream, path, elem_type))
-      return -1;
+    // the number and type of the elements are read first and then the
+    // points
+    struct Metadata
+    {
+      unsigned long NumberOfElements;
+      int ElemType;
+    };
 
-    // /data_object_<id>/dataset_<id>/points/data
-    vtkDataArray *pts = vtkDataArray::CreateDataArray(elem_type);
-    pts->SetNumberOfComponents(3);
-    pts->SetNumberOfTuples(number_of_elements/3);
-    pts->SetName("points");
+    std::shared_ptr<Metadata> md = std::make_shared<Metadata>();
 
-    ADIOS_SELECTION *sel = nullptr;
-    if (!streamIsFileBased(iStream.ReadMethod))
-      {
-      int rank = 0;
-      MPI_Comm_rank(comm, &rank);
-      sel = adios_selection_writeblock(rank);
-      if (!sel)
+    iStream.Defer([&iStream, md, dataset_id, ps]() -> int
+    {
+      vtkDataArray *pts = vtkDataArray::CreateDataArray(md->ElemType);
+      if (!pts)
         {
-        SENSEI_ERROR("Failed to make the selction")
+        SENSEI_ERROR("Invalid points type " << md->ElemType)
         return -1;
         }
-      }
 
-    path = dataset_id + "data";
-    adios_schedule_read(iStream.File, sel, path.c_str(),
-      0, 1, pts->GetVoidPointer(0));
+      pts->SetNumberOfComponents(3);
+      pts->SetNumberOfTuples(md->NumberOfElements/3);
+      pts->SetName("points");
+
+      // /data_object_<id>/dataset_<id>/points/data
+      int ierr = iStream.ScheduleRead(dataset_id + "data",
+        pts->GetVoidPointer(0));
 
-    if (adios_perform_reads(iStream.File, 1))
+      // the dataset holds the array while it is read
+      vtkPoints *points = vtkPoints::New();
+      points->SetData(pts);
+      pts->Delete();
+
+      ps->SetPoints(points);
+      points->Delete();
+
+      return ierr;
+    });
+
+    // /data_object_<id>/dataset_<id>/points/number_of_elements
+    // /data_object_<id>/dataset_<id>/points/type
+    if (iStream.ScheduleRead(dataset_id + "number_of_elements",
+        &md->NumberOfElements) ||
+      iStream.ScheduleRead(dataset_id + "elem_type", &md->ElemType))
       {
       SENSEI_ERROR("Failed to read points")
       return -1;
       }
-
-    if (sel)
-      adios_selection_delete(sel);
-
-    vtkPoints *points = vtkPoints::New();
-    points->SetData(pts);
-    pts->Delete();
-
-    ps->SetPoints(points);
-    points->Delete();
     }
   return 0;
 }
@@ -1482,6 +1996,52 @@ unsigned long PointsSchema::GetNumberOfPoints(vtkDataSet *ds)
 
 
 
+// indices of the cached paths of cells
+enum
+{
+  CELLS_NUMBER_OF_CELLS = 0,
+  CELLS_CELL_TYPES,
+  CELLS_NUMBER_OF_ELEMENTS,
+  CELLS_DATA,
+  CELLS_NUMBER_OF_LOCATIONS,
+  CELLS_LOCATIONS,
+  CELLS_NUMBER_OF_PATHS
+};
+
+// polydata's verts, lines, polys, and strips are each written as they
+// are stored in VTK. these are the indices of the paths of each, which
+// follow the paths of the cells
+enum
+{
+  POLY_NUMBER_OF_CELLS = 0,
+  POLY_NUMBER_OF_ELEMENTS,
+  POLY_DATA,
+  POLY_NUMBER_OF_PATHS
+};
+
+const char *polyCellsName[] = {"verts", "lines", "polys", "strips"};
+
+// returns the index of the given path of polydata cell array i
+inline
+size_t polyPathId(int i, int path)
+{
+  return CELLS_NUMBER_OF_PATHS + i*POLY_NUMBER_OF_PATHS + path;
+}
+
+// returns polydata cell array i
+inline
+vtkCellArray *getPolyCells(vtkPolyData *pd, int i)
+{
+  switch (i)
+    {
+    case 0: return pd->GetVerts();
+    case 1: return pd->GetLines();
+    case 2: return pd->GetPolys();
+    case 3: return pd->GetStrips();
+    }
+  return nullptr;
+}
+
 // --------------------------------------------------------------------------
 int CellsSchema::DefineVariables(int64_t gh, unsigned int doid,
   unsigned int dsid, vtkDataSet* ds)
@@ -1492,23 +2052,68 @@ int CellsSchema::DefineVariables(int64_t gh, unsigned int doid,
     oss << "data_object_" << doid << "/dataset_" << dsid << "/cells/";
     std::string dataset_id = oss.str();
 
+    PathCache::PathList &paths = this->Paths.Define(doid, dsid);
+    paths.resize(polyPathId(4, 0));
+
     // /data_object_<id>/dataset_<id>/cells/number_of_cells
-    std::string path_len = dataset_id + "number_of_cells";
-    adios_define_var(gh, path_len.c_str(), "", adios_unsigned_long, "", "", "");
+    std::string &path_cells = paths[CELLS_NUMBER_OF_CELLS];
+    path_cells = dataset_id + "number_of_cells";
+    adios_define_var(gh, path_cells.c_str(), "", adios_unsigned_long, "", "", "");
+
+    if (dynamic_cast<vtkPolyData*>(ds))
+      {
+      for (int i = 0; i < 4; ++i)
+        {
+        std::string cells_id = dataset_id + polyCellsName[i];
+
+        // /data_object_<id>/dataset_<id>/cells/number_of_<verts|lines|polys|strips>
+        std::string &path_n = paths[polyPathId(i, POLY_NUMBER_OF_CELLS)];
+        path_n = dataset_id + "number_of_" + polyCellsName[i];
+        adios_define_var(gh, path_n.c_str(), "", adios_unsigned_long,
+          "", "", "");
+
+        // /data_object_<id>/dataset_<id>/cells/<verts|lines|polys|strips>_number_of_elements
+        std::string &path_len = paths[polyPathId(i, POLY_NUMBER_OF_ELEMENTS)];
+        path_len = cells_id + "_number_of_elements";
+        adios_define_var(gh, path_len.c_str(), "", adios_unsigned_long,
+          "", "", "");
+
+        // /data_object_<id>/dataset_<id>/cells/<verts|lines|polys|strips>
+        std::string &path_data = paths[polyPathId(i, POLY_DATA)];
+        path_data = cells_id;
+        adios_define_var(gh, path_data.c_str(), "", adiosIdType(),
+          path_len.c_str(), path_len.c_str(), "0");
+        }
+      return 0;
+      }
 
     // /data_object_<id>/dataset_<id>/cells/cell_types
-    std::string path_array = dataset_id + "cell_types";
-    adios_define_var(gh, path_array.c_str(), "", adios_unsigned_byte,
-      path_len.c_str(), path_len.c_str(), "0");
+    std::string &path_types = paths[CELLS_CELL_TYPES];
+    path_types = dataset_id + "cell_types";
+    adios_define_var(gh, path_types.c_str(), "", adios_unsigned_byte,
+      path_cells.c_str(), path_cells.c_str(), "0");
 
     // /data_object_<id>/dataset_<id>/cells/number_of_cells
+    std::string &path_len = paths[CELLS_NUMBER_OF_ELEMENTS];
     path_len = dataset_id + "number_of_elements";
     adios_define_var(gh, path_len.c_str(), "", adios_unsigned_long, "", "", "");
 
     // /data_object_<id>/dataset_<id>/cells/data
-    path_array = dataset_id + "data";
-    adios_define_var(gh, path_array.c_str(), "", adiosIdType(),
+    std::string &path_data = paths[CELLS_DATA];
+    path_data = dataset_id + "data";
+    adios_define_var(gh, path_data.c_str(), "", adiosIdType(),
       path_len.c_str(), path_len.c_str(), "0");
+
+    // /data_object_<id>/dataset_<id>/cells/number_of_cell_locations
+    std::string &path_nlocs = paths[CELLS_NUMBER_OF_LOCATIONS];
+    path_nlocs = dataset_id + "number_of_cell_locations";
+    adios_define_var(gh, path_nlocs.c_str(), "", adios_unsigned_long, "", "", "");
+
+    // /data_object_<id>/dataset_<id>/cells/cell_locations
+    std::string &path_locs = paths[CELLS_LOCATIONS];
+    path_locs = dataset_id + "cell_locations";
+    adios_define_var(gh, path_locs.c_str(), "", adiosIdType(),
+      path_nlocs.c_str(), path_nlocs.c_str(), "0");
     }
 
   return 0;
@@ -1518,11 +2123,17 @@ int CellsSchema::DefineVariables(int64_t gh, unsigned int doid,
 uint64_t CellsSchema::GetSize(vtkDataSet *ds)
 {
   uint64_t size = 0;
-  if (dynamic_cast<vtkPolyData*>(ds) || dynamic_cast<vtkUnstructuredGrid*>(ds))
+  if (dynamic_cast<vtkPolyData*>(ds))
+    {
+    size += 9*sizeof(unsigned long) +                    // number_of_cells, and the sizes of the 4 arrays
+      this->GetCellsLength(ds)*sizeof(vtkIdType);        // verts, lines, polys, strips
+    }
+  else if (dynamic_cast<vtkUnstructuredGrid*>(ds))
     {
-    size += 2*sizeof(unsigned long) +                    // number_of_cells, number_of_elementss
+    size += 3*sizeof(unsigned long) +                    // number_of_cells, number_of_elements, number_of_cell_locations
       this->GetNumberOfCells(ds)*sizeof(unsigned char) + // cell types array
-      this->GetCellsLength(ds)*sizeof(vtkIdType);        // cells array
+      this->GetCellsLength(ds)*sizeof(vtkIdType) +       // cells array
+      this->GetNumberOfCells(ds)*sizeof(vtkIdType);      // cell locations array
     }
   return size;
 }
@@ -1536,87 +2147,118 @@ int CellsSchema::Write(int64_t fh, unsigned int doid, unsigned int dsid,
 
   if (pd || ug)
     {
-    std::ostringstream oss;
-    oss << "data_object_" << doid << "/dataset_" << dsid << "/cells/";
-    std::string dataset_id = oss.str();
+    const PathCache::PathList *paths = this->Paths.Find(doid, dsid);
+    if (!paths)
+      return -1;
 
     // /data_object_<id>/dataset_<id>/cells/number_of_cells
-    std::string path = dataset_id + "number_of_cells";
     unsigned long number_of_cells = ds->GetNumberOfCells();
-    adios_write(fh, path.c_str(), &number_of_cells);
+    adios_write(fh, (*paths)[CELLS_NUMBER_OF_CELLS].c_str(), &number_of_cells);
 
     if (ug)
       {
       // /data_object_<id>/dataset_<id>/cells/cell_types
-      path = dataset_id + "cell_types";
-      adios_write(fh, path.c_str(), ug->GetCellTypesArray()->GetPointer(0));
+      adios_write(fh, (*paths)[CELLS_CELL_TYPES].c_str(),
+        ug->GetCellTypesArray()->GetPointer(0));
 
       // /data_object_<id>/dataset_<id>/cells/number_of_elements
-      std::string path = dataset_id + "number_of_elements";
       unsigned long number_of_elements = ug->GetCells()->GetData()->GetNumberOfTuples();
-      adios_write(fh, path.c_str(), &number_of_elements);
+      adios_write(fh, (*paths)[CELLS_NUMBER_OF_ELEMENTS].c_str(),
+        &number_of_elements);
 
       // /data_object_<id>/dataset_<id>/cells/data
-      path = dataset_id + "data";
-      adios_write(fh, path.c_str(), ug->GetCells()->GetData()->GetPointer(0));
+      adios_write(fh, (*paths)[CELLS_DATA].c_str(),
+        ug->GetCells()->GetData()->GetPointer(0));
+
+      // the locations are written so that the reader need not rebuild them
+      // /data_object_<id>/dataset_<id>/cells/number_of_cell_locations
+      vtkIdTypeArray *locs = ug->GetCellLocationsArray();
+      unsigned long number_of_locations = locs ? number_of_cells : 0;
+      adios_write(fh, (*paths)[CELLS_NUMBER_OF_LOCATIONS].c_str(),
+        &number_of_locations);
+
+      // /data_object_<id>/dataset_<id>/cells/cell_locations
+      if (number_of_locations)
+        adios_write(fh, (*paths)[CELLS_LOCATIONS].c_str(),
+          locs->GetPointer(0));
       }
     else if (pd)
       {
-      // first move the polydata's various cell arrays into a single
-      // contiguous array. and build a cell types array. doing it this
-      // way simplifies the file format as we don't need to keep track
-      // of all 4 cells arrays.
-      std::vector<char> types;
-      std::vector<vtkIdType> cells;
-
-
-      vtkIdType nv = pd->GetNumberOfVerts();
-      if (nv)
+      // each of the cell arrays is written in place
+      for (int i = 0; i < 4; ++i)
         {
-        types.insert(types.end(), nv, VTK_VERTEX);
-        vtkIdType *pv = pd->GetVerts()->GetData()->GetPointer(0);
-        cells.insert(cells.end(), pv, pv + pd->GetVerts()->GetData()->GetNumberOfTuples());
+        vtkCellArray *ca = getPolyCells(pd, i);
+
+        // /data_object_<id>/dataset_<id>/cells/number_of_<verts|lines|polys|strips>
+        unsigned long n_cells = ca->GetNumberOfCells();
+        adios_write(fh, (*paths)[polyPathId(i, POLY_NUMBER_OF_CELLS)].c_str(),
+          &n_cells);
+
+        // /data_object_<id>/dataset_<id>/cells/<verts|lines|polys|strips>_number_of_elements
+        unsigned long n_elem = ca->GetData()->GetNumberOfTuples();
+        adios_write(fh, (*paths)[polyPathId(i, POLY_NUMBER_OF_ELEMENTS)].c_str(),
+          &n_elem);
+
+        // /data_object_<id>/dataset_<id>/cells/<verts|lines|polys|strips>
+        if (n_elem)
+          adios_write(fh, (*paths)[polyPathId(i, POLY_DATA)].c_str(),
+            ca->GetData()->GetPointer(0));
         }
+      }
+    }
 
-      vtkIdType nl = pd->GetNumberOfLines();
-      if (nl)
-        {
-        types.insert(types.end(), nl, VTK_LINE);
-        vtkIdType *pl = pd->GetLines()->GetData()->GetPointer(0);
-        cells.insert(cells.end(), pl, pl + pd->GetLines()->GetData()->GetNumberOfTuples());
-        }
+  return 0;
+}
 
-      vtkIdType np = pd->GetNumberOfPolys();
-      if (np)
-        {
-        types.insert(types.end(), np, VTK_POLYGON);
-        vtkIdType *pp = pd->GetPolys()->GetData()->GetPointer(0);
-        cells.insert(cells.end(), pp, pp + pd->GetPolys()->GetData()->GetNumberOfTuples());
-        }
+// --------------------------------------------------------------------------
+// passes the cell types, cells, and cell locations read from the stream to
+// the dataset. the arrays read are used directly. when the stream has no
+// locations, locs is empty and the locations are built here.
+int setCells(vtkUnstructuredGrid *ug, unsigned long number_of_cells,
+  vtkUnsignedCharArray *types, vtkIdTypeArray *cells, vtkIdTypeArray *locs)
+{
+  if (locs->GetNumberOfTuples() != static_cast<vtkIdType>(number_of_cells))
+    {
+    locs->SetNumberOfTuples(number_of_cells);
+    sensei::CellLocationKernels::BuildCellLocations(number_of_cells,
+      types->GetPointer(0), cells->GetPointer(0), locs->GetPointer(0));
+    }
 
-      vtkIdType ns = pd->GetNumberOfStrips();
-      if (ns)
-        {
-        types.insert(types.end(), ns, VTK_TRIANGLE_STRIP);
-        vtkIdType *ps = pd->GetStrips()->GetData()->GetPointer(0);
-        cells.insert(cells.end(), ps, ps + pd->GetStrips()->GetData()->GetNumberOfTuples());
-        }
+  // pass types, locs, and cells
+  vtkCellArray *ca = vtkCellArray::New();
+  ca->SetCells(number_of_cells, cells);
 
-      // /data_object_<id>/dataset_<id>/cells/cell_types
-      path = dataset_id + "cell_types";
-      adios_write(fh, path.c_str(), types.data());
+  ug->SetCells(types, locs, ca);
 
-      // /data_object_<id>/dataset_<id>/cells/number_of_elements
-      std::string path = dataset_id + "number_of_elements";
-      unsigned long number_of_elements = cells.size();
-      adios_write(fh, path.c_str(), &number_of_elements);
+  ca->Delete();
 
-      // /data_object_<id>/dataset_<id>/cells/data
-      path = dataset_id + "data";
-      adios_write(fh, path.c_str(), cells.data());
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+// passes the verts, lines, polys, and strips read from the stream to the
+// dataset. the arrays read are used directly
+int setCells(vtkPolyData *pd, const unsigned long number_of_cells[4],
+  vtkIdTypeArray *cells[4])
+{
+  for (int i = 0; i < 4; ++i)
+    {
+    vtkCellArray *ca = vtkCellArray::New();
+    ca->SetCells(number_of_cells[i], cells[i]);
+
+    switch (i)
+      {
+      case 0: pd->SetVerts(ca); break;
+      case 1: pd->SetLines(ca); break;
+      case 2: pd->SetPolys(ca); break;
+      case 3: pd->SetStrips(ca); break;
       }
+
+    ca->Delete();
     }
 
+  pd->BuildCells();
+
   return 0;
 }
 
@@ -1624,209 +2266,145 @@ int CellsSchema::Write(int64_t fh, unsigned int doid, unsigned int dsid,
 int CellsSchema::Read(MPI_Comm comm, InputStream &iStream, unsigned int doid,
   unsigned int dsid, vtkDataSet *&ds)
 {
-  vtkPolyData *pd = dynamic_cast<vtkPolyData*>(ds);
-  vtkUnstructuredGrid *ug = dynamic_cast<vtkUnstructuredGrid*>(ds);
+  (void)comm;
 
-  if (pd || ug)
+  if (vtkPolyData *pd = dynamic_cast<vtkPolyData*>(ds))
     {
     std::ostringstream oss;
     oss << "data_object_" << doid << "/dataset_" << dsid << "/cells/";
     std::string dataset_id = oss.str();
 
-    // /data_object_<id>/dataset_<id>/cells/number_of_cells
-    unsigned long number_of_cells = 0;
-    std::string path = dataset_id + "number_of_cells";
-    if (adiosInq(iStream, path, number_of_cells))
-      return -1;
-
-    // /data_object_<id>/dataset_<id>/cells/cell_types
-    path = dataset_id + "cell_types";
+    // the number of cells and the length of each of the cell arrays are
+    // read first and then the arrays
+    struct Metadata
+    {
+      unsigned long NumberOfCells[4];
+      unsigned long NumberOfElements[4];
+    };
 
-    vtkUnsignedCharArray *types = vtkUnsignedCharArray::New();
-    types->SetNumberOfTuples(number_of_cells);
+    std::shared_ptr<Metadata> md = std::make_shared<Metadata>();
 
-    ADIOS_SELECTION *sel = nullptr;
-    if (!streamIsFileBased(iStream.ReadMethod))
-      {
-      int rank = 0;
-      MPI_Comm_rank(comm, &rank);
-      sel = adios_selection_writeblock(rank);
-      if (!sel)
+    iStream.Defer([&iStream, md, dataset_id, pd]() -> int
+    {
+      std::vector<vtkSmartPointer<vtkIdTypeArray>> cells(4);
+      for (int i = 0; i < 4; ++i)
         {
-        SENSEI_ERROR("Failed to make the selction")
-        return -1;
+        cells[i] = vtkSmartPointer<vtkIdTypeArray>::New();
+        cells[i]->SetNumberOfTuples(md->NumberOfElements[i]);
         }
-      }
-
-    adios_schedule_read(iStream.File, sel, path.c_str(),
-      0, 1, types->GetVoidPointer(0));
-
-    // /data_object_<id>/dataset_<id>/cells/number_of_elements
-    unsigned long number_of_elements = 0;
-    path = dataset_id + "number_of_elements";
-    if (adiosInq(iStream, path, number_of_elements))
-      return -1;
 
-    // /data_object_<id>/dataset_<id>/cells/data
-    path = dataset_id + "data";
-    vtkIdTypeArray *cells = vtkIdTypeArray::New();
-    cells->SetNumberOfTuples(number_of_elements);
-
-    adios_schedule_read(iStream.File, sel, path.c_str(),
-      0, 1, cells->GetVoidPointer(0));
-
-    if (adios_perform_reads(iStream.File, 1))
-      {
-      SENSEI_ERROR("Failed to read cells")
-      return -1;
-      }
-
-    if (sel)
-      adios_selection_delete(sel);
-
-    if (ug)
-      {
-      // build locations
-      vtkIdTypeArray *locs = vtkIdTypeArray::New();
-      locs->SetNumberOfTuples(number_of_cells);
-      vtkIdType *p_locs = locs->GetPointer(0);
-      vtkIdType *p_cells = cells->GetPointer(0);
-      p_locs[0] = 0;
-      for (unsigned long i = 1; i < number_of_cells; ++i)
-        p_locs[i] = p_locs[i-1] + p_cells[p_locs[i-1]] + 1;
-
-      // pass types, locs, and cells
-      vtkCellArray *ca = vtkCellArray::New();
-      ca->SetCells(number_of_cells, cells);
-      cells->Delete();
-
-      ug->SetCells(types, locs, ca);
-
-      types->Delete();
-      locs->Delete();
-      ca->Delete();
-      }
-    else if (pd)
+      iStream.Defer([pd, md, cells]() -> int
       {
-      unsigned char *p_types = types->GetPointer(0);
-      vtkIdType *p_cells = cells->GetPointer(0);
-
-      // assumptions made here:
-      // data is serialized in the order verts, lines, polys, strips
-
-      // find first and last vert and number of verts
-      unsigned long i = 0;
-      unsigned long n_verts = 0;
-      vtkIdType *vert_begin = p_cells;
-      while ((i < number_of_cells) && (p_types[i] == VTK_VERTEX))
-        {
-        p_cells += p_cells[0] + 1;
-        ++n_verts;
-        ++i;
-        }
-      vtkIdType *vert_end = p_cells;
+        vtkIdTypeArray *ca[4] = {cells[0], cells[1], cells[2], cells[3]};
+        return setCells(pd, md->NumberOfCells, ca);
+      });
 
-      // find first and last line and number of lines
-      unsigned long n_lines = 0;
-      vtkIdType *line_begin = p_cells;
-      while ((i < number_of_cells) && (p_types[i] == VTK_LINE))
+      // /data_object_<id>/dataset_<id>/cells/<verts|lines|polys|strips>
+      for (int i = 0; i < 4; ++i)
         {
-        p_cells += p_cells[0] + 1;
-        ++n_lines;
-        ++i;
+        if (md->NumberOfElements[i] &&
+          iStream.ScheduleRead(dataset_id + polyCellsName[i],
+            cells[i]->GetVoidPointer(0)))
+          return -1;
         }
-      vtkIdType *line_end = p_cells;
 
-      // find first and last poly and number of polys
-      unsigned long n_polys = 0;
-      vtkIdType *poly_begin = p_cells;
-      while ((i < number_of_cells) && (p_types[i] == VTK_VERTEX))
-        {
-        p_cells += p_cells[0] + 1;
-        ++n_polys;
-        ++i;
-        }
-      vtkIdType *poly_end = p_cells;
+      return 0;
+    });
 
-      // find first and last strip and number of strips
-      unsigned long n_strips = 0;
-      vtkIdType *strip_begin = p_cells;
-      while ((i < number_of_cells) && (p_types[i] == VTK_VERTEX))
+    // /data_object_<id>/dataset_<id>/cells/number_of_<verts|lines|polys|strips>
+    // /data_object_<id>/dataset_<id>/cells/<verts|lines|polys|strips>_number_of_elements
+    for (int i = 0; i < 4; ++i)
+      {
+      if (iStream.ScheduleRead(dataset_id + "number_of_" + polyCellsName[i],
+          &md->NumberOfCells[i]) ||
+        iStream.ScheduleRead(dataset_id + polyCellsName[i] +
+          "_number_of_elements", &md->NumberOfElements[i]))
         {
-        p_cells += p_cells[0] + 1;
-        ++n_strips;
-        ++i;
+        SENSEI_ERROR("Failed to read " << polyCellsName[i])
+        return -1;
         }
-      vtkIdType *strip_end = p_cells;
-
-      // pass verts
-      unsigned long n_tups = vert_end - vert_begin;
-      vtkIdTypeArray *verts = vtkIdTypeArray::New();
-      verts->SetNumberOfTuples(n_tups);
-      vtkIdType *p_verts = verts->GetPointer(0);
-
-      for (unsigned long j = 0; j < n_tups; ++j)
-        p_verts[j] = vert_begin[j];
-
-      vtkCellArray *ca = vtkCellArray::New();
-      ca->SetCells(n_verts, verts);
-      verts->Delete();
-
-      pd->SetVerts(ca);
-      ca->Delete();
-
-      // pass lines
-      n_tups = line_end - line_begin;
-      vtkIdTypeArray *lines = vtkIdTypeArray::New();
-      lines->SetNumberOfTuples(n_tups);
-      vtkIdType *p_lines = lines->GetPointer(0);
-
-      for (unsigned long j = 0; j < n_tups; ++j)
-        p_lines[j] = line_begin[j];
-
-      ca = vtkCellArray::New();
-      ca->SetCells(n_lines, lines);
-      lines->Delete();
+      }
+    }
+  else if (vtkUnstructuredGrid *ug = dynamic_cast<vtkUnstructuredGrid*>(ds))
+    {
+    std::ostringstream oss;
+    oss << "data_object_" << doid << "/dataset_" << dsid << "/cells/";
+    std::string dataset_id = oss.str();
 
-      pd->SetLines(ca);
-      ca->Delete();
+    // the number of cells, the length of the cells array, and the number
+    // of cell locations are read first and then the cell types, cells, and
+    // cell locations
+    struct Metadata
+    {
+      unsigned long NumberOfCells;
+      unsigned long NumberOfElements;
+      unsigned long NumberOfLocations;
+    };
 
-      // pass polys
-      n_tups = poly_end - poly_begin;
-      vtkIdTypeArray *polys = vtkIdTypeArray::New();
-      polys->SetNumberOfTuples(n_tups);
-      vtkIdType *p_polys = polys->GetPointer(0);
+    std::shared_ptr<Metadata> md = std::make_shared<Metadata>();
 
-      for (unsigned long j = 0; j < n_tups; ++j)
-        p_polys[j] = poly_begin[j];
+    iStream.Defer([&iStream, md, dataset_id, ug]() -> int
+    {
+      vtkSmartPointer<vtkUnsignedCharArray> types =
+        vtkSmartPointer<vtkUnsignedCharArray>::New();
+      types->SetNumberOfTuples(md->NumberOfCells);
 
-      ca = vtkCellArray::New();
-      ca->SetCells(n_polys, polys);
-      polys->Delete();
+      vtkSmartPointer<vtkIdTypeArray> cells =
+        vtkSmartPointer<vtkIdTypeArray>::New();
+      cells->SetNumberOfTuples(md->NumberOfElements);
 
-      pd->SetPolys(ca);
-      ca->Delete();
+      vtkSmartPointer<vtkIdTypeArray> locs =
+        vtkSmartPointer<vtkIdTypeArray>::New();
 
-      // pass strips
-      n_tups = strip_end - strip_begin;
-      vtkIdTypeArray *strips = vtkIdTypeArray::New();
-      strips->SetNumberOfTuples(n_tups);
-      vtkIdType *p_strips = strips->GetPointer(0);
+      unsigned long number_of_cells = md->NumberOfCells;
+      iStream.Defer([ug, number_of_cells, types, cells, locs]() -> int
+      {
+        return setCells(ug, number_of_cells, types, cells, locs);
+      });
 
-      for (unsigned long j = 0; j < n_tups; ++j)
-        p_strips[j] = strip_begin[j];
+      // /data_object_<id>/dataset_<id>/cells/cell_types
+      // /data_object_<id>/dataset_<id>/cells/data
+      if (iStream.ScheduleRead(dataset_id + "cell_types",
+          types->GetVoidPointer(0)) ||
+        iStream.ScheduleRead(dataset_id + "data", cells->GetVoidPointer(0)))
+        return -1;
 
-      ca = vtkCellArray::New();
-      ca->SetCells(n_strips, strips);
-      strips->Delete();
+      // /data_object_<id>/dataset_<id>/cells/cell_locations
+      if (md->NumberOfLocations == number_of_cells && number_of_cells)
+        {
+        locs->SetNumberOfTuples(number_of_cells);
+        if (iStream.ScheduleRead(dataset_id + "cell_locations",
+            locs->GetVoidPointer(0)))
+          return -1;
+        }
 
-      pd->SetStrips(ca);
-      ca->Delete();
+      return 0;
+    });
 
-      pd->BuildCells();
+    // /data_object_<id>/dataset_<id>/cells/number_of_cells
+    // /data_object_<id>/dataset_<id>/cells/number_of_elements
+    if (iStream.ScheduleRead(dataset_id + "number_of_cells",
+        &md->NumberOfCells) ||
+      iStream.ScheduleRead(dataset_id + "number_of_elements",
+        &md->NumberOfElements))
+      {
+      SENSEI_ERROR("Failed to read cells")
+      return -1;
+      }
 
-      cells->Delete();
-      types->Delete();
+    // streams written before the cell locations were added have none,
+    // the locations are then built from the cells
+    // /data_object_<id>/dataset_<id>/cells/number_of_cell_locations
+    std::string nlocs_path = dataset_id + "number_of_cell_locations";
+    md->NumberOfLocations = 0;
+    if (ADIOS_VARINFO *vinfo = adios_inq_var(iStream.File, nlocs_path.c_str()))
+      {
+      adios_free_varinfo(vinfo);
+      if (iStream.ScheduleRead(nlocs_path, &md->NumberOfLocations))
+        {
+        SENSEI_ERROR("Failed to read cell locations")
+        return -1;
+        }
       }
     }
 
@@ -1910,6 +2488,40 @@ void DatasetSchema::SetDecomp(unsigned int id0, unsigned int id1)
     this->Internals->Decomp.insert(i);
 }
 
+// --------------------------------------------------------------------------
+void DatasetSchema::AddDecomp(unsigned int id)
+{
+  this->Internals->Decomp.insert(id);
+}
+
+// --------------------------------------------------------------------------
+uint64_t DatasetSchema::GetNumberOfBytes(vtkDataSet *ds)
+{
+  return this->Internals->Extent.GetSize(ds) +
+    this->Internals->Cells.GetSize(ds) +
+    this->Internals->Points.GetSize(ds) +
+    this->Internals->CellData.GetSize(ds) +
+    this->Internals->PointData.GetSize(ds) +
+    this->GetSize(ds);
+}
+
+// --------------------------------------------------------------------------
+void DatasetSchema::SetCompression(int association,
+  const std::string &array_name, const CompressionSpec &spec)
+{
+  if (association == vtkDataObject::POINT)
+    this->Internals->PointData.SetCompression(array_name, spec);
+  else
+    this->Internals->CellData.SetCompression(array_name, spec);
+}
+
+// --------------------------------------------------------------------------
+void DatasetSchema::TakeCompressionStatistics(CompressionStatistics &stats)
+{
+  this->Internals->PointData.TakeCompressionStatistics(stats);
+  this->Internals->CellData.TakeCompressionStatistics(stats);
+}
+
 // --------------------------------------------------------------------------
 int DatasetSchema::DefineVariables(MPI_Comm comm, int64_t gh,
   unsigned int doid, vtkDataObject *dobj)
@@ -1938,8 +2550,13 @@ int DatasetSchema::DefineVariables(int64_t gh, unsigned doid,
     std::string dataset_id = oss.str();
 
     // /data_object_<id>/dataset_<id>/data_object_type
-    std::string path = dataset_id + "data_object_type";
-    adios_define_var(gh, path.c_str(), "", adios_integer, "", "", "");
+    PathCache::PathList &paths = this->Paths.Define(doid, dsid);
+    paths.push_back(dataset_id + "data_object_type");
+    adios_define_var(gh, paths[0].c_str(), "", adios_integer, "", "", "");
+
+    // /data_object_<id>/dataset_<id>/bounds
+    paths.push_back(dataset_id + "bounds");
+    adios_define_var(gh, paths[1].c_str(), "", adios_double, "6", "6", "0");
     }
   return 0;
 }
@@ -1959,7 +2576,7 @@ uint64_t DatasetSchema::GetSize(MPI_Comm comm, vtkDataObject *dobj)
 uint64_t DatasetSchema::GetSize(vtkDataSet *ds)
 {
   if (ds)
-    return sizeof(int);
+    return sizeof(int) + 6*sizeof(double);
   return 0;
 }
 
@@ -1987,14 +2604,18 @@ int DatasetSchema::Write(int64_t fh, unsigned int doid, unsigned int dsid,
 {
   if (ds)
     {
-    std::ostringstream oss;
-    oss << "data_object_" << doid << "/dataset_" << dsid << "/";
-    std::string dataset_id = oss.str();
+    const PathCache::PathList *paths = this->Paths.Find(doid, dsid);
+    if (!paths)
+      return -1;
 
     // /data_object_<id>/dataset_<id>/data_object_type
-    std::string path = dataset_id + "data_object_type";
     int dobj_type = ds->GetDataObjectType();
-    adios_write(fh, path.c_str(), &dobj_type);
+    adios_write(fh, (*paths)[0].c_str(), &dobj_type);
+
+    // /data_object_<id>/dataset_<id>/bounds
+    double bounds[6] = {0.0};
+    ds->GetBounds(bounds);
+    adios_write(fh, (*paths)[1].c_str(), bounds);
     }
   return 0;
 }
@@ -2003,12 +2624,21 @@ int DatasetSchema::Write(int64_t fh, unsigned int doid, unsigned int dsid,
 int DatasetSchema::Read(MPI_Comm comm, InputStream &iStream,
   unsigned int doid, vtkDataObject *&dobj)
 {
-  if (this->Schema::Read(comm, iStream, doid, dobj) ||
-    this->Internals->Extent.Read(comm, iStream, doid, dobj) ||
-    this->Internals->Cells.Read(comm, iStream, doid, dobj) ||
-    this->Internals->Points.Read(comm, iStream, doid, dobj) ||
-    this->Internals->PointData.Read(comm, iStream, doid, dobj) ||
+  // construct the datasets and read their points and cells
+  if (this->ReadMesh(comm, iStream, doid, dobj, false))
+    {
+    SENSEI_ERROR("Failed to read")
+    return -1;
+    }
+
+  // read all of the arrays together
+  int ierr = 0;
+  if (this->Internals->PointData.Read(comm, iStream, doid, dobj) ||
     this->Internals->CellData.Read(comm, iStream, doid, dobj))
+    ierr = -1;
+
+  // make the reads, also after an error so that none are left pending
+  if (iStream.PerformReads() || ierr)
     {
     SENSEI_ERROR("Failed to read")
     return -1;
@@ -2025,21 +2655,40 @@ int DatasetSchema::Read(MPI_Comm comm, InputStream &iStream,
 
   ds = nullptr;
 
-  // consult the domain decomp, if it is ours then
-  // construct an instance
+  // consult the domain decomp, if it is ours then construct an instance
+  // once its type has been read. ds must remain valid until then. when
+  // there is a region of interest the datasets outside of it are skipped
   if (this->Internals->Decomp.find(dsid) != this->Internals->Decomp.end())
     {
     std::ostringstream oss;
     oss << "data_object_" << doid << "/dataset_" << dsid << "/";
     std::string dataset_id = oss.str();
 
+    struct Header
+    {
+      int DataObjectType;
+      double Bounds[6];
+    };
+
+    std::shared_ptr<Header> header = std::make_shared<Header>();
+
+    bool use_bounds = !iStream.Region.Empty();
+
+    iStream.Defer([&iStream, header, use_bounds, &ds]() -> int
+    {
+      if (use_bounds && !iStream.Region.Intersects(header->Bounds))
+        return 0;
+
+      ds = dynamic_cast<vtkDataSet*>(newDataObject(header->DataObjectType));
+      return 0;
+    });
+
     // /data_object_<id>/dataset_<id>/data_object_type
-    int dobj_type = 0;
-    std::string path = dataset_id + "data_object_type";
-    if (adiosInq(iStream, path, dobj_type))
+    // /data_object_<id>/dataset_<id>/bounds
+    if (iStream.ScheduleRead(dataset_id + "data_object_type",
+      &header->DataObjectType) || (use_bounds &&
+      iStream.ScheduleRead(dataset_id + "bounds", header->Bounds)))
       return -1;
-
-    ds = dynamic_cast<vtkDataSet*>(newDataObject(dobj_type));
     }
 
   return 0;
@@ -2057,34 +2706,56 @@ int DatasetSchema::ReadMesh(MPI_Comm comm, InputStream &iStream,
     vtkCompositeDataIterator *it = cd->NewIterator();
     it->SkipEmptyNodesOff();
 
+    // the types of the local datasets are read together, the datasets
+    // are constructed as the reads are made
+    std::map<unsigned int, vtkDataSet*> datasets;
+
+    int ierr = 0;
     for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
       {
-      int dsid = it->GetCurrentFlatIndex();
-
-      vtkDataSet *ds = nullptr;
-      if (this->Read(comm, iStream, doid, dsid, ds))
+      unsigned int dsid = it->GetCurrentFlatIndex();
+      if (this->Read(comm, iStream, doid, dsid, datasets[dsid]))
         {
-        it->Delete();
         SENSEI_ERROR("Failed to read data object " << doid << " dataset " << dsid);
-        return -1;
+        ierr = -1;
+        break;
         }
+      }
+
+    // make the reads, also after an error so that none are left pending
+    if (iStream.PerformReads())
+      ierr = -1;
+
+    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+      {
+      vtkDataSet *ds = datasets[it->GetCurrentFlatIndex()];
 
-      cd->SetDataSet(it, ds);
+      if (!ierr)
+        cd->SetDataSet(it, ds);
 
       if (ds)
         ds->Delete();
       }
     it->Delete();
+
+    if (ierr)
+      return -1;
     }
 
   // structure only, means no topolgy and geometry
   if (structure_only)
     return 0;
 
-  // read topology (cells) and geometry (points/extents)
+  // read topology (cells) and geometry (points/extents) of all of the
+  // datasets together
+  int ierr = 0;
   if (this->Internals->Extent.Read(comm, iStream, doid, dobj) ||
     this->Internals->Cells.Read(comm, iStream, doid, dobj) ||
     this->Internals->Points.Read(comm, iStream, doid, dobj))
+    ierr = -1;
+
+  // make the reads, also after an error so that none are left pending
+  if (iStream.PerformReads() || ierr)
     return -1;
 
   return 0;
@@ -2095,42 +2766,64 @@ int DatasetSchema::ReadArrayNames(MPI_Comm comm, InputStream &iStream,
   unsigned int doid, vtkDataObject *dobj, int association,
   std::set<std::string> &array_names)
 {
+  int ierr = 0;
   switch (association)
     {
     case vtkDataObject::POINT:
-      return this->Internals->PointData.ReadArrayNames(comm,
+      ierr = this->Internals->PointData.ReadArrayNames(comm,
         iStream, doid, dobj, array_names);
       break;
 
     case vtkDataObject::CELL:
-      return this->Internals->CellData.ReadArrayNames(comm,
+      ierr = this->Internals->CellData.ReadArrayNames(comm,
         iStream, doid, dobj, array_names);
       break;
+
+    default:
+      SENSEI_ERROR("Invalid array association " << association)
+      return -1;
     }
-  SENSEI_ERROR("Invalid array association " << association)
-  return -1;
+
+  // make the reads, also after an error so that none are left pending
+  if (iStream.PerformReads() || ierr)
+    return -1;
+
+  return 0;
 }
 
 // --------------------------------------------------------------------------
-int DatasetSchema::ReadArray(MPI_Comm comm, InputStream &iStream,
+int DatasetSchema::ReadArrays(MPI_Comm comm, InputStream &iStream,
   unsigned int doid, vtkDataObject *dobj, int association,
-  const std::string &name)
+  const std::vector<std::string> &names)
 {
-  (void)comm;
-
-  switch (association)
+  // schedule the reads of all of the arrays and make them together
+  int ierr = 0;
+  unsigned int n_names = names.size();
+  for (unsigned int i = 0; !ierr && (i < n_names); ++i)
     {
-    case vtkDataObject::POINT:
-      return this->Internals->PointData.ReadArray(comm,
-        iStream, name, doid, dobj);
-      break;
-    case vtkDataObject::CELL:
-      return this->Internals->CellData.ReadArray(comm,
-        iStream, name, doid, dobj);
-      break;
+    switch (association)
+      {
+      case vtkDataObject::POINT:
+        ierr = this->Internals->PointData.ReadArray(comm,
+          iStream, names[i], doid, dobj);
+        break;
+
+      case vtkDataObject::CELL:
+        ierr = this->Internals->CellData.ReadArray(comm,
+          iStream, names[i], doid, dobj);
+        break;
+
+      default:
+        SENSEI_ERROR("Invalid array association " << association)
+        ierr = -1;
+      }
     }
-  SENSEI_ERROR("Invalid array association " << association)
-  return -1;
+
+  // make the reads, also after an error so that none are left pending
+  if (iStream.PerformReads() || ierr)
+    return -1;
+
+  return 0;
 }
 
 
@@ -2138,7 +2831,7 @@ int DatasetSchema::ReadArray(MPI_Comm comm, InputStream &iStream,
 class VersionSchema
 {
 public:
-  VersionSchema() : Revision(2), LowestCompatibleRevision(2) {}
+  VersionSchema() : Revision(7), LowestCompatibleRevision(5) {}
 
   uint64_t GetSize(){ return sizeof(unsigned int); }
 
@@ -2176,20 +2869,27 @@ int VersionSchema::Write(int64_t fh)
 // --------------------------------------------------------------------------
 int VersionSchema::Read(InputStream &iStream)
 {
-  // check for the tag. if it is not present, this connot
-  // be one of our files
-  unsigned int revision = 0;
-  if (adiosInq(iStream, "DataObjectSchema", revision))
+  // the revision is read in the batch of the other per step values and
+  // is kept in the stream, where the readers of variables added in later
+  // revisions look it up. if the tag is not present, this connot be one
+  // of our files
+  iStream.Revision = 0;
+  if (iStream.ScheduleRead("DataObjectSchema", &iStream.Revision))
     return -1;
 
   // test for version backward compatibility.
-  if (revision < this->LowestCompatibleRevision)
-    {
-    SENSEI_ERROR("Schema revision " << this->LowestCompatibleRevision
-      << " is incompatible with with revision " << revision
-      << " found in the current stream")
-    return -2;
-    }
+  unsigned int lowest = this->LowestCompatibleRevision;
+  iStream.Defer([&iStream, lowest]() -> int
+  {
+    if (iStream.Revision < lowest)
+      {
+      SENSEI_ERROR("Schema revision " << lowest
+        << " is incompatible with with revision " << iStream.Revision
+        << " found in the current stream")
+      return -2;
+      }
+    return 0;
+  });
 
   return 0;
 }
@@ -2198,9 +2898,93 @@ int VersionSchema::Read(InputStream &iStream)
 
 struct DataObjectSchema::InternalsType
 {
+  InternalsType() : BlockAssignment(BLOCK_ASSIGNMENT_CONTIGUOUS) {}
+
   DatasetSchema Dataset;
+  int BlockAssignment;
+
+  // the rows of the dataset table written by this rank
+  std::vector<unsigned int> DatasetIds;
+  std::vector<int> DatasetWriters;
+  std::vector<uint64_t> DatasetSizes;
 };
 
+// indices of the cached paths of a data object
+enum
+{
+  OBJECT_NUMBER_OF_DATASETS = 0,
+  OBJECT_DATA_OBJECT_TYPE,
+  OBJECT_GHOST_CELL_LAYERS,
+  OBJECT_GHOST_NODE_LAYERS,
+  OBJECT_NUMBER_OF_LOCAL_DATASETS,
+  OBJECT_DATASET_OFFSET,
+  OBJECT_DATASET_IDS,
+  OBJECT_DATASET_WRITERS,
+  OBJECT_DATASET_SIZES,
+  OBJECT_NUMBER_OF_PATHS
+};
+
+// --------------------------------------------------------------------------
+// assigns the datasets to the ranks reading them. the datasets are given
+// by their ids and sizes, the ids assigned to rank are returned in
+// assigned along with their indices
+void assignBlocks(int method, int rank, int n_ranks,
+  const std::vector<unsigned int> &ids, const std::vector<uint64_t> &sizes,
+  std::vector<unsigned int> &assigned)
+{
+  unsigned int n_datasets = ids.size();
+
+  // visit the datasets in the order of their ids
+  std::vector<unsigned int> order(n_datasets);
+  for (unsigned int i = 0; i < n_datasets; ++i)
+    order[i] = i;
+
+  std::sort(order.begin(), order.end(),
+    [&ids](unsigned int a, unsigned int b) -> bool { return ids[a] < ids[b]; });
+
+  switch (method)
+    {
+    case BLOCK_ASSIGNMENT_ROUND_ROBIN:
+      for (unsigned int i = rank; i < n_datasets; i += n_ranks)
+        assigned.push_back(order[i]);
+      break;
+
+    case BLOCK_ASSIGNMENT_BALANCED:
+      {
+      // largest first, each to the rank with the fewest bytes. ties go to
+      // the lower rank so that all ranks compute the same assignment
+      std::stable_sort(order.begin(), order.end(),
+        [&sizes](unsigned int a, unsigned int b) -> bool
+        { return sizes[a] > sizes[b]; });
+
+      std::vector<uint64_t> load(n_ranks, 0);
+      for (unsigned int i = 0; i < n_datasets; ++i)
+        {
+        int r = std::min_element(load.begin(), load.end()) - load.begin();
+        load[r] += sizes[order[i]];
+        if (r == rank)
+          assigned.push_back(order[i]);
+        }
+      }
+      break;
+
+    case BLOCK_ASSIGNMENT_CONTIGUOUS:
+    default:
+      {
+      unsigned int n_local = n_datasets / n_ranks;
+      unsigned int n_large = n_datasets % n_ranks;
+
+      unsigned int r = rank;
+      unsigned int i0 = n_local*r + (r < n_large ? r : n_large);
+      unsigned int i1 = i0 + n_local + (r < n_large ? 1 : 0);
+
+      for (unsigned int i = i0; i < i1; ++i)
+        assigned.push_back(order[i]);
+      }
+      break;
+    }
+}
+
 // --------------------------------------------------------------------------
 DataObjectSchema::DataObjectSchema()
 {
@@ -2220,22 +3004,64 @@ int DataObjectSchema::DefineVariables(MPI_Comm comm, int64_t gh,
   std::ostringstream oss;
   oss << "data_object_" << doid << "/";
 
+  // the data object's variables are cached under dataset id 0, which
+  // is not used by the datasets
+  PathCache::PathList &paths = this->Paths.Define(doid, 0);
+  paths.resize(OBJECT_NUMBER_OF_PATHS);
+
   // /data_object_<id>/number_of_datasets
-  std::string path = oss.str() + "number_of_datasets";
+  std::string &path = paths[OBJECT_NUMBER_OF_DATASETS];
+  path = oss.str() + "number_of_datasets";
   adios_define_var(gh, path.c_str(), "", adios_unsigned_integer,
     "", "", "");
 
   // /data_object_<id>/data_object_type
-  path = oss.str() + "data_object_type";
-  adios_define_var(gh, path.c_str(), "", adios_integer, "", "", "");
+  std::string &path_type = paths[OBJECT_DATA_OBJECT_TYPE];
+  path_type = oss.str() + "data_object_type";
+  adios_define_var(gh, path_type.c_str(), "", adios_integer, "", "", "");
 
   // /data_object_<id>/number_of_ghost_cell_layers
-  path = oss.str() + "number_of_ghost_cell_layers";
-  adios_define_var(gh, path.c_str(), "", adios_integer, "", "", "");
+  std::string &path_cell = paths[OBJECT_GHOST_CELL_LAYERS];
+  path_cell = oss.str() + "number_of_ghost_cell_layers";
+  adios_define_var(gh, path_cell.c_str(), "", adios_integer, "", "", "");
 
   // /data_object_<id>/number_of_ghost_node_layers
-  path = oss.str() + "number_of_ghost_node_layers";
-  adios_define_var(gh, path.c_str(), "", adios_integer, "", "", "");
+  std::string &path_node = paths[OBJECT_GHOST_NODE_LAYERS];
+  path_node = oss.str() + "number_of_ghost_node_layers";
+  adios_define_var(gh, path_node.c_str(), "", adios_integer, "", "", "");
+
+  // the table of datasets, the id of each, the rank that wrote it, and
+  // its size in bytes. each rank writes the rows of its datasets, readers
+  // use the table to assign the datasets to themselves
+  // /data_object_<id>/number_of_local_datasets
+  std::string &path_local = paths[OBJECT_NUMBER_OF_LOCAL_DATASETS];
+  path_local = oss.str() + "number_of_local_datasets";
+  adios_define_var(gh, path_local.c_str(), "", adios_unsigned_integer,
+    "", "", "");
+
+  // /data_object_<id>/dataset_offset
+  std::string &path_offset = paths[OBJECT_DATASET_OFFSET];
+  path_offset = oss.str() + "dataset_offset";
+  adios_define_var(gh, path_offset.c_str(), "", adios_unsigned_integer,
+    "", "", "");
+
+  // /data_object_<id>/dataset_ids
+  std::string &path_ids = paths[OBJECT_DATASET_IDS];
+  path_ids = oss.str() + "dataset_ids";
+  adios_define_var(gh, path_ids.c_str(), "", adios_unsigned_integer,
+    path_local.c_str(), path.c_str(), path_offset.c_str());
+
+  // /data_object_<id>/dataset_writers
+  std::string &path_writers = paths[OBJECT_DATASET_WRITERS];
+  path_writers = oss.str() + "dataset_writers";
+  adios_define_var(gh, path_writers.c_str(), "", adios_integer,
+    path_local.c_str(), path.c_str(), path_offset.c_str());
+
+  // /data_object_<id>/dataset_sizes
+  std::string &path_sizes = paths[OBJECT_DATASET_SIZES];
+  path_sizes = oss.str() + "dataset_sizes";
+  adios_define_var(gh, path_sizes.c_str(), "", adios_unsigned_long,
+    path_local.c_str(), path.c_str(), path_offset.c_str());
 
   if (this->Internals->Dataset.DefineVariables(comm, gh, doid, dobj))
     {
@@ -2249,7 +3075,10 @@ int DataObjectSchema::DefineVariables(MPI_Comm comm, int64_t gh,
 // --------------------------------------------------------------------------
 uint64_t DataObjectSchema::GetSize(MPI_Comm comm, vtkDataObject *dobj)
 {
-  return sizeof(unsigned int) + 3*sizeof(int) +
+  uint64_t n_local = getNumberOfDatasets(comm, dobj, 1);
+
+  return 3*sizeof(unsigned int) + 3*sizeof(int) +
+    n_local*(sizeof(unsigned int) + sizeof(int) + sizeof(uint64_t)) +
     this->Internals->Dataset.GetSize(comm, dobj);
 }
 
@@ -2262,14 +3091,13 @@ int DataObjectSchema::Write(MPI_Comm comm, int64_t fh, unsigned int doid,
   unsigned int n_datasets = getNumberOfDatasets(comm, dobj, 0);
   int dobj_type = dobj->GetDataObjectType();
 
-  std::ostringstream oss;
-  oss << "data_object_" << doid << "/";
+  const PathCache::PathList *paths = this->Paths.Find(doid, 0);
+  if (!paths)
+    return -1;
 
-  std::string path = oss.str() + "number_of_datasets";
-  adios_write(fh, path.c_str(), &n_datasets);
+  adios_write(fh, (*paths)[OBJECT_NUMBER_OF_DATASETS].c_str(), &n_datasets);
 
-  path = oss.str() + "data_object_type";
-  adios_write(fh, path.c_str(), &dobj_type);
+  adios_write(fh, (*paths)[OBJECT_DATA_OBJECT_TYPE].c_str(), &dobj_type);
 
   int nGhostCellLayers = 0;
   int nGhostNodeLayers = 0;
@@ -2278,13 +3106,58 @@ int DataObjectSchema::Write(MPI_Comm comm, int64_t fh, unsigned int doid,
     {
     SENSEI_ERROR("missing ghost layer meta data")
     return -1;
-    }
+    }
+
+  adios_write(fh, (*paths)[OBJECT_GHOST_CELL_LAYERS].c_str(),
+    &nGhostCellLayers);
+
+  adios_write(fh, (*paths)[OBJECT_GHOST_NODE_LAYERS].c_str(),
+    &nGhostNodeLayers);
+
+  // the rows of the dataset table
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  std::vector<unsigned int> &ids = this->Internals->DatasetIds;
+  std::vector<int> &writers = this->Internals->DatasetWriters;
+  std::vector<uint64_t> &sizes = this->Internals->DatasetSizes;
+
+  ids.clear();
+  writers.clear();
+  sizes.clear();
+
+  dataset_function func = [&](unsigned int, unsigned int dsid,
+    vtkDataSet *ds) -> int
+  {
+    ids.push_back(dsid);
+    writers.push_back(rank);
+    sizes.push_back(this->Internals->Dataset.GetNumberOfBytes(ds));
+    return 0;
+  };
+
+  // a simple dataset's id is the MPI rank shifted by 1
+  unsigned int dsid = 0;
+  if (dynamic_cast<vtkDataSet*>(dobj))
+    dsid = rank + 1;
+
+  if (apply(doid, dsid, dobj, func) < 0)
+    return -1;
+
+  unsigned int n_local = ids.size();
+  unsigned int offset = 0;
+  MPI_Exscan(&n_local, &offset, 1, MPI_UNSIGNED, MPI_SUM, comm);
+  if (rank == 0)
+    offset = 0;
 
-  path = oss.str() + "number_of_ghost_cell_layers";
-  adios_write(fh, path.c_str(), &nGhostCellLayers);
+  adios_write(fh, (*paths)[OBJECT_NUMBER_OF_LOCAL_DATASETS].c_str(), &n_local);
+  adios_write(fh, (*paths)[OBJECT_DATASET_OFFSET].c_str(), &offset);
 
-  path = oss.str() + "number_of_ghost_node_layers";
-  adios_write(fh, path.c_str(), &nGhostNodeLayers);
+  if (n_local)
+    {
+    adios_write(fh, (*paths)[OBJECT_DATASET_IDS].c_str(), ids.data());
+    adios_write(fh, (*paths)[OBJECT_DATASET_WRITERS].c_str(), writers.data());
+    adios_write(fh, (*paths)[OBJECT_DATASET_SIZES].c_str(), sizes.data());
+    }
 
   if (this->Internals->Dataset.Write(comm, fh, doid, dobj))
     {
@@ -2305,19 +3178,28 @@ int DataObjectSchema::InitializeDataObject(MPI_Comm comm, InputStream &iStream,
   MPI_Comm_rank(comm, &rank);
   MPI_Comm_size(comm, &n_ranks);
 
-  // read the number of datasets stored in the stream
-  // and the type of the root object
+  // read the number of datasets stored in the stream, the type of the
+  // root object, and the ghost layer info together
   std::ostringstream oss;
   oss << "data_object_" << doid << "/";
+  std::string object_id = oss.str();
 
-  std::string path = oss.str() + "number_of_datasets";
   unsigned int n_datasets = 0;
-  if (adiosInq(iStream, path, n_datasets))
-    return -1;
-
   int dobj_type = 0;
-  path = oss.str() + "data_object_type";
-  if (adiosInq(iStream, path, dobj_type))
+  int nGhostCellLayers = 0;
+  int nGhostNodeLayers = 0;
+
+  int ierr = 0;
+  if (iStream.ScheduleRead(object_id + "number_of_datasets", &n_datasets) ||
+    iStream.ScheduleRead(object_id + "data_object_type", &dobj_type) ||
+    iStream.ScheduleRead(object_id + "number_of_ghost_cell_layers",
+      &nGhostCellLayers) ||
+    iStream.ScheduleRead(object_id + "number_of_ghost_node_layers",
+      &nGhostNodeLayers))
+    ierr = -1;
+
+  // make the reads, also after an error so that none are left pending
+  if (iStream.PerformReads() || ierr)
     return -1;
 
   // determine if we have the old style decompostion, namely 1 legacy dataset
@@ -2358,25 +3240,70 @@ int DataObjectSchema::InitializeDataObject(MPI_Comm comm, InputStream &iStream,
     }
 
   // compute the domain decomposition
-  int n_local = n_datasets / n_ranks;
-  int n_large = n_datasets % n_ranks;
+  this->Internals->Dataset.ClearDecomp();
+  iStream.ClearDatasetWriters(doid);
+
+  // streams written before the dataset table was added hold the
+  // datasets in the order of the ranks that wrote them. a legacy
+  // dataset per rank must have the id of the rank
+  std::string ids_path = object_id + "dataset_ids";
+  bool have_table = false;
+  if (ADIOS_VARINFO *vinfo = adios_inq_var(iStream.File, ids_path.c_str()))
+    {
+    have_table = true;
+    adios_free_varinfo(vinfo);
+    }
 
-  int id0 = 1 + n_local*rank + (rank < n_large ? rank : n_large);
-  int id1 = id0 + n_local + (rank < n_large ? 1 : 0);
+  if (!have_table ||
+    (legacyRootObject && (dobj_type != VTK_MULTIBLOCK_DATA_SET)))
+    {
+    int n_local = n_datasets / n_ranks;
+    int n_large = n_datasets % n_ranks;
 
-  this->Internals->Dataset.ClearDecomp();
-  this->Internals->Dataset.SetDecomp(id0, id1);
+    int id0 = 1 + n_local*rank + (rank < n_large ? rank : n_large);
+    int id1 = id0 + n_local + (rank < n_large ? 1 : 0);
 
-  // add the ghost layer info
-  int nGhostCellLayers = 0;
-  path = oss.str() + "number_of_ghost_cell_layers";
-  if (adiosInq(iStream, path, nGhostCellLayers))
-    return -1;
+    this->Internals->Dataset.SetDecomp(id0, id1);
 
-  int nGhostNodeLayers = 0;
-  path = oss.str() + "number_of_ghost_node_layers";
-  if (adiosInq(iStream, path, nGhostNodeLayers))
-    return -1;
+    // the reader of a dataset has the writer's rank
+    for (int i = id0; i < id1; ++i)
+      iStream.SetDatasetWriter(doid, i, rank);
+    }
+  else if (n_datasets)
+    {
+    // read the table and assign the datasets
+    std::vector<unsigned int> ids(n_datasets);
+    std::vector<int> writers(n_datasets);
+    std::vector<uint64_t> sizes(n_datasets);
+
+    ierr = 0;
+    if (iStream.ScheduleRead(ids_path, 0, n_datasets, ids.data()) ||
+      iStream.ScheduleRead(object_id + "dataset_writers", 0, n_datasets,
+        writers.data()) ||
+      iStream.ScheduleRead(object_id + "dataset_sizes", 0, n_datasets,
+        sizes.data()))
+      ierr = -1;
+
+    // make the reads, also after an error so that none are left pending
+    if (iStream.PerformReads() || ierr)
+      {
+      SENSEI_ERROR("Failed to read the table of datasets")
+      return -1;
+      }
+
+    std::vector<unsigned int> assigned;
+    assignBlocks(this->Internals->BlockAssignment, rank, n_ranks,
+      ids, sizes, assigned);
+
+    unsigned int n_assigned = assigned.size();
+    for (unsigned int i = 0; i < n_assigned; ++i)
+      this->Internals->Dataset.AddDecomp(ids[assigned[i]]);
+
+    // the metadata of the other datasets, such as the names of their
+    // arrays, is read as well
+    for (unsigned int i = 0; i < n_datasets; ++i)
+      iStream.SetDatasetWriter(doid, ids[i], writers[i]);
+    }
 
   // pass ghost layer metadata in field data.
   sensei::VTKUtils::SetGhostLayerMetadata(dobj,
@@ -2428,6 +3355,25 @@ int DataObjectSchema::ReadMesh(MPI_Comm comm, InputStream &iStream,
   return 0;
 }
 
+// --------------------------------------------------------------------------
+void DataObjectSchema::SetBlockAssignment(int method)
+{
+  this->Internals->BlockAssignment = method;
+}
+
+// --------------------------------------------------------------------------
+void DataObjectSchema::SetCompression(int association,
+  const std::string &array_name, const CompressionSpec &spec)
+{
+  this->Internals->Dataset.SetCompression(association, array_name, spec);
+}
+
+// --------------------------------------------------------------------------
+void DataObjectSchema::TakeCompressionStatistics(CompressionStatistics &stats)
+{
+  this->Internals->Dataset.TakeCompressionStatistics(stats);
+}
+
 // --------------------------------------------------------------------------
 int DataObjectSchema::ReadArrayNames(MPI_Comm comm, InputStream &iStream,
   unsigned int doid, vtkDataObject *dobj, int association,
@@ -2438,23 +3384,77 @@ int DataObjectSchema::ReadArrayNames(MPI_Comm comm, InputStream &iStream,
 }
 
 // --------------------------------------------------------------------------
-int DataObjectSchema::ReadArray(MPI_Comm comm, InputStream &iStream,
+int DataObjectSchema::ReadArrays(MPI_Comm comm, InputStream &iStream,
   unsigned int doid, vtkDataObject *dobj, int association,
-  const std::string &name)
+  const std::vector<std::string> &names)
 {
-  return this->Internals->Dataset.ReadArray(comm, iStream, doid,
-    dobj, association, name);
+  return this->Internals->Dataset.ReadArrays(comm, iStream, doid,
+    dobj, association, names);
 }
 
 
 
 using ObjectNameIdMapType = std::map<std::string, unsigned int>;
 
+// --------------------------------------------------------------------------
+// appends the values that determine the size of the ADIOS representation
+// of a data object, the number, types, and sizes of its datasets and
+// their arrays, to the layout
+int appendLayout(vtkDataObject *dobj, std::vector<uint64_t> &layout)
+{
+  layout.push_back(dobj->GetDataObjectType());
+
+  dataset_function func =
+    [&layout](unsigned int, unsigned int dsid, vtkDataSet *ds) -> int
+  {
+    layout.push_back(dsid);
+    layout.push_back(ds->GetDataObjectType());
+    layout.push_back(PointsSchema::GetPointsLength(ds));
+    layout.push_back(CellsSchema::GetNumberOfCells(ds));
+    layout.push_back(CellsSchema::GetCellsLength(ds));
+
+    int atts[2] = {vtkDataObject::POINT, vtkDataObject::CELL};
+    for (int j = 0; j < 2; ++j)
+      {
+      vtkDataSetAttributes *dsa = ds->GetAttributes(atts[j]);
+      int n_arrays = dsa->GetNumberOfArrays();
+      layout.push_back(n_arrays);
+      for (int i = 0; i < n_arrays; ++i)
+        {
+        vtkDataArray *da = dsa->GetArray(i);
+        const char *name = da->GetName();
+        layout.push_back(da->GetDataType());
+        layout.push_back(da->GetNumberOfComponents());
+        layout.push_back(da->GetNumberOfTuples());
+        layout.push_back(name ? strlen(name) : 0);
+        }
+      }
+    return 0;
+  };
+
+  if (apply(0, 0, dobj, func) < 0)
+    return -1;
+
+  return 0;
+}
+
 struct DataObjectCollectionSchema::InternalsType
 {
+  InternalsType() : Size(0) {}
+
   VersionSchema Version;
   DataObjectSchema DataObject;
   ObjectNameIdMapType ObjectNameIdMap;
+  PathCache Paths;
+
+  // the regions of interest by object name
+  std::map<std::string, std::vector<double>> Regions;
+
+  // the layout of the objects the last time their size was computed,
+  // and that size. Layout is empty until the size is first computed
+  std::vector<uint64_t> Layout;
+  std::vector<uint64_t> NewLayout;
+  uint64_t Size;
 };
 
 // --------------------------------------------------------------------------
@@ -2502,7 +3502,10 @@ int DataObjectCollectionSchema::DefineVariables(MPI_Comm comm, int64_t gh,
     std::string object_id = oss.str();
 
     // /data_object_<id>/name
-    StringSchema::DefineVariables(gh, object_id + "name");
+    PathCache::PathList &paths = this->Internals->Paths.Define(i, 0);
+    paths.push_back(object_id + "name");
+    paths.push_back(StringSchema::GetLengthPath(paths[0]));
+    StringSchema::DefineVariables(gh, paths[0]);
 
     if (this->Internals->DataObject.DefineVariables(comm, gh, i, objects[i]))
       {
@@ -2530,6 +3533,27 @@ uint64_t DataObjectCollectionSchema::GetSize(MPI_Comm comm,
     return -1;
     }
 
+  // the size depends only on the layout of the objects, which is found in
+  // one pass over the datasets. when the layout has not changed the size
+  // computed for it is reused rather than having each of the schema
+  // traverse the objects. the buffers are reused so that this does not
+  // allocate once the layout is steady
+  std::vector<uint64_t> &layout = this->Internals->NewLayout;
+  layout.clear();
+  for (unsigned int i = 0; i < n_objects; ++i)
+    {
+    layout.push_back(object_names[i].size());
+    if (appendLayout(objects[i], layout))
+      {
+      SENSEI_ERROR("Failed to get the layout of object "
+        << i << " " << object_names[i])
+      return -1;
+      }
+    }
+
+  if (!this->Internals->Layout.empty() && (layout == this->Internals->Layout))
+    return this->Internals->Size;
+
   uint64_t size_of_names = 0;
   uint64_t size_of_objects = 0;
   for (unsigned int i = 0; i < n_objects; ++i)
@@ -2538,8 +3562,12 @@ uint64_t DataObjectCollectionSchema::GetSize(MPI_Comm comm,
     size_of_objects += this->Internals->DataObject.GetSize(comm, objects[i]);
     }
 
-  return sizeof(int) + size_of_names +
+  this->Internals->Size = sizeof(int) + size_of_names +
     size_of_objects + this->Internals->Version.GetSize();
+
+  this->Internals->Layout.swap(layout);
+
+  return this->Internals->Size;
 }
 
 // --------------------------------------------------------------------------
@@ -2563,18 +3591,16 @@ int DataObjectCollectionSchema::Write(MPI_Comm comm, int64_t fh,
   adios_write(fh, "time", &time);
 
   // /number_of_data_objects
-  std::string path = "number_of_data_objects";
-  adios_write(fh, path.c_str(), &n_objects);
+  adios_write(fh, "number_of_data_objects", &n_objects);
 
   for (unsigned int i = 0; i < n_objects; ++i)
     {
-    std::ostringstream oss;
-    oss << "data_object_" << i << "/";
-    std::string object_id = oss.str();
+    const PathCache::PathList *paths = this->Internals->Paths.Find(i, 0);
+    if (!paths)
+      return -1;
 
     // /data_object_<id>/name
-    path = object_id + "name";
-    StringSchema::Write(fh, path, object_names[i]);
+    StringSchema::Write(fh, (*paths)[0], (*paths)[1], object_names[i].c_str());
 
     if (this->Internals->DataObject.Write(comm, fh, i, objects[i]))
       {
@@ -2600,8 +3626,24 @@ int DataObjectCollectionSchema::ReadObject(MPI_Comm comm,
     return -1;
     }
 
-  if (this->Internals->DataObject.ReadMesh(comm, iStream,
-    doid, object, structure_only))
+  // select the object's region of interest, the extents recorded by a
+  // previous read no longer apply
+  std::map<std::string, std::vector<double>>::iterator rit =
+    this->Internals->Regions.find(object_name);
+
+  if (rit == this->Internals->Regions.end())
+    iStream.Region.Bounds.clear();
+  else
+    iStream.Region.Bounds = rit->second;
+
+  iStream.Region.Clear(doid);
+
+  int ierr = this->Internals->DataObject.ReadMesh(comm, iStream,
+    doid, object, structure_only);
+
+  iStream.Region.Bounds.clear();
+
+  if (ierr)
     {
     SENSEI_ERROR("Failed to read object " << doid << " \""
       << object_name << "\"")
@@ -2611,6 +3653,40 @@ int DataObjectCollectionSchema::ReadObject(MPI_Comm comm,
   return 0;
 }
 
+// --------------------------------------------------------------------------
+void DataObjectCollectionSchema::SetRegionOfInterest(
+  const std::string &object_name, const double bounds[6])
+{
+  this->Internals->Regions[object_name].assign(bounds, bounds + 6);
+}
+
+// --------------------------------------------------------------------------
+void DataObjectCollectionSchema::ClearRegionsOfInterest()
+{
+  this->Internals->Regions.clear();
+}
+
+// --------------------------------------------------------------------------
+void DataObjectCollectionSchema::SetBlockAssignment(int method)
+{
+  this->Internals->DataObject.SetBlockAssignment(method);
+}
+
+// --------------------------------------------------------------------------
+void DataObjectCollectionSchema::SetCompression(int association,
+  const std::string &array_name, const CompressionSpec &spec)
+{
+  this->Internals->DataObject.SetCompression(association, array_name, spec);
+}
+
+// --------------------------------------------------------------------------
+void DataObjectCollectionSchema::TakeCompressionStatistics(
+  CompressionStatistics &stats)
+{
+  stats = CompressionStatistics();
+  this->Internals->DataObject.TakeCompressionStatistics(stats);
+}
+
 
 
 // --------------------------------------------------------------------------
@@ -2622,41 +3698,36 @@ int DataObjectCollectionSchema::ReadObjectNames(MPI_Comm comm,
   if (this->Internals->ObjectNameIdMap.empty())
     {
     // /number_of_data_objects
-    unsigned int n_objects = 0;
-    if (adiosInq(iStream, "number_of_data_objects", n_objects))
-      return -1;
+    // the number of objects is read first and then their names
+    std::shared_ptr<unsigned int> n_objects =
+      std::make_shared<unsigned int>(0);
 
-    ADIOS_SELECTION *sel = nullptr;
-    if (!streamIsFileBased(iStream.ReadMethod))
-      {
-      int rank = 0;
-      MPI_Comm_rank(comm, &rank);
-      sel = adios_selection_writeblock(rank);
-      if (!sel)
+    iStream.Defer([this, &iStream, n_objects]() -> int
+    {
+      for (unsigned int i = 0; i < *n_objects; ++i)
         {
-        SENSEI_ERROR("Failed to make the selction")
-        return -1;
+        std::ostringstream oss;
+        oss << "data_object_" << i << "/";
+        std::string data_object_id = oss.str();
+
+        // /data_object_<id>/name
+        if (StringSchema::Read(iStream, data_object_id + "name",
+          [this, i](const std::string &name) -> int
+          {
+            // store name to object id conversion
+            this->Internals->ObjectNameIdMap[name] = i;
+            return 0;
+          }))
+          return -1;
         }
-      }
-
-    for (unsigned int i = 0; i < n_objects; ++i)
-      {
-      std::ostringstream oss;
-      oss << "data_object_" << i << "/";
-      std::string data_object_id = oss.str();
-
-      // /data_object_<id>/name
-      std::string name;
-      std::string path = data_object_id + "name";
-      if (StringSchema::Read(iStream, sel, path, name))
-        return -1;
+      return 0;
+    });
 
-      // store name to object id conversion
-      this->Internals->ObjectNameIdMap[name] = i;
-      }
+    int ierr = iStream.ScheduleRead("number_of_data_objects", n_objects.get());
 
-    if (sel)
-      adios_selection_delete(sel);
+    // make the reads, also after an error so that none are left pending
+    if (iStream.PerformReads() || ierr)
+      return -1;
     }
 
   // copy object names
@@ -2738,8 +3809,9 @@ int DataObjectCollectionSchema::ReadArray(MPI_Comm comm, InputStream &iStream,
     return -1;
     }
 
-  if (this->Internals->DataObject.ReadArray(comm, iStream, doid, dobj,
-    association, array_name))
+  std::vector<std::string> array_names(1, array_name);
+  if (this->Internals->DataObject.ReadArrays(comm, iStream, doid, dobj,
+    association, array_names))
     {
     SENSEI_ERROR("Failed to read "
       << sensei::VTKUtils::GetAttributesName(association)
@@ -2751,18 +3823,46 @@ int DataObjectCollectionSchema::ReadArray(MPI_Comm comm, InputStream &iStream,
   return 0;
 }
 
+// --------------------------------------------------------------------------
+int DataObjectCollectionSchema::ReadArrays(MPI_Comm comm, InputStream &iStream,
+  const std::string &object_name, vtkDataObject *dobj, int association,
+  const std::vector<std::string> &array_names)
+{
+  unsigned int doid = 0;
+  if (this->GetObjectId(comm, iStream, object_name, doid))
+    {
+    SENSEI_ERROR("Failed to get object id for \"" << object_name << "\"")
+    return -1;
+    }
+
+  if (this->Internals->DataObject.ReadArrays(comm, iStream, doid, dobj,
+    association, array_names))
+    {
+    SENSEI_ERROR("Failed to read "
+      << sensei::VTKUtils::GetAttributesName(association)
+      << " data arrays from object \"" << object_name << "\"")
+    return -1;
+    }
+
+  return 0;
+}
+
 // --------------------------------------------------------------------------
 int DataObjectCollectionSchema::ReadTimeStep(MPI_Comm comm,
   InputStream &iStream, unsigned long &time_step, double &time)
 {
   (void)comm;
 
-  // read time and step values
-  if (adiosInq(iStream, "time", time))
-      return -1;
+  // read time, step, and schema revision values together
+  int ierr = 0;
+  if (iStream.ScheduleRead("time", &time) ||
+    iStream.ScheduleRead("time_step", &time_step) ||
+    this->Internals->Version.Read(iStream))
+    ierr = -1;
 
-  if (adiosInq(iStream, "time_step", time_step))
-      return -1;
+  // make the reads, also after an error so that none are left pending
+  if (iStream.PerformReads() || ierr)
+    return -1;
 
   return 0;
 }
@@ -2795,6 +3895,88 @@ int OutputStream::SetGroupSize(uint64_t size)
 }
 */
 
+// --------------------------------------------------------------------------
+bool RegionOfInterest::Intersects(const double bounds[6]) const
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    if ((bounds[2*i] > this->Bounds[2*i+1]) ||
+      (bounds[2*i+1] < this->Bounds[2*i]))
+      return false;
+    }
+  return true;
+}
+
+// --------------------------------------------------------------------------
+void RegionOfInterest::Select(unsigned int doid, unsigned int dsid,
+  const int extent[6], const double origin[3], const double spacing[3],
+  int sub_extent[6])
+{
+  KeyType key(doid, dsid);
+
+  for (int i = 0; i < 6; ++i)
+    sub_extent[i] = extent[i];
+
+  if (this->Empty())
+    {
+    this->Crops.erase(key);
+    return;
+    }
+
+  // the points covering the region, clamped to the extent
+  bool cropped = false;
+  for (int i = 0; i < 3; ++i)
+    {
+    if (spacing[i] <= 0.0)
+      continue;
+
+    int lo = static_cast<int>(
+      std::floor((this->Bounds[2*i] - origin[i])/spacing[i]));
+
+    int hi = static_cast<int>(
+      std::ceil((this->Bounds[2*i+1] - origin[i])/spacing[i]));
+
+    sub_extent[2*i] = std::min(std::max(lo, extent[2*i]), extent[2*i+1]);
+    sub_extent[2*i+1] = std::max(std::min(hi, extent[2*i+1]), sub_extent[2*i]);
+
+    cropped |= (sub_extent[2*i] != extent[2*i]) ||
+      (sub_extent[2*i+1] != extent[2*i+1]);
+    }
+
+  if (!cropped)
+    {
+    this->Crops.erase(key);
+    return;
+    }
+
+  Crop &crop = this->Crops[key];
+  for (int i = 0; i < 6; ++i)
+    {
+    crop.Extent[i] = extent[i];
+    crop.SubExtent[i] = sub_extent[i];
+    }
+}
+
+// --------------------------------------------------------------------------
+const RegionOfInterest::Crop *RegionOfInterest::Find(unsigned int doid,
+  unsigned int dsid) const
+{
+  std::map<KeyType, Crop>::const_iterator it =
+    this->Crops.find(KeyType(doid, dsid));
+
+  if (it == this->Crops.end())
+    return nullptr;
+
+  return &it->second;
+}
+
+// --------------------------------------------------------------------------
+void RegionOfInterest::Clear(unsigned int doid)
+{
+  this->Crops.erase(this->Crops.lower_bound(KeyType(doid, 0)),
+    this->Crops.lower_bound(KeyType(doid + 1, 0)));
+}
+
 // --------------------------------------------------------------------------
 int InputStream::Open(MPI_Comm comm, ADIOS_READ_METHOD method,
   const std::string &fileName)
@@ -2818,6 +4000,20 @@ int InputStream::Open(MPI_Comm comm, ADIOS_READ_METHOD method,
   this->File = file;
   this->ReadMethod = method;
 
+  // with staging methods the variables written by all ranks are read
+  // from the block of rank 0, the datasets from the blocks of their
+  // writers. see SetDatasetWriter
+  if (!streamIsFileBased(method))
+    {
+    this->Selection = adios_selection_writeblock(0);
+    if (!this->Selection)
+      {
+      SENSEI_ERROR("Failed to make the selction")
+      this->Close();
+      return -1;
+      }
+    }
+
 /*
   // verify that it is one of ours
   DataObjectSchema schema;
@@ -2858,7 +4054,169 @@ int InputStream::Close()
     this->ReadMethod = static_cast<ADIOS_READ_METHOD>(-1);
     }
 
+  if (this->Selection)
+    {
+    adios_selection_delete(this->Selection);
+    this->Selection = nullptr;
+    }
+
+  size_t n_selections = this->Selections.size();
+  for (size_t i = 0; i < n_selections; ++i)
+    adios_selection_delete(this->Selections[i]);
+  this->Selections.clear();
+
+  std::map<int, ADIOS_SELECTION*>::iterator it = this->WriteBlocks.begin();
+  std::map<int, ADIOS_SELECTION*>::iterator end = this->WriteBlocks.end();
+  for (; it != end; ++it)
+    adios_selection_delete(it->second);
+  this->WriteBlocks.clear();
+  this->DatasetWriters.clear();
+
+  this->NumberOfScheduledReads = 0;
+  this->ReadError = 0;
+  this->Deferred.clear();
+  this->Region = RegionOfInterest();
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int InputStream::ScheduleRead(const std::string &path, void *buf)
+{
+  if (adios_schedule_read(this->File, this->GetSelection(path),
+    path.c_str(), 0, 1, buf))
+    {
+    SENSEI_ERROR("Failed to schedule the read of \"" << path << "\"")
+    this->ReadError = -1;
+    return -1;
+    }
+
+  ++this->NumberOfScheduledReads;
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int InputStream::ScheduleRead(const std::string &path, uint64_t start,
+  uint64_t count, void *buf)
+{
+  // the variables are global arrays holding one block, so the elements
+  // are selected by their position in the block with any read method
+  ADIOS_SELECTION *sel = adios_selection_boundingbox(1, &start, &count);
+  if (!sel)
+    {
+    SENSEI_ERROR("Failed to make the selection of \"" << path << "\"")
+    this->ReadError = -1;
+    return -1;
+    }
+
+  // the selection is needed until the read is made
+  this->Selections.push_back(sel);
+
+  if (adios_schedule_read(this->File, sel, path.c_str(), 0, 1, buf))
+    {
+    SENSEI_ERROR("Failed to schedule the read of \"" << path << "\"")
+    this->ReadError = -1;
+    return -1;
+    }
+
+  ++this->NumberOfScheduledReads;
+
   return 0;
 }
 
+// --------------------------------------------------------------------------
+void InputStream::SetDatasetWriter(unsigned int doid, unsigned int dsid,
+  int writer)
+{
+  // the blocks of the file based methods are selected by the whole
+  // variable
+  if (streamIsFileBased(this->ReadMethod))
+    return;
+
+  this->DatasetWriters[std::make_pair(doid, dsid)] = writer;
+}
+
+// --------------------------------------------------------------------------
+void InputStream::ClearDatasetWriters(unsigned int doid)
+{
+  this->DatasetWriters.erase(
+    this->DatasetWriters.lower_bound(std::make_pair(doid, 0u)),
+    this->DatasetWriters.lower_bound(std::make_pair(doid + 1, 0u)));
+}
+
+// --------------------------------------------------------------------------
+ADIOS_SELECTION *InputStream::GetSelection(const std::string &path)
+{
+  if (this->DatasetWriters.empty())
+    return this->Selection;
+
+  // /data_object_<id>/dataset_<id>/...
+  unsigned int doid = 0;
+  unsigned int dsid = 0;
+  if (sscanf(path.c_str(), "data_object_%u/dataset_%u/", &doid, &dsid) != 2)
+    return this->Selection;
+
+  std::map<std::pair<unsigned int, unsigned int>, int>::iterator it =
+    this->DatasetWriters.find(std::make_pair(doid, dsid));
+
+  if (it == this->DatasetWriters.end())
+    return this->Selection;
+
+  ADIOS_SELECTION *&sel = this->WriteBlocks[it->second];
+  if (!sel)
+    sel = adios_selection_writeblock(it->second);
+
+  return sel;
+}
+
+// --------------------------------------------------------------------------
+void InputStream::Defer(const std::function<int()> &func)
+{
+  this->Deferred.push_back(func);
+}
+
+// --------------------------------------------------------------------------
+int InputStream::PerformReads()
+{
+  int ierr = this->ReadError;
+
+  while (this->NumberOfScheduledReads || !this->Deferred.empty())
+    {
+    // make the reads of this round
+    if (this->NumberOfScheduledReads)
+      {
+      this->NumberOfScheduledReads = 0;
+      if (adios_perform_reads(this->File, 1))
+        {
+        SENSEI_ERROR("Failed to perform the scheduled reads")
+        ierr = -1;
+        }
+
+      size_t n_selections = this->Selections.size();
+      for (size_t i = 0; i < n_selections; ++i)
+        adios_selection_delete(this->Selections[i]);
+      this->Selections.clear();
+      }
+
+    // pass the values to the functions waiting on them, which may
+    // schedule the reads of the next round. after an error the values
+    // can't be trusted and the functions are discarded. their buffers
+    // are no longer needed since the reads that use them have been made
+    std::vector<std::function<int()>> deferred;
+    deferred.swap(this->Deferred);
+
+    size_t n_deferred = deferred.size();
+    for (size_t i = 0; !ierr && (i < n_deferred); ++i)
+      {
+      if (deferred[i]() || this->ReadError)
+        ierr = -1;
+      }
+    }
+
+  this->ReadError = 0;
+
+  return ierr;
+}
+
 }
@@ -8,9 +8,12 @@ typedef struct _ADIOS_FILE ADIOS_FILE;
 #include <adios_read.h>
 #include <vtkDataObject.h>
 #include <mpi.h>
+#include <map>
 #include <set>
 #include <cstdint>
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace senseiADIOS
@@ -18,6 +21,57 @@ namespace senseiADIOS
 
 struct InputStream;
 
+/// Methods of assigning the datasets written to the ranks reading them.
+// Contiguous assigns each rank a range of dataset ids, round robin deals
+// the ids out in turn, and balanced assigns the datasets largest first,
+// each to the rank with the fewest bytes so far.
+enum BlockAssignment
+{
+  BLOCK_ASSIGNMENT_CONTIGUOUS = 0,
+  BLOCK_ASSIGNMENT_ROUND_ROBIN,
+  BLOCK_ASSIGNMENT_BALANCED
+};
+
+/// Stages of the compression of the data arrays written.
+// The stages applied to an array are recorded in the stream with its
+// compressed size. They are applied in the order quantize, shuffle, lz,
+// and reversed when the array is read. Quantize is lossy, it applies to
+// float and double arrays and keeps the values within a tolerance of
+// the originals. See CompressionKernels.
+enum CompressionStage
+{
+  COMPRESSION_NONE = 0,
+  COMPRESSION_SHUFFLE = 1,
+  COMPRESSION_LZ = 2,
+  COMPRESSION_QUANTIZE = 4
+};
+
+/// The compression of a data array.
+struct CompressionSpec
+{
+  CompressionSpec() : Stages(COMPRESSION_NONE), Tolerance(0.0) {}
+
+  int Stages;
+  double Tolerance;
+};
+
+/// Totals of the data arrays compressed.
+struct CompressionStatistics
+{
+  CompressionStatistics() : RawBytes(0), CompressedBytes(0), Time(0.0) {}
+
+  void Add(const CompressionStatistics &other)
+  {
+    this->RawBytes += other.RawBytes;
+    this->CompressedBytes += other.CompressedBytes;
+    this->Time += other.Time;
+  }
+
+  uint64_t RawBytes;
+  uint64_t CompressedBytes;
+  double Time;
+};
+
 /// ADIOS representation of collections of vtkDataObject
 // This class provides the user facing API managing the lower level
 // objects internally. The write API defines variables needed for the
@@ -36,6 +90,9 @@ public:
     const std::vector<std::string> &object_names,
     const std::vector<vtkDataObject*> &objects);
 
+  // returns the number of bytes written by Write. the size is cached and
+  // reused while the number, types, and sizes of the datasets and arrays
+  // are unchanged. returns (uint64_t)-1 on error
   uint64_t GetSize(MPI_Comm comm, const std::vector<std::string> &object_names,
     const std::vector<vtkDataObject*> &objects);
 
@@ -64,10 +121,40 @@ public:
     const std::string &object_name, vtkDataObject *dobj, int association,
     const std::string &array_name);
 
+  // read a set of arrays from disk(or stream), store them into the mesh.
+  // the reads of all of the arrays are made together
+  int ReadArrays(MPI_Comm comm, InputStream &iStream,
+    const std::string &object_name, vtkDataObject *dobj, int association,
+    const std::vector<std::string> &array_names);
+
   // returns the current time and time step
   int ReadTimeStep(MPI_Comm comm, InputStream &iStream,
     unsigned long &time_step, double &time);
 
+  // restricts the reads of the named object to a region of interest,
+  // given as x0 x1 y0 y1 z0 z1. datasets outside of the region are
+  // skipped and image data is cropped to it. see RegionOfInterest
+  void SetRegionOfInterest(const std::string &object_name,
+    const double bounds[6]);
+
+  // removes all regions of interest
+  void ClearRegionsOfInterest();
+
+  // sets how the datasets are assigned to the ranks reading them, one
+  // of the BlockAssignment values. the default is contiguous
+  void SetBlockAssignment(int method);
+
+  // compresses the named point or cell data arrays as they are written.
+  // an empty name applies to the arrays of the association that have no
+  // compression of their own. must be set before the variables are
+  // defined
+  void SetCompression(int association, const std::string &array_name,
+    const CompressionSpec &spec);
+
+  // gets the totals of the arrays compressed since the last call. this
+  // may be called while another thread writes
+  void TakeCompressionStatistics(CompressionStatistics &stats);
+
 private:
   // given a name get the id
   int GetObjectId(MPI_Comm comm, InputStream &iStream,
@@ -77,6 +164,28 @@ private:
   InternalsType *Internals;
 };
 
+/// ADIOS variable paths of the datasets written by a schema.
+// The paths are built once, when the variables are defined, and looked
+// up by data object and dataset id when a step is written so that the
+// write path does no string formatting or allocation.
+class PathCache
+{
+public:
+  using PathList = std::vector<std::string>;
+
+  // returns the list of paths of the given dataset, emptied, for the
+  // caller to fill in
+  PathList &Define(unsigned int doid, unsigned int dsid);
+
+  // returns the paths of the given dataset or nullptr if none were
+  // defined
+  const PathList *Find(unsigned int doid, unsigned int dsid) const;
+
+private:
+  using KeyType = std::pair<unsigned int, unsigned int>;
+  std::map<KeyType, PathList> Paths;
+};
+
 /// Base class for representing VTK data in ADIOS.
 // the 3 operations that need to be done to send data to ADIOS are:
 //
@@ -91,6 +200,11 @@ private:
 // is traversing the vtkDataObject and operating on leaf nodes. This
 // class provides default methods that traverse the DataObject and call
 // a DataSet overload provided by concrete implementations.
+//
+// The reads of the lower level schema are scheduled on the InputStream
+// and are made when the stream's PerformReads is called, so that the
+// reads of many datasets and arrays are made together. The values read
+// are stored in the datasets at that time.
 class Schema
 {
 public:
@@ -120,6 +234,10 @@ public:
 
   virtual int Read(MPI_Comm comm, InputStream &iStream,
     unsigned int doid, unsigned int id, vtkDataSet *&ds);
+
+protected:
+  // paths of the variables defined by this schema
+  PathCache Paths;
 };
 
 /// ADIOS representation of vtkDataObject
@@ -158,10 +276,20 @@ public:
     unsigned int doid, vtkDataObject *dobj, int association,
     std::set<std::string> &array_names);
 
-  // read a single array from disk(or stream), store it into the mesh
-  int ReadArray(MPI_Comm comm, InputStream &iStream,
+  // read a set of arrays from disk(or stream), store them into the mesh
+  int ReadArrays(MPI_Comm comm, InputStream &iStream,
     unsigned int doid, vtkDataObject *dobj, int association,
-    const std::string &name);
+    const std::vector<std::string> &names);
+
+  // sets how the datasets are assigned to the ranks reading them
+  void SetBlockAssignment(int method);
+
+  // compresses the named point or cell data arrays as they are written
+  void SetCompression(int association, const std::string &array_name,
+    const CompressionSpec &spec);
+
+  // adds the totals of the arrays compressed since the last call
+  void TakeCompressionStatistics(CompressionStatistics &stats);
 
 private:
   // create data object
@@ -218,15 +346,27 @@ public:
   int ReadArrayNames(MPI_Comm comm, InputStream &iStream, unsigned int doid,
     vtkDataObject *dobj, int association, std::set<std::string> &array_names);
 
-  // read a single array from disk(or stream), store it into the mesh
-  int ReadArray(MPI_Comm comm, InputStream &iStream, unsigned int doid,
-    vtkDataObject *dobj, int association, const std::string &name);
+  // read a set of arrays from disk(or stream), store them into the mesh
+  int ReadArrays(MPI_Comm comm, InputStream &iStream, unsigned int doid,
+    vtkDataObject *dobj, int association,
+    const std::vector<std::string> &names);
 
   // define the local domain decomposition by a start data object id
   // and length.
   void SetDecomp(unsigned int id, unsigned int n);
+  void AddDecomp(unsigned int id);
   void ClearDecomp();
 
+  // returns the number of bytes written for the dataset
+  uint64_t GetNumberOfBytes(vtkDataSet *ds);
+
+  // compresses the named point or cell data arrays as they are written
+  void SetCompression(int association, const std::string &array_name,
+    const CompressionSpec &spec);
+
+  // adds the totals of the arrays compressed since the last call
+  void TakeCompressionStatistics(CompressionStatistics &stats);
+
 private:
   struct InternalsType;
   InternalsType *Internals;
@@ -301,6 +441,14 @@ public:
     const std::string &array_name, unsigned int doid, unsigned int dsid,
     vtkDataSet *ds);
 
+  // compresses the named array as it is written, an empty name applies
+  // to the arrays with no compression of their own
+  void SetCompression(const std::string &array_name,
+    const CompressionSpec &spec);
+
+  // adds the totals of the arrays compressed since the last call
+  void TakeCompressionStatistics(CompressionStatistics &stats);
+
 private:
   struct InternalsType;
   InternalsType *Internals;
@@ -376,14 +524,58 @@ public:
   static unsigned long GetNumberOfPoints(vtkDataSet *ds);
 };
 
+/// A region of interest in the reads of a data object.
+// Datasets whose bounds do not intersect the region are not read, and
+// image data is cropped to the points inside it. The extents of cropped
+// datasets, as stored in the stream and as read, are recorded when
+// their geometry is read and used to select the values of their arrays.
+struct RegionOfInterest
+{
+  struct Crop
+  {
+    int Extent[6];
+    int SubExtent[6];
+  };
+
+  using KeyType = std::pair<unsigned int, unsigned int>;
+
+  // returns true when no region is set
+  bool Empty() const { return this->Bounds.empty(); }
+
+  // returns true if the given bounds intersect the region
+  bool Intersects(const double bounds[6]) const;
+
+  // computes the part of an image dataset inside the region and records
+  // it if the dataset is cropped
+  void Select(unsigned int doid, unsigned int dsid, const int extent[6],
+    const double origin[3], const double spacing[3], int sub_extent[6]);
+
+  // returns the extents of a cropped dataset, or nullptr if the dataset
+  // is read whole
+  const Crop *Find(unsigned int doid, unsigned int dsid) const;
+
+  // forgets the extents of the datasets of the given object
+  void Clear(unsigned int doid);
+
+  std::vector<double> Bounds;
+  std::map<KeyType, Crop> Crops;
+};
+
 /// High level operations on an ADIOS file/stream
+// Reads are made in rounds. The reads scheduled in a round are made
+// together by one call to adios_perform_reads, after which the functions
+// deferred in the round are called in the order they were queued. These
+// may use the values read to schedule the reads of the next round, for
+// instance reading the size of an array and then its contents.
 struct InputStream
 {
   InputStream() : File(nullptr),
-    ReadMethod(static_cast<ADIOS_READ_METHOD>(-1)) {}
+    ReadMethod(static_cast<ADIOS_READ_METHOD>(-1)), Selection(nullptr),
+    NumberOfScheduledReads(0), ReadError(0), Revision(0) {}
 
   InputStream(ADIOS_FILE *file, ADIOS_READ_METHOD method)
-    : File(file), ReadMethod(method) {}
+    : File(file), ReadMethod(method), Selection(nullptr),
+    NumberOfScheduledReads(0), ReadError(0), Revision(0) {}
 
   int Open(MPI_Comm comm, ADIOS_READ_METHOD method,
     const std::string &fileName);
@@ -395,8 +587,46 @@ struct InputStream
 
   int Close();
 
+  // schedules a read of the variable at path into buf. buf must remain
+  // valid until the read is made
+  int ScheduleRead(const std::string &path, void *buf);
+
+  // schedules a read of count elements of the variable at path starting
+  // at element start
+  int ScheduleRead(const std::string &path, uint64_t start, uint64_t count,
+    void *buf);
+
+  // with staging methods the variables of a dataset are read from the
+  // block of the rank that wrote it. the other variables are written by
+  // all ranks and are read from the block of rank 0
+  void SetDatasetWriter(unsigned int doid, unsigned int dsid, int writer);
+  void ClearDatasetWriters(unsigned int doid);
+
+  // returns the selection for reading the variable at path
+  ADIOS_SELECTION *GetSelection(const std::string &path);
+
+  // queues a function to be called once the reads of the current round
+  // are made. the function should hold on to the buffers of the reads
+  // it depends on
+  void Defer(const std::function<int()> &func);
+
+  // makes the scheduled reads and calls the deferred functions, round
+  // by round, until none remain. when an error occurs the remaining
+  // reads are made but the deferred functions are discarded.
+  int PerformReads();
+
   ADIOS_FILE *File;
   ADIOS_READ_METHOD ReadMethod;
+  ADIOS_SELECTION *Selection;
+  unsigned int NumberOfScheduledReads;
+  int ReadError;
+  // the schema revision of the current time step, read with its time
+  unsigned int Revision;
+  std::vector<std::function<int()>> Deferred;
+  std::vector<ADIOS_SELECTION*> Selections;
+  RegionOfInterest Region;
+  std::map<std::pair<unsigned int, unsigned int>, int> DatasetWriters;
+  std::map<int, ADIOS_SELECTION*> WriteBlocks;
 };
 
 }
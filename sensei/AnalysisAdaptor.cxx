@@ -23,6 +23,18 @@ int AnalysisAdaptor::SetCommunicator(MPI_Comm comm)
   return 0;
 }
 
+//----------------------------------------------------------------------------
+int AnalysisAdaptor::WriteCheckpoint(const std::string &)
+{
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int AnalysisAdaptor::ReadCheckpoint(const std::string &)
+{
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 void AnalysisAdaptor::PrintSelf(ostream& os, vtkIndent indent)
 {
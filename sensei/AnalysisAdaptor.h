@@ -4,6 +4,7 @@
 #include "senseiConfig.h"
 #include <vtkObjectBase.h>
 #include <mpi.h>
+#include <string>
 
 namespace sensei
 {
@@ -46,6 +47,25 @@ public:
   /// @returns zero if successful
   virtual int Finalize() = 0;
 
+  /// @brief Save the state of the analysis.
+  ///
+  /// Analyses that accumulate state across iterations override this to
+  /// save it to the named file so that a restarted run may resume where
+  /// this one left off. This is a collective call. The default does
+  /// nothing.
+  ///
+  /// @returns zero if successful
+  virtual int WriteCheckpoint(const std::string &fileName);
+
+  /// @brief Restore the state of the analysis.
+  ///
+  /// Restores state saved by WriteCheckpoint. This is called after the
+  /// analysis has been initialized and before the first Execute. This is
+  /// a collective call. The default does nothing.
+  ///
+  /// @returns zero if successful
+  virtual int ReadCheckpoint(const std::string &fileName);
+
 protected:
   AnalysisAdaptor();
   ~AnalysisAdaptor();
@@ -1,4 +1,6 @@
+#include "senseiConfig.h"
 #include "Autocorrelation.h"
+#include "AutocorrelationKernels.h"
 
 #include "DataAdaptor.h"
 #include "Error.h"
@@ -6,21 +8,31 @@
 // VTK includes
 #include <vtkCompositeDataIterator.h>
 #include <vtkCellData.h>
+#include <vtkDataArray.h>
 #include <vtkFieldData.h>
-#include <vtkFloatArray.h>
 #include <vtkImageData.h>
 #include <vtkMultiBlockDataSet.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 #include <vtkStructuredData.h>
 #include <vtkUnsignedCharArray.h>
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+#include <vtkAOSDataArrayTemplate.h>
+#include <vtkArrayDispatch.h>
+#else
+#include <vtkDataArrayDispatcher.h>
+#include <vtkDataArrayTemplate.h>
+#endif
 
+#include <cfloat>
 #include <memory>
+#include <queue>
+#include <sstream>
 #include <vector>
 
 #include <diy/master.hpp>
-#include <diy/reduce.hpp>
-#include <diy/partners/merge.hpp>
+#include <diy/storage.hpp>
+#include <diy/io/block.hpp>
 #include <diy/io/numpy.hpp>
 #include <grid/grid.h>
 #include <grid/vertices.h>
@@ -34,27 +46,6 @@ std::unique_ptr<T> make_unique(Args&& ...args)
   return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
 }
 
-template<class T>
-struct add_vectors
-{
-    using Vector = std::vector<T>;
-    Vector  operator()(const Vector& lhs, const Vector& rhs) const
-    {
-      Vector res(lhs.size(), 0);
-      for (size_t i = 0; i < lhs.size(); ++i)
-        res[i] = lhs[i] + rhs[i];
-      return res;
-    }
-};
-
-namespace diy { namespace mpi { namespace detail {
-template<class U> struct mpi_op<add_vectors<U>>
-{
-  static MPI_Op get()
-  { return MPI_SUM; }
-};
-}}}
-
 namespace sensei
 {
 
@@ -62,89 +53,220 @@ using GridRef = grid::GridRef<float,3>;
 using Vertex  = GridRef::Vertex;
 using Vertex4D = Vertex::UPoint;
 
+// A is the type used to store and accumulate the correlations
+template <typename A>
 struct AutocorrelationImpl
 {
-  using Grid = grid::Grid<float,4>;
-  AutocorrelationImpl(size_t window_, int gid_, Vertex from_, Vertex to_):
+  using Grid = grid::Grid<A,4>;
+  AutocorrelationImpl(size_t window_, int gid_, Vertex from_, Vertex to_, bool fft_ = false):
     window(window_),
     gid(gid_),
     from(from_), to(to_),
     shape(to - from + Vertex::one()),
-    // init grid with (to - from + 1) in 3D, and window in the 4-th dimension
-    values(shape.lift(3, window)),
+    fft(fft_),
+    nfft(fft ? AutocorrelationKernels::FFTLength(window) : window),
+    // init grid with (to - from + 1) in 3D, and window in the 4-th dimension.
+    // the fft engine's history holds nfft steps
+    values(shape.lift(3, nfft)),
     corr(shape.lift(3, window))
-  { corr = 0; }
+  {
+    // the fft engine correlates each chunk against the whole history,
+    // the steps before the first are zeros
+    values = 0;
+    corr = 0;
+  }
 
   static void* create()            { return new AutocorrelationImpl; }
   static void destroy(void* b)    { delete static_cast<AutocorrelationImpl*>(b); }
-  void process(float* data, unsigned char *ghostArray)
+
+  // serializers used by Master to move blocks in and out of core
+  static void save(const void* b_, diy::BinaryBuffer& bb)
     {
-    GridRef g(data, shape);
+    const AutocorrelationImpl* b = static_cast<const AutocorrelationImpl*>(b_);
+    diy::save(bb, b->window);
+    diy::save(bb, b->gid);
+    diy::save(bb, b->from);
+    diy::save(bb, b->to);
+    diy::save(bb, b->fft);
+    diy::save(bb, b->nfft);
+    diy::save(bb, b->offset);
+    diy::save(bb, b->count);
+    diy::save(bb, b->values.data(), b->values.size());
+    diy::save(bb, b->corr.data(), b->corr.size());
+    }
 
-    if (ghostArray)
+  static void load(void* b_, diy::BinaryBuffer& bb)
+    {
+    AutocorrelationImpl* b = static_cast<AutocorrelationImpl*>(b_);
+    diy::load(bb, b->window);
+    diy::load(bb, b->gid);
+    diy::load(bb, b->from);
+    diy::load(bb, b->to);
+    diy::load(bb, b->fft);
+    diy::load(bb, b->nfft);
+    diy::load(bb, b->offset);
+    diy::load(bb, b->count);
+    b->shape = b->to - b->from + Vertex::one();
+    Grid values(b->shape.lift(3, b->nfft));
+    Grid corr(b->shape.lift(3, b->window));
+    b->values.swap(values);
+    b->corr.swap(corr);
+    diy::load(bb, b->values.data(), b->values.size());
+    diy::load(bb, b->corr.data(), b->corr.size());
+    }
+  template <typename T>
+  void process(const T* data, const unsigned char *ghostArray)
+    {
+    // the window is the slowest varying dimension of values and corr,
+    // each shift is a contiguous run over the voxels
+    if (fft)
       {
-      grid::GridRef<unsigned char, 3> ghost(ghostArray, shape);
-      // record the values
-      grid::for_each(g.shape(), [&](const Vertex& v)
-        {
-        auto gv = (ghost(v) == 0) ? g(v) : 0;
-
-        for (size_t i = 1; i <= window; ++i)
-        {
-        if (i > count) continue;    // during the initial fill, we don't get contributions to some shifts
-
-        auto uc = v.lift(3, i-1);
-        auto uv = v.lift(3, (offset + window - i) % window);
-        corr(uc) += values(uv)*gv;
-        }
+      // buffer the step and correlate once the chunk is full
+      AutocorrelationKernels::Record(data, ghostArray, values.size()/nfft,
+        window, offset, values.data());
 
-        auto u = v.lift(3, offset);
-        values(u) = gv;
-        });
+      if (++offset == nfft - window)
+        flush();
       }
     else
       {
-      // record the values
-      grid::for_each(g.shape(), [&](const Vertex& v)
-        {
-        auto gv = g(v);
+      AutocorrelationKernels::Update(data, ghostArray, values.size()/window,
+        window, offset, count, values.data(), corr.data());
 
-        for (size_t i = 1; i <= window; ++i)
-        {
-        if (i > count) continue;    // during the initial fill, we don't get contributions to some shifts
-
-        auto uc = v.lift(3, i-1);
-        auto uv = v.lift(3, (offset + window - i) % window);
-        corr(uc) += values(uv)*gv;
-        }
-
-        auto u = v.lift(3, offset);
-        values(u) = gv;
-        });
+      offset += 1;
+      offset %= window;
       }
-    offset += 1;
-    offset %= window;
 
     ++count;
     }
 
+  // correlate the steps buffered by the fft engine
+  void flush()
+    {
+    if (!fft)
+      return;
+
+    AutocorrelationKernels::Correlate(values.data(), values.size()/nfft,
+      window, nfft, offset, corr.data());
+
+    offset = 0;
+    }
+
   size_t          window;
   int             gid;
   Vertex          from, to, shape;
-  Grid            values;     // circular buffer of last `window` values
+  bool            fft;        // use the fft engine
+  size_t          nfft;       // length of the history
+  Grid            values;     // circular buffer of last `window` values, or the fft engine's history
   Grid            corr;       // autocorrelations for different time shifts
 
-  size_t          offset = 0;
+  size_t          offset = 0; // buffer slot, or the number of steps in the fft engine's chunk
   size_t          count  = 0;
 
 private:
   AutocorrelationImpl() {}        // here just for create; to let Master manage the blocks (+ if we choose to add OOC later)
 };
 
+// One of the strongest correlations of a shift. Lists of these are
+// exchanged as bytes. Unused entries have the value -DBL_MAX.
+struct Extremum
+{
+  double Value;
+  int Point[3];
+};
+
+// Merges lists of k extrema sorted in descending order into one, keeping
+// the k largest. The heads of the lists are held in a heap and each entry
+// costs one heap update.
+void MergeExtrema(const std::vector<const Extremum*> &lists, size_t k,
+  Extremum *out)
+{
+  using Head = std::pair<double, size_t>;
+  std::priority_queue<Head> heads;
+  std::vector<size_t> pos(lists.size(), 0);
+  for (size_t l = 0; l < lists.size(); ++l)
+    if (k > 0)
+      heads.push(Head(lists[l][0].Value, l));
+
+  for (size_t i = 0; i < k; ++i)
+    {
+    size_t l = heads.top().second;
+    heads.pop();
+    out[i] = lists[l][pos[l]];
+    if (++pos[l] < k)
+      heads.push(Head(lists[l][pos[l]].Value, l));
+    }
+}
+
+// Assigns the blocks of a checkpoint to the ranks that hold the same
+// blocks now. The simulation's decomposition must not have changed.
+class CheckpointAssigner : public diy::Assigner
+{
+public:
+  CheckpointAssigner(int size, int rank, const std::vector<int> &gids) :
+    diy::Assigner(size, 0), Rank(rank), Gids(gids) {}
+
+  void local_gids(int, std::vector<int>& gids) const override
+  {
+    // blocks that are not in the checkpoint are not read, and the
+    // checkpoint is then rejected
+    for (size_t i = 0; i < this->Gids.size(); ++i)
+      if (this->Gids[i] < this->nblocks())
+        gids.push_back(this->Gids[i]);
+  }
+
+  int rank(int gid) const override
+  {
+    return std::find(this->Gids.begin(), this->Gids.end(), gid)
+      == this->Gids.end() ? -1 : this->Rank;
+  }
+
+private:
+  int Rank;
+  std::vector<int> Gids;
+};
+
+// Private worker that passes an array's values to a block. Arrays of
+// the common types are processed in place, others are copied.
+template <typename A>
+struct ProcessWorker
+{
+  ProcessWorker(AutocorrelationImpl<A> *block, const unsigned char *ghost) :
+    Block(block), Ghost(ghost) {}
+
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+  template <typename T>
+  void operator()(vtkAOSDataArrayTemplate<T> *array)
+  {
+    this->Block->process(array->GetPointer(0), this->Ghost);
+  }
+
+  template <typename ArrayT>
+  void operator()(ArrayT *array)
+  {
+    vtkIdType numTuples = array->GetNumberOfTuples();
+    std::vector<A> tmp(numTuples);
+    for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
+      tmp[tIdx] = static_cast<A>(array->GetComponent(tIdx, 0));
+    this->Block->process(tmp.data(), this->Ghost);
+  }
+#else
+  template <typename T>
+  void operator()(const vtkDataArrayDispatcherPointer<T>& array)
+  {
+    this->Block->process(array.RawPointer, this->Ghost);
+  }
+#endif
+
+  AutocorrelationImpl<A> *Block;
+  const unsigned char *Ghost;
+};
+
 //-----------------------------------------------------------------------------
 class Autocorrelation::AInternals
 {
 public:
+  std::unique_ptr<diy::FileStorage> Storage;
   std::unique_ptr<diy::Master> Master;
   size_t KMax;
   std::string MeshName;
@@ -152,21 +274,168 @@ public:
   std::string ArrayName;
   size_t Window;
   bool BlocksInitialized;
-  size_t NumberOfBlocks;
+  bool DoublePrecision;
+  int Threads;
+  int Engine;
+  int BlockLimit;
+  std::string StoragePath;
+  MPI_Comm Comm;
+  long ReportInterval;
+  long StepCount;
+
+  // a report of the correlations in flight to rank 0
+  bool SnapshotPending;
+  long SnapshotStep;
+  std::vector<double> SendSums;
+  std::vector<double> RecvSums;
+  std::vector<Extremum> SendMax;
+  std::vector<Extremum> RecvMax;
+  MPI_Request SnapshotRequests[2];
+
+  // a checkpoint to restore the blocks from
+  std::string CheckpointFile;
+
+  // the extent of a local block
+  struct BlockExtent
+  {
+    int Gid;
+    Vertex From;
+    Vertex To;
+  };
+
+  // the arrays of the local blocks, indexed by local id
+  struct BlockArrays
+  {
+    vtkDataArray* Array;
+    vtkUnsignedCharArray* Ghost;
+  };
+  std::vector<BlockArrays> Inputs;
+
   AInternals() :
     KMax(3),
     Association(vtkDataObject::POINT),
     Window(10),
     BlocksInitialized(false),
-    NumberOfBlocks(0)
+    DoublePrecision(false),
+    Threads(1),
+    Engine(Autocorrelation::ENGINE_DIRECT),
+    BlockLimit(-1),
+    StoragePath("/tmp"),
+    Comm(MPI_COMM_WORLD),
+    ReportInterval(0),
+    StepCount(0),
+    SnapshotPending(false),
+    SnapshotStep(0),
+    SnapshotRequests{MPI_REQUEST_NULL, MPI_REQUEST_NULL}
   {}
 
+  ~AInternals()
+    {
+    if (this->SnapshotPending)
+      MPI_Waitall(2, this->SnapshotRequests, MPI_STATUSES_IGNORE);
+    }
+
+  template <typename A>
+  void CreateMaster(MPI_Comm comm)
+    {
+    if (this->BlockLimit > 0)
+      {
+      // blocks beyond the limit are swapped out to files
+      this->Storage = make_unique<diy::FileStorage>(
+        this->StoragePath + "/sensei_autocorrelation.XXXXXX");
+
+      this->Master = make_unique<diy::Master>(comm, this->Threads, this->BlockLimit,
+                                              &AutocorrelationImpl<A>::create,
+                                              &AutocorrelationImpl<A>::destroy,
+                                              this->Storage.get(),
+                                              &AutocorrelationImpl<A>::save,
+                                              &AutocorrelationImpl<A>::load);
+      }
+    else
+      {
+      this->Master = make_unique<diy::Master>(comm, this->Threads, -1,
+                                              &AutocorrelationImpl<A>::create,
+                                              &AutocorrelationImpl<A>::destroy);
+      }
+    }
+
+  void AddBlock(int bid, const Vertex &from, const Vertex &to)
+    {
+    void* b = nullptr;
+    bool fft = this->Engine == Autocorrelation::ENGINE_FFT;
+    if (this->DoublePrecision)
+      b = new AutocorrelationImpl<double>(this->Window, bid, from, to, fft);
+    else
+      b = new AutocorrelationImpl<float>(this->Window, bid, from, to, fft);
+    this->Master->add(bid, b, new diy::Link);
+    }
+
+  // update the correlations of the local blocks with their arrays'
+  // values, which are used in place. the blocks are independent and
+  // are processed by Master's threads
+  template <typename A>
+  void ProcessBlocks()
+    {
+    this->Master->foreach<AutocorrelationImpl<A>>(
+      [this](AutocorrelationImpl<A>* b, const diy::Master::ProxyWithLink& cp, void*)
+      {
+      const BlockArrays &in = this->Inputs[this->Master->lid(cp.gid())];
+      if (!in.Array)
+        return;
+
+      ProcessWorker<A> worker(b, in.Ghost ? in.Ghost->GetPointer(0) : nullptr);
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+      if (!vtkArrayDispatch::Dispatch::Execute(in.Array, worker))
+        worker(in.Array);
+#else
+      vtkDataArrayDispatcher<ProcessWorker<A>> dispatcher(worker);
+      dispatcher.Go(in.Array);
+#endif
+      });
+    }
+
+  void ProcessBlocks()
+    {
+    if (this->DoublePrecision)
+      this->ProcessBlocks<double>();
+    else
+      this->ProcessBlocks<float>();
+    }
+
+  template <typename A>
+  void StartSnapshot(long step);
+
+  void StartSnapshot(long step)
+    {
+    if (this->DoublePrecision)
+      this->StartSnapshot<double>(step);
+    else
+      this->StartSnapshot<float>(step);
+    }
+
+  bool FinishSnapshot(bool wait);
+  void ReportSnapshot();
+
+  template <typename A>
+  int WriteBlocks(const std::string &fileName);
+
+  template <typename A>
+  int ReadBlocks(const std::vector<BlockExtent> &blocks);
+
+  int ReadBlocks(const std::vector<BlockExtent> &blocks)
+    {
+    if (this->DoublePrecision)
+      return this->ReadBlocks<double>(blocks);
+    return this->ReadBlocks<float>(blocks);
+    }
+
   void InitializeBlocks(vtkDataObject* dobj)
     {
     if (this->BlocksInitialized)
       {
       return;
       }
+    std::vector<BlockExtent> blocks;
     if (vtkImageData* img = vtkImageData::SafeDownCast(dobj))
       {
       int ext[6];
@@ -182,9 +451,7 @@ public:
       Vertex from { ext[0], ext[2], ext[4] };
       Vertex to   { ext[1], ext[3], ext[5] };
       int bid = this->Master->communicator().rank();
-      AutocorrelationImpl* b = new AutocorrelationImpl(this->Window, bid, from, to);
-      this->Master->add(bid, b, new diy::Link);
-      this->NumberOfBlocks = this->Master->communicator().size();
+      blocks.push_back({bid, from, to});
       }
     else if (vtkCompositeDataSet* cd = vtkCompositeDataSet::SafeDownCast(dobj))
       {
@@ -211,12 +478,18 @@ public:
           Vertex from { ext[0], ext[2], ext[4] };
           Vertex to   { ext[1], ext[3], ext[5] };
 
-          AutocorrelationImpl* b = new AutocorrelationImpl(this->Window, bid, from, to);
-          this->Master->add(bid, b, new diy::Link);
+          blocks.push_back({bid, from, to});
           }
         }
-      this->NumberOfBlocks = bid;
       }
+
+    // restore the blocks from a checkpoint, or start afresh
+    if (this->CheckpointFile.empty() || this->ReadBlocks(blocks))
+      {
+      for (size_t i = 0; i < blocks.size(); ++i)
+        this->AddBlock(blocks[i].Gid, blocks[i].From, blocks[i].To);
+      }
+
     this->BlocksInitialized = true;
     }
 };
@@ -236,6 +509,42 @@ Autocorrelation::~Autocorrelation()
   delete this->Internals;
 }
 
+//-----------------------------------------------------------------------------
+void Autocorrelation::SetDoublePrecision(bool val)
+{
+  this->Internals->DoublePrecision = val;
+}
+
+//-----------------------------------------------------------------------------
+void Autocorrelation::SetEngine(int val)
+{
+  this->Internals->Engine = val;
+}
+
+//-----------------------------------------------------------------------------
+void Autocorrelation::SetBlockLimit(int val)
+{
+  this->Internals->BlockLimit = val;
+}
+
+//-----------------------------------------------------------------------------
+void Autocorrelation::SetStoragePath(const std::string &path)
+{
+  this->Internals->StoragePath = path;
+}
+
+//-----------------------------------------------------------------------------
+void Autocorrelation::SetReportInterval(long val)
+{
+  this->Internals->ReportInterval = val;
+}
+
+//-----------------------------------------------------------------------------
+void Autocorrelation::SetThreads(int val)
+{
+  this->Internals->Threads = val;
+}
+
 //-----------------------------------------------------------------------------
 void Autocorrelation::Initialize(size_t window, const std::string &meshName,
   int association, const std::string &arrayname, size_t kmax)
@@ -243,14 +552,16 @@ void Autocorrelation::Initialize(size_t window, const std::string &meshName,
   timer::MarkEvent mark("Autocorrelation::Initialize");
 
   AInternals& internals = (*this->Internals);
-  internals.Master = make_unique<diy::Master>(this->GetCommunicator(), -1, -1,
-                                              &AutocorrelationImpl::create,
-                                              &AutocorrelationImpl::destroy);
+  if (internals.DoublePrecision)
+    internals.CreateMaster<double>(this->GetCommunicator());
+  else
+    internals.CreateMaster<float>(this->GetCommunicator());
   internals.MeshName = meshName;
   internals.Association = association;
   internals.ArrayName = arrayname;
   internals.Window = window;
   internals.KMax = kmax;
+  internals.Comm = this->GetCommunicator();
 }
 
 //-----------------------------------------------------------------------------
@@ -292,6 +603,9 @@ bool Autocorrelation::Execute(DataAdaptor* data)
 
   internals.InitializeBlocks(mesh);
 
+  // find the arrays of the local blocks
+  internals.Inputs.assign(internals.Master->size(), {nullptr, nullptr});
+
   if (vtkCompositeDataSet* cd = vtkCompositeDataSet::SafeDownCast(mesh))
     {
     vtkSmartPointer<vtkCompositeDataIterator> iter;
@@ -303,20 +617,19 @@ bool Autocorrelation::Execute(DataAdaptor* data)
       {
       if (vtkDataSet* dataObj = vtkDataSet::SafeDownCast(iter->GetCurrentDataObject()))
         {
-        int lid = internals.Master->lid(static_cast<int>(bid));
-        AutocorrelationImpl* corr = internals.Master->block<AutocorrelationImpl>(lid);
-        vtkFloatArray* fa = vtkFloatArray::SafeDownCast(
-          dataObj->GetAttributesAsFieldData(association)->GetArray(internals.ArrayName.c_str()));
+        vtkDataArray* da = dataObj->GetAttributesAsFieldData(association)->GetArray(
+          internals.ArrayName.c_str());
         vtkUnsignedCharArray *gc = vtkUnsignedCharArray::SafeDownCast(
           dataObj->GetCellData()->GetArray("vtkGhostType"));
-        if (fa)
+        if (da)
           {
-          corr->process(fa->GetPointer(0), gc ? gc->GetPointer(0) : nullptr);
+          internals.Inputs[internals.Master->lid(bid)] = {da, gc};
           }
         else
           {
-          SENSEI_ERROR("Current implementation only supports float arrays")
-          abort();
+          SENSEI_ERROR("Block " << bid << " has no array \""
+            << internals.ArrayName << "\"")
+          return false;
           }
         }
       }
@@ -324,130 +637,428 @@ bool Autocorrelation::Execute(DataAdaptor* data)
   else if (vtkDataSet* ds = vtkDataSet::SafeDownCast(mesh))
     {
     int bid = internals.Master->communicator().rank();
-    int lid = internals.Master->lid(static_cast<int>(bid));
-    AutocorrelationImpl* corr = internals.Master->block<AutocorrelationImpl>(lid);
-    vtkFloatArray* fa = vtkFloatArray::SafeDownCast(
-      ds->GetAttributesAsFieldData(association)->GetArray(internals.ArrayName.c_str()));
+    vtkDataArray* da = ds->GetAttributesAsFieldData(association)->GetArray(
+      internals.ArrayName.c_str());
     vtkUnsignedCharArray *gc = vtkUnsignedCharArray::SafeDownCast(
-      ds->GetCellData()->GetArray("vtkGhostType"));       
-    if (fa)
+      ds->GetCellData()->GetArray("vtkGhostType"));
+    if (da)
+      {
+      internals.Inputs[internals.Master->lid(bid)] = {da, gc};
+      }
+    else
+      {
+      SENSEI_ERROR("Block " << bid << " has no array \""
+        << internals.ArrayName << "\"")
+      return false;
+      }
+    }
+
+  internals.ProcessBlocks();
+
+  ++internals.StepCount;
+
+  // report the previous snapshot if its transfers have completed, and
+  // start the next one every ReportInterval steps. a snapshot in flight
+  // is completed before a new one starts
+  internals.FinishSnapshot(false);
+  if ((internals.ReportInterval > 0) &&
+    ((internals.StepCount % internals.ReportInterval) == 0))
+    {
+    internals.FinishSnapshot(true);
+    internals.StartSnapshot(internals.StepCount);
+    }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+template <typename A>
+void Autocorrelation::AInternals::StartSnapshot(long step)
+{
+  timer::MarkEvent mark("autocorrelation::start snapshot");
+
+  // find the sums and the k strongest correlations of each shift in
+  // each local block. the blocks are processed by Master's threads
+  size_t window = this->Window;
+  size_t k = this->KMax;
+  size_t nLocal = this->Master->size();
+  std::vector<std::vector<double>> blockSums(nLocal);
+  std::vector<std::vector<Extremum>> blockMax(nLocal);
+
+  this->Master->foreach<AutocorrelationImpl<A>>(
+    [&](AutocorrelationImpl<A>* b, const diy::Master::ProxyWithLink& cp, void*)
+    {
+    b->flush();
+
+    int lid = this->Master->lid(cp.gid());
+    size_t n = b->corr.size()/window;
+
+    std::vector<A> sums(window, 0);
+    AutocorrelationKernels::Sum(b->corr.data(), n, window, sums.data());
+    blockSums[lid].assign(sums.begin(), sums.end());
+
+    std::vector<A> vals(window*k);
+    std::vector<size_t> ids(window*k);
+    AutocorrelationKernels::TopK(b->corr.data(), n, window, k,
+      vals.data(), ids.data());
+
+    // convert voxel indices to global coordinates
+    std::vector<Extremum> &max = blockMax[lid];
+    max.resize(window*k);
+    int nx = b->shape[0];
+    int ny = b->shape[1];
+    for (size_t i = 0; i < window*k; ++i)
       {
-      corr->process(fa->GetPointer(0), gc ? gc->GetPointer(0) : nullptr);
+      Extremum &e = max[i];
+      if (ids[i] < n)
+        {
+        int j = static_cast<int>(ids[i]);
+        e.Value = vals[i];
+        e.Point[0] = b->from[0] + j % nx;
+        e.Point[1] = b->from[1] + (j / nx) % ny;
+        e.Point[2] = b->from[2] + j / (nx*ny);
+        }
+      else
+        {
+        e.Value = -DBL_MAX;
+        e.Point[0] = e.Point[1] = e.Point[2] = 0;
+        }
+      }
+    });
+
+  // combine the local blocks
+  this->SendSums.assign(window, 0.0);
+  this->SendMax.resize(window*k);
+  for (size_t i = 0; i < window; ++i)
+    {
+    std::vector<const Extremum*> lists;
+    for (size_t l = 0; l < nLocal; ++l)
+      {
+      this->SendSums[i] += blockSums[l][i];
+      lists.push_back(blockMax[l].data() + i*k);
+      }
+
+    if (lists.empty())
+      {
+      for (size_t j = 0; j < k; ++j)
+        this->SendMax[i*k + j] = Extremum{-DBL_MAX, {0, 0, 0}};
       }
     else
       {
-      SENSEI_ERROR("Current implementation only supports float arrays")
-      abort();
+      MergeExtrema(lists, k, this->SendMax.data() + i*k);
       }
     }
+
+  // move the fixed size lists to rank 0 without waiting. the result is
+  // reported when the transfers complete
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(this->Comm, &rank);
+  MPI_Comm_size(this->Comm, &nRanks);
+
+  this->RecvSums.resize(rank == 0 ? window : 0);
+  this->RecvMax.resize(rank == 0 ? nRanks*window*k : 0);
+
+  MPI_Ireduce(this->SendSums.data(), this->RecvSums.data(), window,
+    MPI_DOUBLE, MPI_SUM, 0, this->Comm, &this->SnapshotRequests[0]);
+
+  int nBytes = window*k*sizeof(Extremum);
+  MPI_Igather(this->SendMax.data(), nBytes, MPI_BYTE, this->RecvMax.data(),
+    nBytes, MPI_BYTE, 0, this->Comm, &this->SnapshotRequests[1]);
+
+  this->SnapshotPending = true;
+  this->SnapshotStep = step;
+}
+
+//-----------------------------------------------------------------------------
+bool Autocorrelation::AInternals::FinishSnapshot(bool wait)
+{
+  if (!this->SnapshotPending)
+    return true;
+
+  if (wait)
+    {
+    MPI_Waitall(2, this->SnapshotRequests, MPI_STATUSES_IGNORE);
+    }
+  else
+    {
+    int done = 0;
+    MPI_Testall(2, this->SnapshotRequests, &done, MPI_STATUSES_IGNORE);
+    if (!done)
+      return false;
+    }
+
+  this->SnapshotPending = false;
+
+  int rank = 0;
+  MPI_Comm_rank(this->Comm, &rank);
+  if (rank == 0)
+    this->ReportSnapshot();
+
   return true;
 }
 
+//-----------------------------------------------------------------------------
+void Autocorrelation::AInternals::ReportSnapshot()
+{
+  timer::MarkEvent mark("autocorrelation::report snapshot");
+
+  std::ostringstream when;
+  if (this->SnapshotStep >= 0)
+    when << " at step " << this->SnapshotStep;
+
+  // print out the autocorrelations
+  std::cout << "Autocorrelations" << when.str() << ":";
+  for (size_t i = 0; i < this->RecvSums.size(); ++i)
+    std::cout << ' ' << this->RecvSums[i];
+  std::cout << std::endl;
+
+  // merge the k strongest autocorrelations of each rank for each shift
+  size_t window = this->Window;
+  size_t k = this->KMax;
+  size_t nRanks = k ? this->RecvMax.size()/(window*k) : 0;
+  std::vector<Extremum> max(k);
+  for (size_t i = 0; i < window; ++i)
+    {
+    std::vector<const Extremum*> lists(nRanks);
+    for (size_t r = 0; r < nRanks; ++r)
+      lists[r] = this->RecvMax.data() + (r*window + i)*k;
+
+    if (nRanks)
+      MergeExtrema(lists, k, max.data());
+
+    std::cout << "Max autocorrelations for " << i << when.str() << ":";
+    for (size_t j = 0; nRanks && (j < k); ++j)
+      {
+      const Extremum &e = max[j];
+      if (e.Value == -DBL_MAX)
+        break;
+      Vertex v{e.Point[0], e.Point[1], e.Point[2]};
+      std::cout << " (" << e.Value << " at " << v << ")";
+      }
+    std::cout << std::endl;
+    }
+}
+
+//-----------------------------------------------------------------------------
+template <typename A>
+int Autocorrelation::AInternals::WriteBlocks(const std::string &fileName)
+{
+  timer::MarkEvent mark("autocorrelation::write checkpoint");
+
+  // the configuration the blocks were made with, and the step count so
+  // that periodic reports stay on schedule
+  diy::MemoryBuffer extra;
+  diy::save(extra, this->Window);
+  diy::save(extra, this->Engine);
+  diy::save(extra, this->DoublePrecision);
+  diy::save(extra, this->StepCount);
+
+  // each block is written at its offset in one shared file with
+  // collective MPI-IO
+  diy::io::write_blocks(fileName, this->Master->communicator(),
+    *this->Master, extra, &AutocorrelationImpl<A>::save);
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+template <typename A>
+int Autocorrelation::AInternals::ReadBlocks(const std::vector<BlockExtent> &blocks)
+{
+  timer::MarkEvent mark("autocorrelation::read checkpoint");
+
+  MPI_Comm comm = this->Master->communicator();
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  // diy reads the checkpoint without checking it. before any block is
+  // loaded, every rank reads the footer, the table of blocks followed by
+  // the configuration, and checks that the checkpoint was made with the
+  // same configuration on the same decomposition. a block of another
+  // precision would be loaded past the end of its buffer
+  using GidOffsetCount = diy::io::detail::GidOffsetCount;
+  std::vector<GidOffsetCount> table;
+  size_t window = 0;
+  int engine = 0;
+  bool doublePrecision = false;
+  long stepCount = 0;
+
+  int opened = 0;
+  MPI_File fh = MPI_FILE_NULL;
+  if (MPI_File_open(comm, const_cast<char*>(this->CheckpointFile.c_str()),
+    MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) == MPI_SUCCESS)
+    {
+    MPI_Offset size = 0;
+    MPI_Offset end = 0;
+    size_t footerSize = 0;
+    MPI_Status stat;
+    opened = (MPI_File_get_size(fh, &size) == MPI_SUCCESS) &&
+      ((end = size - static_cast<MPI_Offset>(sizeof(size_t))) >= 0) &&
+      (MPI_File_read_at(fh, end, &footerSize, sizeof(size_t), MPI_BYTE,
+        &stat) == MPI_SUCCESS) &&
+      (footerSize <= static_cast<size_t>(end));
+
+    diy::MemoryBuffer footer;
+    if (opened)
+      {
+      footer.buffer.resize(footerSize);
+      opened = MPI_File_read_at(fh, end - footerSize, footer.buffer.data(),
+        footerSize, MPI_BYTE, &stat) == MPI_SUCCESS;
+      }
+
+    MPI_File_close(&fh);
+
+    if (opened)
+      {
+      diy::MemoryBuffer extra;
+      diy::load(footer, table);
+      diy::load(footer, extra);
+      extra.reset();
+      diy::load(extra, window);
+      diy::load(extra, engine);
+      diy::load(extra, doublePrecision);
+      diy::load(extra, stepCount);
+      }
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &opened, 1, MPI_INT, MPI_LAND, comm);
+  if (!opened)
+    {
+    if (rank == 0)
+      SENSEI_WARNING("Failed to open checkpoint \"" << this->CheckpointFile
+        << "\". The analysis is starting afresh")
+    this->CheckpointFile.clear();
+    return -1;
+    }
+
+  // the checkpoint must have been made with the same configuration
+  int ok = (window == this->Window) && (engine == this->Engine) &&
+    (doublePrecision == this->DoublePrecision);
+
+  // and on the same decomposition, holding every block. the table is
+  // sorted by gid
+  int nLocal = blocks.size();
+  int nBlocks = 0;
+  MPI_Allreduce(&nLocal, &nBlocks, 1, MPI_INT, MPI_SUM, comm);
+  ok = ok && (static_cast<size_t>(nBlocks) == table.size());
+
+  for (size_t i = 0; ok && (i < blocks.size()); ++i)
+    {
+    int gid = blocks[i].Gid;
+    if ((gid < 0) || (static_cast<size_t>(gid) >= table.size()) ||
+      (table[gid].gid != gid))
+      {
+      SENSEI_WARNING("Block " << gid << " is not in checkpoint \""
+        << this->CheckpointFile << "\"")
+      ok = 0;
+      }
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, comm);
+  if (!ok)
+    {
+    if (rank == 0)
+      SENSEI_WARNING("Checkpoint \"" << this->CheckpointFile
+        << "\" was made with a different configuration or decomposition "
+        "and is ignored. The analysis is starting afresh")
+    this->CheckpointFile.clear();
+    return -1;
+    }
+
+  std::vector<int> gids;
+  for (size_t i = 0; i < blocks.size(); ++i)
+    gids.push_back(blocks[i].Gid);
+
+  CheckpointAssigner assigner(this->Master->communicator().size(),
+    this->Master->communicator().rank(), gids);
+
+  diy::MemoryBuffer extra;
+  diy::io::read_blocks(this->CheckpointFile, this->Master->communicator(),
+    assigner, *this->Master, extra, &AutocorrelationImpl<A>::load);
+
+  // the blocks must have the extents of the current decomposition
+  for (size_t i = 0; ok && (i < blocks.size()); ++i)
+    {
+    const BlockExtent &be = blocks[i];
+    int lid = this->Master->lid(be.Gid);
+
+    AutocorrelationImpl<A>* b = lid < 0 ? nullptr :
+      static_cast<AutocorrelationImpl<A>*>(this->Master->get(lid));
+
+    ok = b && (b->gid == be.Gid) && (b->from == be.From) && (b->to == be.To);
+    }
+
+  // the blocks are restored on all ranks or on none
+  MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, comm);
+  if (!ok)
+    {
+    if (rank == 0)
+      SENSEI_WARNING("Checkpoint \"" << this->CheckpointFile
+        << "\" was made with a different configuration or decomposition "
+        "and is ignored. The analysis is starting afresh")
+    this->Master->clear();
+    this->CheckpointFile.clear();
+    return -1;
+    }
+
+  this->StepCount = stepCount;
+  this->CheckpointFile.clear();
+
+  return 0;
+}
+
 //-----------------------------------------------------------------------------
 void Autocorrelation::PrintResults(size_t k_max)
 {
   timer::MarkEvent mark("autocorrelation::collect results");
+
+  // complete any periodic report before the final one
+  AInternals& internals = (*this->Internals);
+  internals.FinishSnapshot(true);
+  internals.KMax = k_max;
+  internals.StartSnapshot(-1);
+  internals.FinishSnapshot(true);
+}
+
+//-----------------------------------------------------------------------------
+void Autocorrelation::GetCorrelationSums(std::vector<double> &sums)
+{
+  // complete any report in flight
+  AInternals& internals = (*this->Internals);
+  internals.FinishSnapshot(true);
+  sums = internals.RecvSums;
+}
+
+//-----------------------------------------------------------------------------
+int Autocorrelation::WriteCheckpoint(const std::string &fileName)
+{
   AInternals& internals = (*this->Internals);
-  size_t nblocks = internals.NumberOfBlocks;
-
-    // add up the autocorrellations
-  internals.Master->foreach<AutocorrelationImpl>([](AutocorrelationImpl* b, const diy::Master::ProxyWithLink& cp, void*)
-                                     {
-                                        std::vector<float> sums(b->window, 0);
-                                        grid::for_each(b->corr.shape(), [&](const Vertex4D& v)
-                                        {
-                                            size_t w = v[3];
-                                            sums[w] += b->corr(v);
-                                        });
-
-                                        cp.all_reduce(sums, add_vectors<float>());
-                                     });
-  internals.Master->exchange();
-  if (internals.Master->communicator().rank() == 0)
+
+  // complete any report in flight so that none are lost
+  internals.FinishSnapshot(true);
+
+  if (internals.DoublePrecision)
+    return internals.WriteBlocks<double>(fileName);
+
+  return internals.WriteBlocks<float>(fileName);
+}
+
+//-----------------------------------------------------------------------------
+int Autocorrelation::ReadCheckpoint(const std::string &fileName)
+{
+  AInternals& internals = (*this->Internals);
+
+  if (internals.BlocksInitialized)
     {
-    // print out the autocorrelations
-    auto result = internals.Master->proxy(0).get<std::vector<float>>();
-    std::cout << "Autocorrelations:";
-    for (size_t i = 0; i < result.size(); ++i)
-      std::cout << ' ' << result[i];
-    std::cout << std::endl;
+    SENSEI_ERROR("ReadCheckpoint must be called before the first Execute")
+    return -1;
     }
 
-  internals.Master->foreach<AutocorrelationImpl>(
-    [](AutocorrelationImpl*, const diy::Master::ProxyWithLink& cp, void*)
-    {
-    cp.collectives()->clear();
-    });
+  // the blocks are read once the decomposition is known
+  internals.CheckpointFile = fileName;
 
-    // select k strongest autocorrelations for each shift
-    diy::ContiguousAssigner     assigner(internals.Master->communicator().size(), nblocks);     // NB: this is coupled to main(...) in oscillator.cpp
-    diy::RegularMergePartners   partners(3, nblocks, 2, true);
-    diy::reduce(*internals.Master, assigner, partners,
-                [k_max](void* b_, const diy::ReduceProxy& rp, const diy::RegularMergePartners&)
-                {
-                    AutocorrelationImpl* b = static_cast<AutocorrelationImpl*>(b_);
-                    //unsigned round = rp.round(); // current round number
-
-                    using MaxHeapVector = std::vector<std::vector<std::tuple<float,Vertex>>>;
-                    using Compare       = std::greater<std::tuple<float,Vertex>>;
-                    MaxHeapVector maxs(b->window);
-                    if (rp.in_link().size() == 0)
-                    {
-                        grid::for_each(b->corr.shape(), [&](const Vertex4D& v)
-                        {
-                            size_t offset = v[3];
-                            float val = b->corr(v);
-                            auto& max = maxs[offset];
-                            if (max.size() < k_max)
-                            {
-                                max.emplace_back(val, v.drop(3) + b->from);
-                                std::push_heap(max.begin(), max.end(), Compare());
-                            } else if (val > std::get<0>(max[0]))
-                            {
-                                std::pop_heap(max.begin(), max.end(), Compare());
-                                maxs[offset].back() = std::make_tuple(val, v.drop(3) + b->from);
-                                std::push_heap(max.begin(), max.end(), Compare());
-                            }
-                        });
-                    } else
-                    {
-                        for (long i = 0; i < rp.in_link().size(); ++i)
-                        {
-                            MaxHeapVector in_heaps;
-                            rp.dequeue(rp.in_link().target(i).gid, in_heaps);
-                            for (size_t j = 0; j < in_heaps.size(); ++j)
-                            {
-                                for (auto& x : in_heaps[j])
-                                    maxs[j].push_back(x);
-                            }
-                        }
-                        for (size_t j = 0; j < maxs.size(); ++j)
-                        {
-                            auto& max = maxs[j];
-                            std::make_heap(max.begin(), max.end(), Compare());
-                            while(max.size() > k_max)
-                            {
-                                std::pop_heap(max.begin(), max.end(), Compare());
-                                max.pop_back();
-                            }
-                        }
-                    }
-
-                    if (rp.out_link().size() > 0)
-                        rp.enqueue(rp.out_link().target(0), maxs);
-                    else
-                    {
-                        // print out the answer
-                        for (size_t i = 0; i < maxs.size(); ++i)
-                        {
-                            std::sort(maxs[i].begin(), maxs[i].end(), Compare());
-                            std::cout << "Max autocorrelations for " << i << ":";
-                            for (auto& x : maxs[i])
-                                std::cout << " (" << std::get<0>(x) << " at " << std::get<1>(x) << ")";
-                            std::cout << std::endl;
-                        }
-                    }
-                });
+  return 0;
 }
 
 //-----------------------------------------------------------------------------
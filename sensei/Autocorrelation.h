@@ -4,6 +4,7 @@
 #include "AnalysisAdaptor.h"
 #include <mpi.h>
 #include <string>
+#include <vector>
 
 namespace sensei
 {
@@ -33,10 +34,83 @@ public:
   void Initialize(size_t window, const std::string &meshName,
     int association, const std::string &arrayname, size_t k_max);
 
+  /// @brief Set the precision of the correlations.
+  ///
+  /// The input arrays are read in place whatever their type and their
+  /// values are converted to the accumulation type as they are recorded.
+  /// When on, the values and correlations are stored and accumulated in
+  /// double precision, otherwise in single precision. The default is
+  /// single precision. Must be called before Initialize.
+  void SetDoublePrecision(bool val);
+
+  enum {ENGINE_DIRECT=0, ENGINE_FFT=1};
+
+  /// @brief Set the method used to compute the correlations.
+  ///
+  /// ENGINE_DIRECT, the default, updates the correlations of every shift
+  /// each step and costs window multiply-adds per value per step.
+  /// ENGINE_FFT buffers chunks of steps and correlates them for all
+  /// shifts at once with FFTs, at a cost per step proportional to
+  /// log(window). It is the faster choice for large windows but keeps a
+  /// longer history. Must be called before Initialize.
+  void SetEngine(int val);
+
+  /// @brief Set the number of threads used to process the local blocks.
+  ///
+  /// The blocks are processed by the threads of the diy::Master that
+  /// owns them. -1 uses all of the hardware threads. The default is 1.
+  /// Must be called before Initialize.
+  void SetThreads(int val);
+
+  /// @brief Limit the number of blocks held in memory.
+  ///
+  /// When positive, at most this many of the local blocks are held in
+  /// memory and the others are written to files in the storage path,
+  /// bounding the memory used by the correlations and their history.
+  /// The default, -1, holds all of the blocks in memory. Must be called
+  /// before Initialize.
+  void SetBlockLimit(int val);
+
+  /// @brief Set the directory of the files holding swapped out blocks.
+  ///
+  /// Node local storage should be used. The default is /tmp. Must be
+  /// called before Initialize.
+  void SetStoragePath(const std::string &path);
+
+  /// @brief Report the correlations every n steps.
+  ///
+  /// When positive, the sums and the k_max strongest correlations of each
+  /// shift are reported every n steps as well as during Finalize. The
+  /// local results are sent to rank 0 with nonblocking collectives of a
+  /// fixed size and printed once they arrive, during a later Execute.
+  /// The default, 0, reports only during Finalize.
+  void SetReportInterval(long n);
+
   bool Execute(DataAdaptor* data) override;
 
   int Finalize() override;
 
+  /// @brief Get the sums of the correlations of each shift.
+  ///
+  /// The window sums over all of the blocks made by the last report,
+  /// periodic or during Finalize. Any report in flight is completed
+  /// first. The sums are gathered on rank 0, elsewhere sums is empty.
+  void GetCorrelationSums(std::vector<double> &sums);
+
+  /// @brief Save the history and correlations of the local blocks.
+  ///
+  /// The blocks are written to one shared file with collective MPI-IO.
+  int WriteCheckpoint(const std::string &fileName) override;
+
+  /// @brief Restore the history and correlations of the local blocks.
+  ///
+  /// The blocks are read during the first Execute, once the blocks held
+  /// by this rank are known. The checkpoint must have been written with
+  /// the same window, engine, and precision, on the same decomposition,
+  /// and hold every block. Otherwise, or when the file can't be opened,
+  /// it is ignored on all ranks and the analysis starts afresh.
+  int ReadCheckpoint(const std::string &fileName) override;
+
 protected:
   Autocorrelation();
   ~Autocorrelation();
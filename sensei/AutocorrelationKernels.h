@@ -0,0 +1,332 @@
+#ifndef sensei_AutocorrelationKernels_h
+#define sensei_AutocorrelationKernels_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace sensei
+{
+
+/// Low level kernels used by the autocorrelation analysis. The kernels
+/// are independent of VTK and DIY so that they may be exercised directly
+/// by the benchmarks.
+///
+/// The circular buffer of the last window values and the correlations
+/// are stored one shift at a time, a structure of arrays. Slot s of the
+/// buffer and shift i of the correlations are contiguous runs of n
+/// values starting at s*n and i*n. This is the layout of a
+/// grid::Grid<A,4> whose 4th dimension is the window, so the block's
+/// grids may be handed to the kernels directly. The update of a step is
+/// a short sequence of flat loops over the voxels, one per shift, that
+/// the compiler can vectorize.
+///
+/// The kernels are templated on the type of the input values, T, and on
+/// the type used to store and accumulate the products, A. Inputs are read
+/// in place and converted to A as they are recorded.
+///
+/// Update is the direct method, it costs window multiply-adds per voxel
+/// per step. The FFT engine, Record and Correlate, instead buffers chunks
+/// of the time series and computes the correlations for all shifts of a
+/// chunk at once with FFTs of length nFFT, the smallest power of 2 not
+/// less than 2*window. Its history holds nFFT steps per voxel, the last
+/// window steps of the previous chunk followed by up to nFFT - window
+/// steps of the current chunk. The cost per step is then proportional
+/// to log(nFFT) rather than window.
+namespace AutocorrelationKernels
+{
+
+/// number of voxels transformed together by the FFT engine
+constexpr size_t FFT_TILE = 256;
+
+namespace detail
+{
+/// In place radix-2 FFT of a batch of nb sequences of length nFFT. The
+/// real and imaginary parts are stored separately with the batch
+/// contiguous, element k of sequence v is at k*nb + v, so that the
+/// butterflies are vectorized over the batch. The inverse is not
+/// scaled.
+template <typename A>
+void FFT(A *re, A *im, size_t nFFT, size_t nb, bool inverse)
+{
+  // bit reversed ordering of the elements
+  for (size_t i = 1, j = 0; i < nFFT; ++i)
+    {
+    size_t bit = nFFT >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      {
+      std::swap_ranges(re + i*nb, re + (i + 1)*nb, re + j*nb);
+      std::swap_ranges(im + i*nb, im + (i + 1)*nb, im + j*nb);
+      }
+    }
+
+  // butterflies
+  A sign = inverse ? A(1) : A(-1);
+  for (size_t len = 2; len <= nFFT; len <<= 1)
+    {
+    size_t half = len/2;
+    double theta = 2.0*M_PI/len;
+    for (size_t k = 0; k < half; ++k)
+      {
+      A wr = static_cast<A>(std::cos(theta*k));
+      A wi = sign*static_cast<A>(std::sin(theta*k));
+      for (size_t start = 0; start < nFFT; start += len)
+        {
+        A *ur = re + (start + k)*nb;
+        A *ui = im + (start + k)*nb;
+        A *vr = re + (start + k + half)*nb;
+        A *vi = im + (start + k + half)*nb;
+        for (size_t v = 0; v < nb; ++v)
+          {
+          A tr = vr[v]*wr - vi[v]*wi;
+          A ti = vr[v]*wi + vi[v]*wr;
+          vr[v] = ur[v] - tr;
+          vi[v] = ui[v] - ti;
+          ur[v] += tr;
+          ui[v] += ti;
+          }
+        }
+      }
+    }
+}
+}
+
+/// Returns the length of the FFTs used for the given window.
+inline
+size_t FFTLength(size_t window)
+{
+  size_t nFFT = 2;
+  while (nFFT < 2*window)
+    nFFT <<= 1;
+  return nFFT;
+}
+
+/// Adds the products of the current values with the values of the last
+/// window steps into the correlations and records the current values in
+/// the circular buffer. Elements with a non-zero ghost value contribute
+/// zero. offset is the buffer slot that receives the current values and
+/// count is the number of steps processed so far, during the initial fill
+/// the shifts with no history are skipped.
+template <typename T, typename A>
+void Update(const T *data, const unsigned char *ghost, size_t n,
+  size_t window, size_t offset, size_t count, A *values, A *corr)
+{
+  A *cur = values + offset*n;
+
+  // the oldest value is held in the slot the current values replace,
+  // consume it with the longest shift while the slot is overwritten
+  if (count >= window)
+    {
+    A *c = corr + (window - 1)*n;
+    if (ghost)
+      {
+      for (size_t j = 0; j < n; ++j)
+        {
+        A g = ghost[j] ? A(0) : static_cast<A>(data[j]);
+        c[j] += cur[j]*g;
+        cur[j] = g;
+        }
+      }
+    else
+      {
+      for (size_t j = 0; j < n; ++j)
+        {
+        A g = static_cast<A>(data[j]);
+        c[j] += cur[j]*g;
+        cur[j] = g;
+        }
+      }
+    }
+  else if (ghost)
+    {
+    for (size_t j = 0; j < n; ++j)
+      cur[j] = ghost[j] ? A(0) : static_cast<A>(data[j]);
+    }
+  else
+    {
+    for (size_t j = 0; j < n; ++j)
+      cur[j] = static_cast<A>(data[j]);
+    }
+
+  // the remaining shifts read the masked current values back from the
+  // buffer
+  size_t nShifts = count < window ? count : window - 1;
+  for (size_t i = 1; i <= nShifts; ++i)
+    {
+    A *c = corr + (i - 1)*n;
+    const A *v = values + ((offset + window - i) % window)*n;
+    for (size_t j = 0; j < n; ++j)
+      c[j] += v[j]*cur[j];
+    }
+}
+
+/// Records the current values in the history of the FFT engine. fill is
+/// the number of steps of the current chunk already recorded. Elements
+/// with a non-zero ghost value are recorded as zero.
+template <typename T, typename A>
+void Record(const T *data, const unsigned char *ghost, size_t n,
+  size_t window, size_t fill, A *history)
+{
+  A *cur = history + (window + fill)*n;
+  if (ghost)
+    {
+    for (size_t j = 0; j < n; ++j)
+      cur[j] = ghost[j] ? A(0) : static_cast<A>(data[j]);
+    }
+  else
+    {
+    for (size_t j = 0; j < n; ++j)
+      cur[j] = static_cast<A>(data[j]);
+    }
+}
+
+/// Adds the correlations of the fill steps of the current chunk with the
+/// steps that precede them into corr and moves the last window steps to
+/// the front of the history for the next chunk. The history of a voxel,
+/// z, is transformed together with its current chunk, y, which is z with
+/// the first window steps zeroed, as one complex sequence z + iy. The
+/// cross correlation of z and y for shift i, the sum of z[k-i]*y[k], is
+/// the inverse transform of conj(Z)*Y. There is no wrap around since
+/// nFFT is at least window + fill.
+template <typename A>
+void Correlate(A *history, size_t n, size_t window, size_t nFFT,
+  size_t fill, A *corr)
+{
+  if (fill == 0)
+    return;
+
+  size_t nz = window + fill;
+  std::vector<A> re(nFFT*FFT_TILE);
+  std::vector<A> im(nFFT*FFT_TILE);
+  for (size_t j0 = 0; j0 < n; j0 += FFT_TILE)
+    {
+    size_t nb = std::min(FFT_TILE, n - j0);
+    A *pr = re.data();
+    A *pi = im.data();
+
+    // load z + iy
+    for (size_t k = 0; k < nFFT; ++k)
+      {
+      A *r = pr + k*nb;
+      A *i = pi + k*nb;
+      if (k < window)
+        {
+        std::copy(history + k*n + j0, history + k*n + j0 + nb, r);
+        std::fill(i, i + nb, A(0));
+        }
+      else if (k < nz)
+        {
+        std::copy(history + k*n + j0, history + k*n + j0 + nb, r);
+        std::copy(history + k*n + j0, history + k*n + j0 + nb, i);
+        }
+      else
+        {
+        std::fill(r, r + nb, A(0));
+        std::fill(i, i + nb, A(0));
+        }
+      }
+
+    detail::FFT(pr, pi, nFFT, nb, false);
+
+    // separate Z and Y using the symmetry of the transforms of real
+    // sequences and form conj(Z)*Y, which is also symmetric
+    for (size_t k = 0; k <= nFFT/2; ++k)
+      {
+      size_t nk = (nFFT - k) % nFFT;
+      A *ar = pr + k*nb;
+      A *ai = pi + k*nb;
+      A *br = pr + nk*nb;
+      A *bi = pi + nk*nb;
+      for (size_t v = 0; v < nb; ++v)
+        {
+        A zr = A(0.5)*(ar[v] + br[v]);
+        A zi = A(0.5)*(ai[v] - bi[v]);
+        A yr = A(0.5)*(ai[v] + bi[v]);
+        A yi = A(0.5)*(br[v] - ar[v]);
+        A cr = zr*yr + zi*yi;
+        A ci = zr*yi - zi*yr;
+        ar[v] = cr;
+        ai[v] = ci;
+        br[v] = cr;
+        bi[v] = -ci;
+        }
+      }
+
+    detail::FFT(pr, pi, nFFT, nb, true);
+
+    // shift i is at element i of the inverse
+    A scale = A(1)/static_cast<A>(nFFT);
+    for (size_t i = 1; i <= window; ++i)
+      {
+      A *c = corr + (i - 1)*n + j0;
+      const A *r = pr + i*nb;
+      for (size_t v = 0; v < nb; ++v)
+        c[v] += scale*r[v];
+      }
+    }
+
+  // keep the last window steps for the next chunk
+  std::copy(history + fill*n, history + nz*n, history);
+}
+
+/// Finds the k largest correlations of each shift. For shift i the
+/// values, in descending order, and their voxel indices are written to
+/// vals and ids starting at i*k. The candidates are kept in a fixed size
+/// sorted list and most voxels are rejected by one comparison with the
+/// smallest. When there are fewer than k voxels the lists are padded with
+/// the lowest value and the index n.
+template <typename A>
+void TopK(const A *corr, size_t n, size_t window, size_t k, A *vals,
+  size_t *ids)
+{
+  if (k == 0)
+    return;
+
+  for (size_t i = 0; i < window; ++i)
+    {
+    const A *c = corr + i*n;
+    A *v = vals + i*k;
+    size_t *id = ids + i*k;
+    std::fill(v, v + k, std::numeric_limits<A>::lowest());
+    std::fill(id, id + k, n);
+    for (size_t j = 0; j < n; ++j)
+      {
+      if (c[j] > v[k-1])
+        {
+        size_t m = k - 1;
+        for (; (m > 0) && (v[m-1] < c[j]); --m)
+          {
+          v[m] = v[m-1];
+          id[m] = id[m-1];
+          }
+        v[m] = c[j];
+        id[m] = j;
+        }
+      }
+    }
+}
+
+/// Sums the correlations of each shift over the voxels.
+template <typename A>
+void Sum(const A *corr, size_t n, size_t window, A *sums)
+{
+  for (size_t i = 0; i < window; ++i)
+    {
+    const A *c = corr + i*n;
+    A sum = A(0);
+    for (size_t j = 0; j < n; ++j)
+      sum += c[j];
+    sums[i] += sum;
+    }
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef sensei_CellLocationKernels_h
+#define sensei_CellLocationKernels_h
+
+#include <vtkCellType.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace sensei
+{
+
+/// Kernels that build the cell locations of an unstructured grid from its
+/// cell types and cells, as the ADIOS schema reader does for streams
+/// written without the locations. The cells are stored as they are in VTK,
+/// the number of points of each cell followed by its point ids, and the
+/// location of a cell is the index of its point count. They are independent
+/// of ADIOS so that they may be exercised directly by the tests.
+namespace CellLocationKernels
+{
+
+/// Returns the number of points of cells of the given type, or -1 when
+/// the number varies from cell to cell.
+inline
+int GetCellSize(unsigned char type)
+{
+  switch (type)
+    {
+    case VTK_EMPTY_CELL: return 0;
+    case VTK_VERTEX: return 1;
+    case VTK_LINE: return 2;
+    case VTK_TRIANGLE: return 3;
+    case VTK_PIXEL:
+    case VTK_QUAD:
+    case VTK_TETRA: return 4;
+    case VTK_PYRAMID: return 5;
+    case VTK_WEDGE: return 6;
+    case VTK_VOXEL:
+    case VTK_HEXAHEDRON: return 8;
+    case VTK_PENTAGONAL_PRISM: return 10;
+    case VTK_HEXAGONAL_PRISM: return 12;
+    case VTK_QUADRATIC_EDGE: return 3;
+    case VTK_QUADRATIC_TRIANGLE: return 6;
+    case VTK_QUADRATIC_QUAD: return 8;
+    case VTK_QUADRATIC_TETRA: return 10;
+    case VTK_QUADRATIC_PYRAMID: return 13;
+    case VTK_QUADRATIC_WEDGE: return 15;
+    case VTK_QUADRATIC_HEXAHEDRON: return 20;
+    }
+  return -1;
+}
+
+/// Builds the locations of the cells by walking the cells array.
+inline
+void WalkCellLocations(unsigned long number_of_cells, const vtkIdType *cells,
+  vtkIdType *locs)
+{
+  vtkIdType loc = 0;
+  for (unsigned long i = 0; i < number_of_cells; ++i)
+    {
+    locs[i] = loc;
+    loc += cells[loc] + 1;
+    }
+}
+
+/// Builds the locations of the cells. When all of the cell types have a
+/// fixed size the locations are the exclusive scan of the sizes and are
+/// computed in parallel, the sums of contiguous chunks of at least
+/// min_chunk cells are computed first and then each chunk is scanned from
+/// the offset of the sums of the preceding chunks. At most n_threads
+/// chunks are used, 0 uses one per hardware thread. Otherwise the cells
+/// array is walked.
+inline
+void BuildCellLocations(unsigned long number_of_cells,
+  const unsigned char *types, const vtkIdType *cells, vtkIdType *locs,
+  unsigned int n_threads = 0, unsigned long min_chunk = 65536)
+{
+  // a table of the sizes, including the point count, of each type
+  vtkIdType sizes[256];
+  bool fixed = true;
+  for (int i = 0; i < 256; ++i)
+    sizes[i] = GetCellSize(i) + 1;
+
+  for (unsigned long i = 0; fixed && (i < number_of_cells); ++i)
+    fixed = sizes[types[i]] > 0;
+
+  if (!fixed)
+    {
+    WalkCellLocations(number_of_cells, cells, locs);
+    return;
+    }
+
+  // small meshes are not worth the threads
+  min_chunk = std::max(1ul, min_chunk);
+  if (n_threads == 0)
+    n_threads = std::thread::hardware_concurrency();
+  unsigned long n_chunks = std::max(1u, n_threads);
+  n_chunks = std::min(n_chunks, number_of_cells/min_chunk + 1);
+  unsigned long chunk = number_of_cells/n_chunks + 1;
+
+  std::vector<vtkIdType> offsets(n_chunks + 1, 0);
+
+  auto sum = [&](unsigned long c)
+  {
+    unsigned long i0 = std::min(c*chunk, number_of_cells);
+    unsigned long i1 = std::min(i0 + chunk, number_of_cells);
+    vtkIdType total = 0;
+    for (unsigned long i = i0; i < i1; ++i)
+      total += sizes[types[i]];
+    offsets[c+1] = total;
+  };
+
+  auto scan = [&](unsigned long c)
+  {
+    unsigned long i0 = std::min(c*chunk, number_of_cells);
+    unsigned long i1 = std::min(i0 + chunk, number_of_cells);
+    vtkIdType loc = offsets[c];
+    for (unsigned long i = i0; i < i1; ++i)
+      {
+      locs[i] = loc;
+      loc += sizes[types[i]];
+      }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(n_chunks);
+
+  for (unsigned long c = 1; c < n_chunks; ++c)
+    threads.emplace_back(sum, c);
+  sum(0);
+  for (std::thread &t : threads)
+    t.join();
+  threads.clear();
+
+  for (unsigned long c = 1; c <= n_chunks; ++c)
+    offsets[c] += offsets[c-1];
+
+  for (unsigned long c = 1; c < n_chunks; ++c)
+    threads.emplace_back(scan, c);
+  scan(0);
+  for (std::thread &t : threads)
+    t.join();
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,366 @@
+#ifndef sensei_CompressionKernels_h
+#define sensei_CompressionKernels_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace sensei
+{
+
+/// Low level codecs used to compress the data arrays written by the ADIOS
+/// schema. The codecs operate on contiguous buffers and are independent of
+/// VTK and ADIOS so that they may be exercised directly by the benchmarks.
+///
+/// Shuffle transposes the bytes of fixed size values, gathering byte b of
+/// every value into the b-th run of the output. The high order bytes of
+/// smooth fields are then in long runs of similar values that the LZ codec
+/// finds.
+///
+/// LZ is a byte oriented LZ77 codec in the style of LZ4. The input is
+/// coded as a sequence of literal runs each followed by a match, a copy
+/// of at least 4 bytes found at most 64kB back in the output. A token
+/// byte holds the lengths of both, lengths of 15 and more are continued
+/// in bytes of 255 and a final byte. The matches are found with a hash
+/// table of the positions of the last 4 byte sequences, and the search
+/// moves faster through data where no matches are found so that
+/// incompressible data costs little more than a copy. The last run of
+/// literals has no match.
+///
+/// Quantize maps floating point values onto integer codes, the number of
+/// steps of width 2*tolerance from the minimum, so that the values
+/// reconstructed by Dequantize are within tolerance of the originals, up
+/// to the rounding of the reconstructed values to the input type. The
+/// codes are stored in the smallest of 1, 2, or 4 bytes that holds the
+/// largest, a fixed rate for all values of the array.
+namespace CompressionKernels
+{
+
+namespace detail
+{
+inline
+uint32_t Read32(const unsigned char *p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// appends the continuation of a length stored in a token
+inline
+unsigned char *WriteLength(unsigned char *op, size_t len)
+{
+  len -= 15;
+  for (; len >= 255; len -= 255)
+    *op++ = 255;
+  *op++ = static_cast<unsigned char>(len);
+  return op;
+}
+
+// reads the continuation of a length stored in a token. returns false
+// if the input ends first
+inline
+bool ReadLength(const unsigned char *&ip, const unsigned char *end,
+  size_t &len)
+{
+  unsigned char b = 255;
+  while (b == 255)
+    {
+    if (ip >= end)
+      return false;
+    b = *ip++;
+    len += b;
+    }
+  return true;
+}
+
+// appends a run of literals followed by a match of length len at the
+// given offset, len of 0 ends the stream
+inline
+unsigned char *WriteSequence(unsigned char *op, const unsigned char *lit,
+  size_t nLit, size_t offset, size_t len)
+{
+  size_t mlen = len ? len - 4 : 0;
+  *op++ = static_cast<unsigned char>(
+    (std::min<size_t>(nLit, 15) << 4) | std::min<size_t>(mlen, 15));
+
+  if (nLit >= 15)
+    op = WriteLength(op, nLit);
+
+  if (nLit)
+    memcpy(op, lit, nLit);
+  op += nLit;
+
+  if (len)
+    {
+    *op++ = static_cast<unsigned char>(offset & 0xff);
+    *op++ = static_cast<unsigned char>(offset >> 8);
+    if (mlen >= 15)
+      op = WriteLength(op, mlen);
+    }
+
+  return op;
+}
+}
+
+/// Transposes the bytes of the n values of size bytes in in to out. out
+/// must hold n*size bytes.
+inline
+void Shuffle(const unsigned char *in, size_t n, size_t size,
+  unsigned char *out)
+{
+  for (size_t b = 0; b < size; ++b)
+    {
+    unsigned char *o = out + b*n;
+    const unsigned char *p = in + b;
+    for (size_t i = 0; i < n; ++i)
+      o[i] = p[i*size];
+    }
+}
+
+/// Reverses Shuffle.
+inline
+void Unshuffle(const unsigned char *in, size_t n, size_t size,
+  unsigned char *out)
+{
+  for (size_t b = 0; b < size; ++b)
+    {
+    const unsigned char *p = in + b*n;
+    unsigned char *o = out + b;
+    for (size_t i = 0; i < n; ++i)
+      o[i*size] = p[i];
+    }
+}
+
+/// Returns the largest number of bytes LZCompress produces for n bytes.
+inline
+size_t LZBound(size_t n)
+{
+  return n + n/255 + 16;
+}
+
+/// Compresses the n bytes of in to out, which must hold LZBound(n) bytes.
+/// Returns the number of bytes written.
+inline
+size_t LZCompress(const unsigned char *in, size_t n, unsigned char *out)
+{
+  const int hashBits = 14;
+  std::vector<uint32_t> table(size_t(1) << hashBits, 0);
+
+  unsigned char *op = out;
+  size_t ip = 0;
+  size_t anchor = 0;
+
+  // the last 12 bytes do not start a match and the last 5 are literals
+  size_t limit = n > 12 ? n - 12 : 0;
+  while (ip < limit)
+    {
+    uint32_t seq = detail::Read32(in + ip);
+    uint32_t h = (seq*2654435761u) >> (32 - hashBits);
+    size_t cand = table[h];
+    table[h] = static_cast<uint32_t>(ip);
+
+    if ((cand < ip) && (ip - cand < 65536) &&
+      (detail::Read32(in + cand) == seq))
+      {
+      size_t len = 4;
+      size_t maxLen = n - 5 - ip;
+      while ((len < maxLen) && (in[cand + len] == in[ip + len]))
+        ++len;
+
+      op = detail::WriteSequence(op, in + anchor, ip - anchor, ip - cand, len);
+
+      ip += len;
+      anchor = ip;
+      }
+    else
+      {
+      // step further the longer no match has been found
+      ip += 1 + ((ip - anchor) >> 6);
+      }
+    }
+
+  op = detail::WriteSequence(op, in + anchor, n - anchor, 0, 0);
+
+  return op - out;
+}
+
+/// Decompresses the n bytes of in to out, which holds outSize bytes.
+/// Returns 0 if exactly outSize bytes were decoded and -1 if the input
+/// is corrupt.
+inline
+int LZDecompress(const unsigned char *in, size_t n, unsigned char *out,
+  size_t outSize)
+{
+  const unsigned char *ip = in;
+  const unsigned char *end = in + n;
+  unsigned char *op = out;
+  unsigned char *oend = out + outSize;
+
+  while (ip < end)
+    {
+    unsigned char token = *ip++;
+
+    size_t nLit = token >> 4;
+    if ((nLit == 15) && !detail::ReadLength(ip, end, nLit))
+      return -1;
+
+    if ((nLit > size_t(end - ip)) || (nLit > size_t(oend - op)))
+      return -1;
+
+    if (nLit)
+      memcpy(op, ip, nLit);
+    ip += nLit;
+    op += nLit;
+
+    // the last sequence has no match
+    if (ip == end)
+      break;
+
+    if (end - ip < 2)
+      return -1;
+
+    size_t offset = ip[0] | (size_t(ip[1]) << 8);
+    ip += 2;
+
+    size_t len = token & 15;
+    if ((len == 15) && !detail::ReadLength(ip, end, len))
+      return -1;
+    len += 4;
+
+    if ((offset == 0) || (offset > size_t(op - out)) ||
+      (len > size_t(oend - op)))
+      return -1;
+
+    // the copy may overlap its source
+    const unsigned char *mp = op - offset;
+    for (size_t i = 0; i < len; ++i)
+      op[i] = mp[i];
+    op += len;
+    }
+
+  return op == oend ? 0 : -1;
+}
+
+/// The parameters of quantized values.
+struct QuantizeHeader
+{
+  double Min;
+  double Step;
+  uint64_t CodeSize;
+};
+
+/// Quantizes the n values of in with the given absolute error tolerance.
+/// The codes are written to out, which must hold n*sizeof(T) bytes, and
+/// their parameters to header. Returns -1, leaving out untouched, when
+/// the values are not finite or the tolerance is too fine for 4 byte
+/// codes.
+template <typename T>
+int Quantize(const T *in, size_t n, double tolerance, QuantizeHeader &header,
+  unsigned char *out)
+{
+  if (!(tolerance > 0.0))
+    return -1;
+
+  double lo = 0.0;
+  double hi = 0.0;
+  if (n)
+    {
+    // nan and inf times zero are nan, the sum is finite only if all of
+    // the values are
+    T mn = in[0];
+    T mx = in[0];
+    T nf = T(0);
+    for (size_t i = 0; i < n; ++i)
+      {
+      mn = std::min(mn, in[i]);
+      mx = std::max(mx, in[i]);
+      nf += in[i]*T(0);
+      }
+    if (!std::isfinite(nf))
+      return -1;
+    lo = mn;
+    hi = mx;
+    }
+
+  if (!std::isfinite(lo) || !std::isfinite(hi))
+    return -1;
+
+  double step = 2.0*tolerance;
+  double maxCode = std::floor((hi - lo)/step + 0.5);
+  if (!(maxCode < 4294967296.0))
+    return -1;
+
+  header.Min = lo;
+  header.Step = step;
+  header.CodeSize = maxCode < 256.0 ? 1 : (maxCode < 65536.0 ? 2 : 4);
+
+  double scale = 1.0/step;
+  switch (header.CodeSize)
+    {
+    case 1:
+      {
+      uint8_t *codes = reinterpret_cast<uint8_t*>(out);
+      for (size_t i = 0; i < n; ++i)
+        codes[i] = static_cast<uint8_t>((in[i] - lo)*scale + 0.5);
+      }
+      break;
+    case 2:
+      {
+      uint16_t *codes = reinterpret_cast<uint16_t*>(out);
+      for (size_t i = 0; i < n; ++i)
+        codes[i] = static_cast<uint16_t>((in[i] - lo)*scale + 0.5);
+      }
+      break;
+    default:
+      {
+      uint32_t *codes = reinterpret_cast<uint32_t*>(out);
+      for (size_t i = 0; i < n; ++i)
+        codes[i] = static_cast<uint32_t>((in[i] - lo)*scale + 0.5);
+      }
+    }
+
+  return 0;
+}
+
+/// Reconstructs n values from the codes in in.
+template <typename T>
+void Dequantize(const unsigned char *in, size_t n,
+  const QuantizeHeader &header, T *out)
+{
+  double lo = header.Min;
+  double step = header.Step;
+  switch (header.CodeSize)
+    {
+    case 1:
+      {
+      const uint8_t *codes = reinterpret_cast<const uint8_t*>(in);
+      for (size_t i = 0; i < n; ++i)
+        out[i] = static_cast<T>(lo + codes[i]*step);
+      }
+      break;
+    case 2:
+      {
+      const uint16_t *codes = reinterpret_cast<const uint16_t*>(in);
+      for (size_t i = 0; i < n; ++i)
+        out[i] = static_cast<T>(lo + codes[i]*step);
+      }
+      break;
+    default:
+      {
+      const uint32_t *codes = reinterpret_cast<const uint32_t*>(in);
+      for (size_t i = 0; i < n; ++i)
+        out[i] = static_cast<T>(lo + codes[i]*step);
+      }
+    }
+}
+
+}
+
+}
+
+#endif
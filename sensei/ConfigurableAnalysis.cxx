@@ -6,6 +6,8 @@
 
 #include "Autocorrelation.h"
 #include "Histogram.h"
+#include "JointHistogram.h"
+#include "MultiHistogram.h"
 #ifdef ENABLE_VTK_IO
 #include "VTKPosthocIO.h"
 #ifdef ENABLE_VTK_MPI
@@ -32,6 +34,8 @@
 #include <vtkNew.h>
 #include <vtkDataObject.h>
 
+#include <algorithm>
+#include <map>
 #include <vector>
 #include <pugixml.hpp>
 #include <sstream>
@@ -121,13 +125,23 @@ static int parse(MPI_Comm comm, int rank,
 
 struct ConfigurableAnalysis::InternalsType
 {
-  InternalsType() : Comm(MPI_COMM_NULL) {}
+  InternalsType() : Comm(MPI_COMM_NULL), RequiresAllData(false) {}
+
+  // adds an array to the data required by the analyses
+  int RequireArray(const std::string &mesh, int association,
+    const std::string &array);
+
+  // adds the meshes and arrays of the requirements to the data required
+  // by the analyses
+  int RequireData(const DataRequirements &reqs);
 
   // creates, initializes from xml, and adds the analysis
   // if it has been compiled into the build and is enabled.
   // a status message indicating success/failure is printed
   // by rank 0
   int AddHistogram(pugi::xml_node node);
+  int AddMultiHistogram(pugi::xml_node node);
+  int AddJointHistogram(pugi::xml_node node);
   int AddVTKmContour(pugi::xml_node node);
   int AddAdios(pugi::xml_node node);
   int AddCatalyst(pugi::xml_node node);
@@ -140,6 +154,10 @@ struct ConfigurableAnalysis::InternalsType
   // analysis in the list
   AnalysisAdaptorVector Analyses;
 
+  // the type and name of each of the analyses in the above list,
+  // they name its checkpoint files
+  std::vector<std::string> AnalysisKeys;
+
   // special analyses. these apear in the above list, however
   // they require special treatment which is simplified by
   // storing an additional pointer.
@@ -156,8 +174,55 @@ struct ConfigurableAnalysis::InternalsType
   // doesn't set a communicator correct behavior is insured
   // and superfluous Comm_dup's are avoided.
   MPI_Comm Comm;
+
+  // the meshes and arrays the analyses use. when the data an analysis
+  // uses can't be known from its configuration the flag is set and
+  // all of the data is required
+  DataRequirements Requirements;
+  bool RequiresAllData;
 };
 
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::RequireArray(const std::string &mesh,
+  int association, const std::string &array)
+{
+  std::vector<std::string> arrays;
+  this->Requirements.GetRequiredArrays(mesh, association, arrays);
+
+  if (std::find(arrays.begin(), arrays.end(), array) == arrays.end())
+    arrays.push_back(array);
+
+  return this->Requirements.AddRequirement(mesh, association, arrays);
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::RequireData(
+  const DataRequirements &reqs)
+{
+  MeshRequirementsIterator mit = reqs.GetMeshRequirementsIterator();
+  for (; mit; ++mit)
+    {
+    const std::string &mesh = mit.MeshName();
+    this->Requirements.AddRequirement(mesh, false);
+
+    int associations[] = {vtkDataObject::POINT, vtkDataObject::CELL};
+    for (int j = 0; j < 2; ++j)
+      {
+      std::vector<std::string> arrays;
+      reqs.GetRequiredArrays(mesh, associations[j], arrays);
+
+      unsigned int nArrays = arrays.size();
+      for (unsigned int i = 0; i < nArrays; ++i)
+        {
+        if (this->RequireArray(mesh, associations[j], arrays[i]))
+          return -1;
+        }
+      }
+    }
+
+  return 0;
+}
+
 // --------------------------------------------------------------------------
 int ConfigurableAnalysis::InternalsType::AddHistogram(pugi::xml_node node)
 {
@@ -185,12 +250,169 @@ int ConfigurableAnalysis::InternalsType::AddHistogram(pugi::xml_node node)
     histogram->SetCommunicator(this->Comm);
 
   histogram->Initialize(bins, mesh, association, array);
+  this->RequireArray(mesh, association, array);
+
+  bool singlePass = node.attribute("single_pass").as_int(0);
+  histogram->SetSinglePass(singlePass);
+
+  int threads = node.attribute("threads").as_int(1);
+  histogram->SetThreads(threads);
+
+  bool async = node.attribute("async").as_int(0);
+  histogram->SetAsynchronous(async);
+
+  // accumulate over time on a fixed or frozen range
+  std::ostringstream accum;
+  if (pugi::xml_attribute rangeAt = node.attribute("range"))
+    {
+    double range[2] = {0.0, 0.0};
+    if ((sscanf(rangeAt.value(), "%lf,%lf", range, range + 1) != 2) ||
+      !(range[1] > range[0]))
+      {
+      SENSEI_ERROR("Invalid histogram range \"" << rangeAt.value() << "\"")
+      return -1;
+      }
+    histogram->SetRange(range[0], range[1]);
+    accum << " accumulating on [" << range[0] << ", " << range[1] << "]";
+    }
+  else if (int freeze = node.attribute("freeze_range_after").as_int(0))
+    {
+    histogram->SetFreezeRangeAfter(freeze);
+    accum << " accumulating with range frozen after " << freeze << " steps";
+    }
+
+  // the accumulated bins are updated in place by a single thread and
+  // the range isn't found by a separate pass
+  if (!accum.str().empty() && ((threads != 1) || singlePass))
+    {
+    SENSEI_ERROR("threads and single_pass can't be used when accumulating"
+      " a histogram over time")
+    return -1;
+    }
+
+  int reduceEvery = node.attribute("reduce_every").as_int(0);
+  histogram->SetReduceInterval(reduceEvery);
+  if (!accum.str().empty())
+    accum << " reduced " << (reduceEvery > 0 ?
+      "every " + std::to_string(reduceEvery) + " steps" : std::string("at finalize"));
 
   this->Analyses.push_back(histogram.GetPointer());
 
   SENSEI_STATUS("Configured histogram with " << bins
     << " " << assocStr << "data array " << array
-    << " on mesh " << mesh)
+    << " on mesh " << mesh << (singlePass ? " single pass" : "")
+    << (async ? " asynchronous" : "") << accum.str()
+    << " threads " << threads)
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::AddMultiHistogram(pugi::xml_node node)
+{
+  if (requireAttribute(node, "mesh"))
+    {
+    SENSEI_ERROR("Failed to initialize MultiHistogram");
+    return -1;
+    }
+
+  // defaults for the arrays
+  std::string mesh = node.attribute("mesh").value();
+  std::string defAssocStr = node.attribute("association").as_string("point");
+  int defBins = node.attribute("bins").as_int(10);
+
+  vtkNew<MultiHistogram> histogram;
+
+  if (this->Comm != MPI_COMM_NULL)
+    histogram->SetCommunicator(this->Comm);
+
+  histogram->Initialize(mesh);
+
+  std::ostringstream arrays;
+  for (pugi::xml_node arrayNode = node.child("array");
+    arrayNode; arrayNode = arrayNode.next_sibling("array"))
+    {
+    if (requireAttribute(arrayNode, "name"))
+      {
+      SENSEI_ERROR("Failed to initialize MultiHistogram");
+      return -1;
+      }
+
+    int association = 0;
+    std::string assocStr =
+      arrayNode.attribute("association").as_string(defAssocStr.c_str());
+    if (VTKUtils::GetAssociation(assocStr, association))
+      {
+      SENSEI_ERROR("Failed to initialize MultiHistogram");
+      return -1;
+      }
+
+    std::string array = arrayNode.attribute("name").value();
+    int bins = arrayNode.attribute("bins").as_int(defBins);
+
+    histogram->AddArray(association, array, bins);
+    this->RequireArray(mesh, association, array);
+
+    arrays << " " << assocStr << " data array " << array
+      << " with " << bins << " bins";
+    }
+
+  if (histogram->GetNumberOfArrays() < 1)
+    {
+    SENSEI_ERROR("MultiHistogram requires at least one array element")
+    return -1;
+    }
+
+  bool singlePass = node.attribute("single_pass").as_int(0);
+  histogram->SetSinglePass(singlePass);
+
+  this->Analyses.push_back(histogram.GetPointer());
+
+  SENSEI_STATUS("Configured multi-histogram on mesh " << mesh
+    << arrays.str() << (singlePass ? " single pass" : ""))
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::AddJointHistogram(pugi::xml_node node)
+{
+  if (requireAttribute(node, "mesh") || requireAttribute(node, "x_array")
+    || requireAttribute(node, "y_array"))
+    {
+    SENSEI_ERROR("Failed to initialize JointHistogram");
+    return -1;
+    }
+
+  int association = 0;
+  std::string assocStr = node.attribute("association").as_string("point");
+  if (VTKUtils::GetAssociation(assocStr, association))
+    {
+    SENSEI_ERROR("Failed to initialize JointHistogram");
+    return -1;
+    }
+
+  std::string mesh = node.attribute("mesh").value();
+  std::string xArray = node.attribute("x_array").value();
+  std::string yArray = node.attribute("y_array").value();
+  int bins = node.attribute("bins").as_int(10);
+  int xBins = node.attribute("x_bins").as_int(bins);
+  int yBins = node.attribute("y_bins").as_int(bins);
+
+  vtkNew<JointHistogram> histogram;
+
+  if (this->Comm != MPI_COMM_NULL)
+    histogram->SetCommunicator(this->Comm);
+
+  histogram->Initialize(mesh, association, xArray, xBins, yArray, yBins);
+  this->RequireArray(mesh, association, xArray);
+  this->RequireArray(mesh, association, yArray);
+
+  this->Analyses.push_back(histogram.GetPointer());
+
+  SENSEI_STATUS("Configured joint histogram with " << xBins << " x "
+    << yBins << " bins of " << assocStr << " data arrays " << xArray
+    << " and " << yArray << " on mesh " << mesh)
 
   return 0;
 }
@@ -210,6 +432,8 @@ int ConfigurableAnalysis::InternalsType::AddVTKmContour(pugi::xml_node node)
     return -1;
     }
 
+  pugi::xml_attribute mesh = node.attribute("mesh");
+  pugi::xml_attribute array = node.attribute("array");
   double value = node.attribute("value").as_double(0.0);
   bool writeOutput = node.attribute("write_output").as_bool(false);
 
@@ -222,6 +446,9 @@ int ConfigurableAnalysis::InternalsType::AddVTKmContour(pugi::xml_node node)
 
   this->Analyses.push_back(contour.GetPointer());
 
+  // the contour is computed from a cell data array
+  this->RequireArray(mesh.value(), vtkDataObject::CELL, array.value());
+
   SENSEI_STATUS("Configured VTKmContourAnalysis " << array.value())
 
   return 0;
@@ -250,10 +477,61 @@ int ConfigurableAnalysis::InternalsType::AddAdios(pugi::xml_node node)
   if (method)
     adios->SetMethod(method.value());
 
+  // write in the background with at most this many steps in flight
+  int asyncDepth = node.attribute("async_depth").as_int(0);
+  adios->SetAsynchronous(asyncDepth);
+
+  int zeroCopy = node.attribute("zero_copy").as_int(0);
+  adios->SetZeroCopy(zeroCopy);
+
+  // per array compression, an array without a name sets the compression
+  // of the arrays of its association that have none of their own
+  std::ostringstream comps;
+  for (pugi::xml_node compNode = node.child("compression");
+    compNode; compNode = compNode.next_sibling("compression"))
+    {
+    if (requireAttribute(compNode, "stages"))
+      {
+      SENSEI_ERROR("Failed to initialize ADIOSAnalysisAdaptor");
+      return -1;
+      }
+
+    int association = 0;
+    std::string assocStr = compNode.attribute("association").as_string("point");
+    if (VTKUtils::GetAssociation(assocStr, association))
+      {
+      SENSEI_ERROR("Failed to initialize ADIOSAnalysisAdaptor");
+      return -1;
+      }
+
+    std::string array = compNode.attribute("array").value();
+    std::string stages = compNode.attribute("stages").value();
+    double tolerance = compNode.attribute("tolerance").as_double(0.0);
+
+    if (adios->SetCompression(association, array, stages, tolerance))
+      {
+      SENSEI_ERROR("Failed to initialize ADIOSAnalysisAdaptor");
+      return -1;
+      }
+
+    comps << " " << assocStr << " data array "
+      << (array.empty() ? "*" : array) << " compressed " << stages;
+    if (tolerance > 0.0)
+      comps << " tolerance " << tolerance;
+    }
+
   this->Analyses.push_back(adios.GetPointer());
 
+  // everything is written
+  this->RequiresAllData = true;
+
+  std::ostringstream opts;
+  if (asyncDepth > 0)
+    opts << " async depth " << asyncDepth << (zeroCopy ? " zero copy" : "");
+  opts << comps.str();
+
   SENSEI_STATUS("Configured ADIOSAnalysisAdaptor \"" << filename.value()
-    << "\" method " << method.value())
+    << "\" method " << method.value() << opts.str())
 
   return 0;
 #endif
@@ -276,6 +554,9 @@ int ConfigurableAnalysis::InternalsType::AddCatalyst(pugi::xml_node node)
       this->CatalystAdaptor->SetCommunicator(this->Comm);
 
     this->Analyses.push_back(this->CatalystAdaptor);
+
+    // the pipelines may use any of the data
+    this->RequiresAllData = true;
     }
 
   // Add the pipelines
@@ -379,6 +660,9 @@ int ConfigurableAnalysis::InternalsType::AddLibsim(pugi::xml_node node)
       this->LibsimAdaptor->SetMode(node.attribute("mode").value());
     this->LibsimAdaptor->Initialize();
     this->Analyses.push_back(this->LibsimAdaptor);
+
+    // the plots may use any of the data
+    this->RequiresAllData = true;
     }
 
   bool doExport = false;
@@ -494,18 +778,62 @@ int ConfigurableAnalysis::InternalsType::AddAutoCorrelation(pugi::xml_node node)
   int window = node.attribute("window").as_int(10);
   int kMax = node.attribute("k-max").as_int(3);
 
+  std::string precision = node.attribute("precision").as_string("float");
+  if ((precision != "float") && (precision != "double"))
+    {
+    SENSEI_ERROR("Invalid precision \"" << precision
+      << "\". Use float or double")
+    return -1;
+    }
+
+  std::string engine = node.attribute("engine").as_string("direct");
+  if ((engine != "direct") && (engine != "fft"))
+    {
+    SENSEI_ERROR("Invalid engine \"" << engine
+      << "\". Use direct or fft")
+    return -1;
+    }
+
   vtkNew<Autocorrelation> adaptor;
 
   if (this->Comm != MPI_COMM_NULL)
     adaptor->SetCommunicator(this->Comm);
 
+  adaptor->SetDoublePrecision(precision == "double");
+
+  int threads = node.attribute("threads").as_int(1);
+  adaptor->SetThreads(threads);
+
+  adaptor->SetEngine(engine == "fft" ?
+    Autocorrelation::ENGINE_FFT : Autocorrelation::ENGINE_DIRECT);
+
+  // hold at most block_limit blocks in memory, swapping the others to
+  // files in the storage directory
+  std::ostringstream opts;
+  int blockLimit = node.attribute("block_limit").as_int(-1);
+  if (blockLimit > 0)
+    {
+    std::string storage = node.attribute("storage").as_string("/tmp");
+    adaptor->SetBlockLimit(blockLimit);
+    adaptor->SetStoragePath(storage);
+    opts << " block limit " << blockLimit << " storage " << storage;
+    }
+
+  int reportEvery = node.attribute("report_every").as_int(0);
+  adaptor->SetReportInterval(reportEvery);
+  if (reportEvery > 0)
+    opts << " report every " << reportEvery;
+
   adaptor->Initialize(window, meshName, assoc, arrayName, kMax);
+  this->RequireArray(meshName, assoc, arrayName);
 
   this->Analyses.push_back(adaptor.GetPointer());
 
   SENSEI_STATUS("Configured Autocorrelation " << assocStr
     << " data array " << arrayName << " on mesh " << meshName
-    << " window " << window << " k-max " << kMax)
+    << " window " << window << " k-max " << kMax
+    << " precision " << precision << " threads " << threads
+    << " engine " << engine << opts.str())
 
   return 0;
 }
@@ -546,6 +874,8 @@ int ConfigurableAnalysis::InternalsType::AddPosthocIO(pugi::xml_node node)
 
   this->Analyses.push_back(adapter.GetPointer());
 
+  this->RequireData(req);
+
   SENSEI_STATUS("Configured VTKPosthocIO")
 
   return 0;
@@ -588,6 +918,8 @@ int ConfigurableAnalysis::InternalsType::AddVTKAmrWriter(pugi::xml_node node)
 
   this->Analyses.push_back(adapter.GetPointer());
 
+  this->RequireData(req);
+
   SENSEI_STATUS("Configured VTKAmrWriter")
 
   return 0;
@@ -646,6 +978,7 @@ int ConfigurableAnalysis::Initialize(const std::string& filename)
     }
 
   int rv = 0;
+  std::map<std::string, int> typeCount;
   pugi::xml_node root = doc.child("sensei");
   for (pugi::xml_node node = root.child("analysis");
     node; node = node.next_sibling("analysis"))
@@ -654,7 +987,28 @@ int ConfigurableAnalysis::Initialize(const std::string& filename)
       continue;
 
     std::string type = node.attribute("type").value();
+
+    // analyses are keyed by type and name so that their checkpoints
+    // are found when others are enabled or disabled. the name defaults
+    // to the number of analyses of the same type before this one
+    std::string name = node.attribute("name").as_string(
+      std::to_string(typeCount[type]).c_str());
+    std::string key = type + "." + name;
+    if (std::find(this->Internals->AnalysisKeys.begin(),
+      this->Internals->AnalysisKeys.end(), key) !=
+      this->Internals->AnalysisKeys.end())
+      {
+      if (rank == 0)
+        SENSEI_ERROR("Duplicate '" << type << "' analysis named '"
+          << name << "'")
+      rv -= 1;
+      continue;
+      }
+
+    size_t nAnalyses = this->Internals->Analyses.size();
     if (!(((type == "histogram") && !this->Internals->AddHistogram(node))
+      || ((type == "multihistogram") && !this->Internals->AddMultiHistogram(node))
+      || ((type == "jointhistogram") && !this->Internals->AddJointHistogram(node))
       || ((type == "autocorrelation") && !this->Internals->AddAutoCorrelation(node))
       || ((type == "adios") && !this->Internals->AddAdios(node))
       || ((type == "catalyst") && !this->Internals->AddCatalyst(node))
@@ -667,11 +1021,29 @@ int ConfigurableAnalysis::Initialize(const std::string& filename)
         SENSEI_ERROR("Failed to add '" << type << "' analysis")
       rv -= 1;
       }
+
+    // catalyst and libsim add their pipelines to a single analysis
+    if (this->Internals->Analyses.size() > nAnalyses)
+      {
+      this->Internals->AnalysisKeys.push_back(key);
+      typeCount[type] += 1;
+      }
     }
 
   return rv;
 }
 
+//----------------------------------------------------------------------------
+int ConfigurableAnalysis::GetDataRequirements(DataRequirements &reqs)
+{
+  if (this->Internals->RequiresAllData)
+    reqs.Clear();
+  else
+    reqs = this->Internals->Requirements;
+
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 bool ConfigurableAnalysis::Execute(DataAdaptor* data)
 {
@@ -715,6 +1087,48 @@ int ConfigurableAnalysis::Finalize()
   return rv;
 }
 
+//----------------------------------------------------------------------------
+int ConfigurableAnalysis::WriteCheckpoint(const std::string &fileName)
+{
+  int rv = 0;
+  size_t n = this->Internals->Analyses.size();
+  for (size_t i = 0; i < n; ++i)
+    {
+    std::string analysisFile =
+      fileName + "." + this->Internals->AnalysisKeys[i];
+
+    AnalysisAdaptor *analysis = this->Internals->Analyses[i].GetPointer();
+    if (analysis->WriteCheckpoint(analysisFile))
+      {
+      SENSEI_ERROR("Failed to checkpoint " << analysis->GetClassName())
+      rv -= 1;
+      }
+    }
+
+  return rv;
+}
+
+//----------------------------------------------------------------------------
+int ConfigurableAnalysis::ReadCheckpoint(const std::string &fileName)
+{
+  int rv = 0;
+  size_t n = this->Internals->Analyses.size();
+  for (size_t i = 0; i < n; ++i)
+    {
+    std::string analysisFile =
+      fileName + "." + this->Internals->AnalysisKeys[i];
+
+    AnalysisAdaptor *analysis = this->Internals->Analyses[i].GetPointer();
+    if (analysis->ReadCheckpoint(analysisFile))
+      {
+      SENSEI_ERROR("Failed to restore " << analysis->GetClassName())
+      rv -= 1;
+      }
+    }
+
+  return rv;
+}
+
 //----------------------------------------------------------------------------
 void ConfigurableAnalysis::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -9,6 +9,8 @@
 namespace sensei
 {
 
+class DataRequirements;
+
 /// @brief ConfigurableAnalysis is all-in-one analysis adaptor that
 /// can execute all available analysis adaptors.
 class ConfigurableAnalysis : public AnalysisAdaptor
@@ -28,10 +30,33 @@ public:
   /// @brief Initialize the adaptor using the configuration specified.
   int Initialize(const std::string& filename);
 
+  /// @brief Get the meshes and arrays the configured analyses use.
+  ///
+  /// This lets a reader, such as the ADIOS end point, read only the data
+  /// the analyses need. When an analysis may use data that can't be known
+  /// from its configuration, as do the adios, catalyst, and libsim
+  /// analyses, the requirements are cleared, meaning all of the data.
+  /// @returns zero if successful
+  int GetDataRequirements(DataRequirements &reqs);
+
   bool Execute(DataAdaptor* data) override;
 
   int Finalize() override;
 
+  /// @brief Save the state of each of the analyses.
+  ///
+  /// The state of each analysis is written to fileName.type.name, where
+  /// type is the analysis' type attribute and name its name attribute.
+  /// The name defaults to the number of analyses of the same type
+  /// configured before it.
+  int WriteCheckpoint(const std::string &fileName) override;
+
+  /// @brief Restore the state of each of the analyses.
+  ///
+  /// The state of each analysis is read from fileName.type.name, as
+  /// written by WriteCheckpoint.
+  int ReadCheckpoint(const std::string &fileName) override;
+
 protected:
   ConfigurableAnalysis();
   ~ConfigurableAnalysis();
@@ -52,6 +52,7 @@ void DataRequirements::Clear()
 {
   this->MeshNames.clear();
   this->MeshArrayMap.clear();
+  this->MeshBoundsMap.clear();
 }
 
 // --------------------------------------------------------------------------
@@ -90,6 +91,26 @@ int DataRequirements::Initialize(pugi::xml_node parent)
     if (getArrayNames(node.child("point_arrays"), arrays))
       this->MeshArrayMap[meshName][vtkDataObject::POINT] = arrays;
 
+    // get the region of interest, optional
+    if (node.attribute("bounds"))
+      {
+      std::istringstream iss(node.attribute("bounds").as_string());
+      double bounds[6] = {0.0};
+      for (int i = 0; i < 6; ++i)
+        iss >> bounds[i];
+
+      if (iss.fail())
+        {
+        SENSEI_ERROR("Mesh \"" << meshName << "\" has invalid bounds. "
+          "6 values, x0 x1 y0 y1 z0 z1, are required")
+        retVal = -1;
+        }
+      else
+        {
+        this->SetRegionOfInterest(meshName, bounds);
+        }
+      }
+
     meshId += 1;
     }
 
@@ -166,6 +187,38 @@ int DataRequirements::AddRequirement(const std::string &meshName,
   return 0;
 }
 
+// --------------------------------------------------------------------------
+int DataRequirements::SetRegionOfInterest(const std::string &meshName,
+  const double bounds[6])
+{
+  if (meshName.empty())
+    {
+    SENSEI_ERROR("A mesh name is required")
+    return -1;
+    }
+
+  // the mesh is required, though only the parts of it inside the region
+  this->MeshNames.insert(std::make_pair(meshName, false));
+
+  this->MeshBoundsMap[meshName].assign(bounds, bounds + 6);
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int DataRequirements::GetRegionOfInterest(const std::string &meshName,
+  double bounds[6]) const
+{
+  MeshBoundsMapType::const_iterator it = this->MeshBoundsMap.find(meshName);
+  if (it == this->MeshBoundsMap.end())
+    return -1;
+
+  for (int i = 0; i < 6; ++i)
+    bounds[i] = it->second[i];
+
+  return 0;
+}
+
 // --------------------------------------------------------------------------
 int DataRequirements::GetRequiredMesh(unsigned int id, std::string &mesh) const
 {
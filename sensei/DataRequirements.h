@@ -31,10 +31,11 @@ public:
   bool Empty() const { return this->MeshArrayMap.empty(); }
 
   /// initialize from XML. the XML should contain one or more
-  /// mesh elements each with zero or more array groups
+  /// mesh elements each with zero or more array groups. the optional
+  /// bounds attribute gives a region of interest on the mesh
   ///
   /// <parent>
-  ///   <mesh name="mesh_1" structure_only="1">
+  ///   <mesh name="mesh_1" structure_only="1" bounds="x0 x1 y0 y1 z0 z1">
   ///     <cell_arrays>  array_1, ... array_n </cell_arrays>
   ///     <point_arrays>  array_1, ... array_n </point_arrays>
   ///   </mesh>
@@ -76,6 +77,19 @@ public:
   int AddRequirement(const std::string &meshName, int association,
     const std::vector<std::string> &arrays);
 
+  /// Sets a region of interest on a specific mesh
+  /// Only the parts of the mesh inside the region are required
+  /// @param[in] meshName name of the mesh
+  /// @param[in] bounds the region given as x0 x1 y0 y1 z0 z1
+  /// @returns zero if successful
+  int SetRegionOfInterest(const std::string &meshName, const double bounds[6]);
+
+  /// For the named mesh, gets the region of interest
+  /// @param[in] meshName the name of the mesh
+  /// @param[out] bounds the region given as x0 x1 y0 y1 z0 z1
+  /// @returns zero if the mesh has a region of interest
+  int GetRegionOfInterest(const std::string &meshName, double bounds[6]) const;
+
   /// Get the list of meshes
   /// @param[out] meshes a vector where mesh names will be stored
   /// @returns zero if successful
@@ -114,6 +128,7 @@ public:
   using AssocArrayMapType = std::map<int, std::vector<std::string>>;
   using MeshArrayMapType = std::map<std::string, AssocArrayMapType>;
   using MeshNamesType = std::map<std::string, bool>;
+  using MeshBoundsMapType = std::map<std::string, std::vector<double>>;
 
 private:
   friend class ArrayRequirementsIterator;
@@ -121,6 +136,7 @@ private:
 
   MeshNamesType MeshNames;
   MeshArrayMapType MeshArrayMap;
+  MeshBoundsMapType MeshBoundsMap;
 };
 
 // iterate over the meshes
@@ -15,6 +15,8 @@
 #include <algorithm>
 #include <vector>
 
+#include <diy/master.hpp>
+
 namespace sensei
 {
 
@@ -23,14 +25,20 @@ senseiNewMacro(Histogram);
 
 //-----------------------------------------------------------------------------
 Histogram::Histogram() : Bins(0),
-  Association(vtkDataObject::FIELD_ASSOCIATION_POINTS), Internals(nullptr)
+  Association(vtkDataObject::FIELD_ASSOCIATION_POINTS), SinglePass(false),
+  Threads(1), Asynchronous(false), FixedRange(false), FreezeRangeAfter(0),
+  ReduceInterval(0), StepCount(0), LastReduced(0), RangeFrozen(false),
+  Internals(nullptr), Pending(nullptr)
 {
+  this->Range[0] = 0.0;
+  this->Range[1] = 0.0;
 }
 
 //-----------------------------------------------------------------------------
 Histogram::~Histogram()
 {
   delete this->Internals;
+  delete this->Pending;
 }
 
 //-----------------------------------------------------------------------------
@@ -44,6 +52,14 @@ void Histogram::Initialize(int bins,
   this->Association = association;
 }
 
+//-----------------------------------------------------------------------------
+void Histogram::SetRange(double min, double max)
+{
+  this->Range[0] = min;
+  this->Range[1] = max;
+  this->FixedRange = true;
+}
+
 //-----------------------------------------------------------------------------
 const char *Histogram::GetGhostArrayName()
 {
@@ -61,9 +77,22 @@ bool Histogram::Execute(DataAdaptor* data)
 {
   timer::MarkEvent mark("Histogram::Execute");
 
-  delete this->Internals;
-  this->Internals = new VTKHistogram;
+  // gather the arrays of the local blocks. all ranks take part in the
+  // reductions even when they have no data or there was an error
+  std::vector<HistogramBlock> blocks;
+  bool ok = this->GetBlocks(data, blocks) == 0;
+
+  if (this->Accumulating())
+    this->AccumulateHistogram(blocks);
+  else
+    this->ComputeHistogram(blocks);
 
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+int Histogram::GetBlocks(DataAdaptor* data, std::vector<HistogramBlock> &blocks)
+{
   vtkDataObject* mesh = nullptr;
   if (data->GetMesh(this->MeshName, true, mesh))
     {
@@ -74,12 +103,7 @@ bool Histogram::Execute(DataAdaptor* data)
     {
     // it is not an necessarilly an error if all ranks do not have
     // a dataset to process
-    this->Internals->PreCompute(this->GetCommunicator(), this->Bins);
-
-    this->Internals->PostCompute(this->GetCommunicator(),
-      this->Bins, this->ArrayName);
-
-    return true;
+    return 0;
     }
 
   if (data->AddArray(mesh, this->MeshName, this->Association, this->ArrayName))
@@ -89,13 +113,7 @@ bool Histogram::Execute(DataAdaptor* data)
     SENSEI_ERROR(<< data->GetClassName() << " failed to add "
       << (this->Association == vtkDataObject::POINT ? "point" : "cell")
       << " data array \""  << this->ArrayName << "\"")
-
-    this->Internals->PreCompute(this->GetCommunicator(), this->Bins);
-
-    this->Internals->PostCompute(this->GetCommunicator(),
-      this->Bins, this->ArrayName);
-
-    return false;
+    return -1;
     }
 
   int nLayers = 0;
@@ -104,13 +122,13 @@ bool Histogram::Execute(DataAdaptor* data)
    if (nLayers > 0 && data->AddGhostCellsArray(mesh, this->MeshName))
      {
      SENSEI_ERROR(<< data->GetClassName() << " failed to add ghost cells.")
-     return false;
+     return -1;
      }
    }
   else
    {
    SENSEI_ERROR(<< data->GetClassName() << " failed to query for ghost cells.")
-   return false;
+   return -1;
    }
 
   if (vtkCompositeDataSet* cd = dynamic_cast<vtkCompositeDataSet*>(mesh))
@@ -136,37 +154,8 @@ bool Histogram::Execute(DataAdaptor* data)
       vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
         this->GetArray(curObj, this->GetGhostArrayName()));
 
-      // compute local histogram range
-      this->Internals->AddRange(array, ghostArray);
+      blocks.push_back({array, ghostArray, nullptr});
       }
-
-    // compute global histogram range
-    this->Internals->PreCompute(this->GetCommunicator(), this->Bins);
-
-    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
-      {
-      // get the local mesh
-      vtkDataObject *curObj = iter->GetCurrentDataObject();
-      // get the array to compute histogram for
-      vtkDataArray* array = this->GetArray(curObj, this->ArrayName);
-      if (!array)
-        {
-        SENSEI_WARNING("Dataset " << iter->GetCurrentFlatIndex()
-          << " has no array named \"" << this->ArrayName << "\"")
-        continue;
-        }
-
-      // and get the ghost cell array
-      vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
-        this->GetArray(curObj, this->GetGhostArrayName()));
-
-      // compute local histogram
-      this->Internals->Compute(array, ghostArray);
-      }
-
-    // compute the global histogram
-    this->Internals->PostCompute(this->GetCommunicator(),
-      this->Bins, this->ArrayName);
     }
   else
     {
@@ -178,26 +167,185 @@ bool Histogram::Execute(DataAdaptor* data)
 
       SENSEI_WARNING("Dataset " << rank << " has no array named \""
         << this->ArrayName << "\"")
+      return 0;
+      }
 
-      this->Internals->PreCompute(this->GetCommunicator(), this->Bins);
+    vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
+      this->GetArray(mesh, this->GetGhostArrayName()));
 
-      this->Internals->PostCompute(this->GetCommunicator(),
-        this->Bins, this->ArrayName);
-      }
-    else
+    blocks.push_back({array, ghostArray, nullptr});
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+void Histogram::ComputeHistogram(std::vector<HistogramBlock> &blocks)
+{
+  // in asynchronous mode the previous result is kept until its
+  // reduction has been completed
+  if (this->Asynchronous)
+    {
+    delete this->Pending;
+    this->Pending = this->Internals;
+    }
+  else
+    {
+    delete this->Internals;
+    }
+  this->Internals = new VTKHistogram;
+
+  if ((this->Threads != 1) && (blocks.size() > 1))
+    {
+    this->ComputeThreaded(blocks);
+    }
+  else
+    {
+    // compute local histogram range
+    for (size_t i = 0; i < blocks.size(); ++i)
       {
-      vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
-        this->GetArray(mesh, this->GetGhostArrayName()));
+      if (this->SinglePass)
+        this->Internals->AddRangeAndCompute(blocks[i].Array,
+          blocks[i].GhostArray, this->Bins);
+      else
+        this->Internals->AddRange(blocks[i].Array, blocks[i].GhostArray);
+      }
 
-      this->Internals->AddRange(array, ghostArray);
-      this->Internals->PreCompute(this->GetCommunicator(), this->Bins);
-      this->Internals->Compute(array, ghostArray);
+    // compute global histogram range
+    this->PreCompute();
 
-      this->Internals->PostCompute(this->GetCommunicator(),
-        this->Bins, this->ArrayName);
+    // compute local histogram
+    for (size_t i = 0; !this->SinglePass && (i < blocks.size()); ++i)
+      this->Internals->Compute(blocks[i].Array, blocks[i].GhostArray);
+    }
+
+  // compute the global histogram
+  this->PostCompute();
+}
+
+//-----------------------------------------------------------------------------
+void Histogram::AccumulateHistogram(std::vector<HistogramBlock> &blocks)
+{
+  // the histogram persists across steps
+  if (this->StepCount == 0)
+    {
+    delete this->Internals;
+    this->Internals = new VTKHistogram;
+    }
+
+  if (!this->RangeFrozen && this->FixedRange)
+    {
+    // the range is known, no communication is needed
+    this->Internals->Initialize(this->Range, this->Bins);
+    this->RangeFrozen = true;
+    }
+
+  if (this->RangeFrozen)
+    {
+    for (size_t i = 0; i < blocks.size(); ++i)
+      this->Internals->Compute(blocks[i].Array, blocks[i].GhostArray);
+    }
+  else
+    {
+    // until the range is frozen the data is binned on the provisional
+    // fine grid which adapts as the range grows
+    for (size_t i = 0; i < blocks.size(); ++i)
+      this->Internals->AddRangeAndCompute(blocks[i].Array,
+        blocks[i].GhostArray, this->Bins);
+
+    if (this->StepCount + 1 >= this->FreezeRangeAfter)
+      {
+      this->PreCompute();
+      this->RangeFrozen = true;
       }
     }
-  return true;
+
+  ++this->StepCount;
+
+  if (this->RangeFrozen && (this->ReduceInterval > 0) &&
+    ((this->StepCount % this->ReduceInterval) == 0))
+    {
+    this->PostCompute();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void Histogram::ComputeThreaded(std::vector<HistogramBlock> &blocks)
+{
+  timer::MarkEvent mark("Histogram::ComputeThreaded");
+
+  // each block gets a private histogram. the blocks are processed by
+  // diy's thread pool and the private histograms are merged afterward
+  size_t nBlocks = blocks.size();
+  std::vector<VTKHistogram> privates(nBlocks);
+
+  diy::Master master(this->GetCommunicator(), this->Threads);
+  for (size_t i = 0; i < nBlocks; ++i)
+    {
+    blocks[i].Private = &privates[i];
+    master.add(i, &blocks[i], new diy::Link);
+    }
+
+  int bins = this->Bins;
+  bool singlePass = this->SinglePass;
+
+  // compute local histogram range
+  master.foreach<HistogramBlock>(
+    [bins,singlePass](HistogramBlock *b, const diy::Master::ProxyWithLink&, void*)
+    {
+    if (singlePass)
+      b->Private->AddRangeAndCompute(b->Array, b->GhostArray, bins);
+    else
+      b->Private->AddRange(b->Array, b->GhostArray);
+    });
+
+  for (size_t i = 0; i < nBlocks; ++i)
+    this->Internals->Merge(privates[i]);
+
+  // compute global histogram range
+  this->PreCompute();
+
+  double range[2];
+  this->Internals->GetRange(range);
+
+  // compute local histogram
+  master.foreach<HistogramBlock>(
+    [bins,singlePass,&range](HistogramBlock *b, const diy::Master::ProxyWithLink&, void*)
+    {
+    b->Private->Initialize(range, bins);
+    if (!singlePass)
+      b->Private->Compute(b->Array, b->GhostArray);
+    });
+
+  for (size_t i = 0; i < nBlocks; ++i)
+    this->Internals->Merge(privates[i]);
+}
+
+//-----------------------------------------------------------------------------
+void Histogram::PreCompute()
+{
+  this->Internals->StartPreCompute(this->GetCommunicator());
+
+  if (this->Pending)
+    {
+    this->Pending->FinishPostCompute();
+    delete this->Pending;
+    this->Pending = nullptr;
+    }
+
+  this->Internals->FinishPreCompute(this->Bins);
+}
+
+//-----------------------------------------------------------------------------
+void Histogram::PostCompute()
+{
+  this->LastReduced = this->StepCount;
+
+  this->Internals->StartPostCompute(this->GetCommunicator(),
+    this->Bins, this->ArrayName);
+
+  if (!this->Asynchronous)
+    this->Internals->FinishPostCompute();
 }
 
 //-----------------------------------------------------------------------------
@@ -212,7 +360,7 @@ vtkDataArray* Histogram::GetArray(vtkDataObject* dobj, const std::string& arrayn
 
 //-----------------------------------------------------------------------------
 int Histogram::GetHistogram(double &min, double &max,
-  std::vector<unsigned int> &bins)
+  std::vector<uint64_t> &bins)
 {
   if (!this->Internals)
     return -1;
@@ -223,6 +371,35 @@ int Histogram::GetHistogram(double &min, double &max,
 //-----------------------------------------------------------------------------
 int Histogram::Finalize()
 {
+  if (this->Accumulating())
+    {
+    // reduce the steps since the last reduction. the result is kept
+    // so that it may be queried with GetHistogram
+    if (this->Internals && (this->StepCount > this->LastReduced))
+      {
+      if (!this->RangeFrozen)
+        this->PreCompute();
+      this->PostCompute();
+      }
+
+    if (this->Internals)
+      this->Internals->FinishPostCompute();
+
+    // the next step starts a new accumulation
+    this->StepCount = 0;
+    this->LastReduced = 0;
+    this->RangeFrozen = false;
+
+    return 0;
+    }
+
+  // complete outstanding reductions, this reports the last result
+  if (this->Internals)
+    this->Internals->FinishPostCompute();
+
+  delete this->Pending;
+  this->Pending = nullptr;
+
   delete this->Internals;
   this->Internals = nullptr;
   return 0;
@@ -3,10 +3,12 @@
 
 #include "AnalysisAdaptor.h"
 #include <mpi.h>
+#include <cstdint>
 #include <vector>
 
 class vtkDataObject;
 class vtkDataArray;
+class vtkUnsignedCharArray;
 
 namespace sensei
 {
@@ -24,13 +26,70 @@ public:
   void Initialize(int bins, const std::string &meshName,
     int association, const std::string& arrayname);
 
+  /// @brief Enable single pass mode
+  ///
+  /// In single pass mode each array is read once per time step. The
+  /// local range is found while the data is binned on a provisional fine
+  /// grid, once the global range is known the provisional bins are moved
+  /// onto the final bins. Counts near bin edges are approximate to within
+  /// a small fraction of a bin. Integer arrays whose range spans fewer
+  /// than 256 values per bin are binned exactly. The default is off.
+  void SetSinglePass(bool val) { this->SinglePass = val; }
+
+  /// @brief Set the number of threads used to process local blocks
+  ///
+  /// When there are multiple local blocks they are distributed over a
+  /// pool of threads, each block is binned into private bins which are
+  /// merged before the global reduction. -1 uses all of the hardware
+  /// threads. The default is 1.
+  void SetThreads(int val) { this->Threads = val; }
+
+  /// @brief Enable asynchronous mode
+  ///
+  /// In asynchronous mode the reduction of the bins to rank 0 is
+  /// nonblocking and Execute returns without waiting for it. The
+  /// reduction is completed, and the result printed, during the next
+  /// Execute while the next global range is being reduced, or by
+  /// GetHistogram or Finalize. The default is off.
+  void SetAsynchronous(bool val) { this->Asynchronous = val; }
+
+  /// @brief Accumulate the histogram over time on a fixed range
+  ///
+  /// Bins are accumulated across time steps into a persistent buffer
+  /// and no range reduction is needed. Values outside of the range are
+  /// counted in the first and last bins. The bins are 64 bit so that
+  /// they don't overflow over long runs. SinglePass and Threads don't
+  /// apply when accumulating, the data is binned by the calling thread
+  /// without a separate range pass.
+  void SetRange(double min, double max);
+
+  /// @brief Accumulate the histogram over time, freezing the range
+  ///
+  /// The global range is found over the first nSteps steps, after
+  /// which it is frozen. Until then the data is binned on an adaptive
+  /// fine grid as in single pass mode, and bins are accumulated across
+  /// time steps into a persistent buffer. Values outside of the frozen
+  /// range are counted in the first and last bins. As with SetRange,
+  /// SinglePass and Threads don't apply.
+  void SetFreezeRangeAfter(int nSteps) { this->FreezeRangeAfter = nSteps; }
+
+  /// @brief Set how often the accumulated histogram is reduced
+  ///
+  /// When accumulating over time the global histogram is computed
+  /// every nSteps steps. When 0, the default, it is computed only by
+  /// Finalize, and remains available from GetHistogram after Finalize.
+  void SetReduceInterval(int nSteps) { this->ReduceInterval = nSteps; }
+
   bool Execute(DataAdaptor* data) override;
 
   int Finalize() override;
 
   // return the last computed histogram
   int GetHistogram(double &min, double &max,
-    std::vector<unsigned int> &bins);
+    std::vector<uint64_t> &bins);
+
+  // the name of the ghost array, it depends on the VTK version
+  static const char *GetGhostArrayName();
 
 protected:
   Histogram();
@@ -39,15 +98,56 @@ protected:
   Histogram(const Histogram&) = delete;
   void operator=(const Histogram&) = delete;
 
-  static const char *GetGhostArrayName();
+  // a local block's arrays and, when blocks are processed
+  // in parallel, its private histogram
+  struct HistogramBlock
+  {
+    vtkDataArray *Array;
+    vtkUnsignedCharArray *GhostArray;
+    VTKHistogram *Private;
+  };
+
   vtkDataArray* GetArray(vtkDataObject* dobj, const std::string& arrayname);
 
+  // get the arrays of the local blocks
+  int GetBlocks(DataAdaptor* data, std::vector<HistogramBlock> &blocks);
+
+  // compute the histogram of the current step
+  void ComputeHistogram(std::vector<HistogramBlock> &blocks);
+
+  // add the current step to the histogram accumulated over time
+  void AccumulateHistogram(std::vector<HistogramBlock> &blocks);
+
+  bool Accumulating() const
+    { return this->FixedRange || (this->FreezeRangeAfter > 0); }
+
+  // compute the local histogram over blocks in parallel
+  void ComputeThreaded(std::vector<HistogramBlock> &blocks);
+
+  // compute the global range, and in asynchronous mode complete the
+  // previous step's reduction while the range is in flight
+  void PreCompute();
+
+  // compute the global histogram
+  void PostCompute();
+
   int Bins;
   std::string MeshName;
   std::string ArrayName;
   int Association;
+  bool SinglePass;
+  int Threads;
+  bool Asynchronous;
+  bool FixedRange;
+  double Range[2];
+  int FreezeRangeAfter;
+  int ReduceInterval;
+  int StepCount;
+  int LastReduced;
+  bool RangeFrozen;
 
   VTKHistogram *Internals;
+  VTKHistogram *Pending;
 
 };
 
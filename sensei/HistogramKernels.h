@@ -0,0 +1,819 @@
+#ifndef sensei_HistogramKernels_h
+#define sensei_HistogramKernels_h
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace sensei
+{
+
+/// Low level binning kernels used by the histogram analyses. The kernels
+/// operate on contiguous single component arrays and are independent of
+/// VTK so that they may be shared by the different array dispatch
+/// mechanisms and exercised directly by the benchmarks.
+///
+/// Bin indices are computed as (x - min)*(1/width), the reciprocal is
+/// computed once per call. Values equal to the max land in an extra bin
+/// that is folded into the last bin when the kernel returns. Values
+/// outside of the range are clamped into the first and last bins.
+///
+/// When the compiler targets AVX-512 or AVX2 the bin indices for float,
+/// double, and int arrays are computed with vector instructions, each
+/// SIMD lane increments a private copy of the bins to avoid store to load
+/// forwarding stalls when neighboring values fall in the same bin. The
+/// private copies are merged when the kernel returns. Other types, and
+/// other instruction sets, use a scalar loop over the same layout.
+///
+/// The kernels take an optional vtkGhostType array. An element is skipped
+/// when its ghost value has a bit in common with ghostMask. The ghost
+/// array is examined in tiles, tiles without ghosts take the unmasked
+/// path, tiles of only ghosts are skipped, and in mixed tiles the ghost
+/// elements are redirected to a discarded bin rather than branched
+/// around.
+namespace HistogramKernels
+{
+
+/// Adds the histogram of n values of data, on the range [min, max] with
+/// nBins bins, to hist. hist must have at least nBins elements and may
+/// be of a wider type than the counts of a single call, as is used to
+/// accumulate over time. Elements flagged in ghost are skipped, ghost
+/// may be null.
+template <typename T, typename H>
+void Bin(const T *data, const unsigned char *ghost, size_t n,
+  double min, double max, int nBins, H *hist,
+  unsigned char ghostMask = 0xff);
+
+/// Updates range with the range of the n values of data. Elements
+/// flagged in ghost are skipped, ghost may be null.
+template <typename T>
+void Range(const T *data, const unsigned char *ghost, size_t n,
+  double range[2], unsigned char ghostMask = 0xff);
+
+/// Adds the joint histogram of the n pairs (x[i], y[i]) to hist which
+/// has nx by ny bins on the ranges xRange and yRange, with x varying
+/// fastest. Pairs flagged in ghost are skipped, ghost may be null.
+template <typename T1, typename T2, typename H>
+void Bin2D(const T1 *x, const T2 *y, const unsigned char *ghost, size_t n,
+  const double xRange[2], int nx, const double yRange[2], int ny,
+  H *hist, unsigned char ghostMask = 0xff);
+
+/// Accumulates a provisional histogram of values whose range is not
+/// known in advance, reading each value from memory once. Values are
+/// processed in cache sized chunks, the range of each chunk is found
+/// and the chunk is binned on a fine grid while it is still in cache.
+/// When a chunk falls outside of the fine grid, the grid is shifted by
+/// whole bins if the values seen so far fit, otherwise its width is
+/// doubled and neighboring bins are merged until it fits. Once the
+/// global range is known the fine bins are redistributed onto the
+/// final bins, fine bins that straddle a final bin edge are split in
+/// proportion to their overlap. The total count is exact, counts near
+/// the final bin edges are approximate to within a fraction of a fine
+/// bin.
+///
+/// Integer values land exactly on the edges of a grid of arbitrary width
+/// so, while only integer types are added, the fine bins are centered on
+/// integers and span a power of two of them. Fine bins that straddle a
+/// final edge are then split by the number of their integers that the
+/// final binning places on either side, which is exact when each fine bin
+/// holds a single integer, that is when the range spans fewer integers
+/// than there are fine bins.
+class StreamingBins
+{
+public:
+  /// nFine is the number of fine bins, it is rounded up to be even.
+  StreamingBins(int nFine);
+
+  /// Adds n values of data. Elements flagged in ghost are skipped,
+  /// ghost may be null.
+  template <typename T>
+  void Add(const T *data, const unsigned char *ghost, size_t n,
+    unsigned char ghostMask = 0xff);
+
+  /// Get the range of the values added so far. If no values were added
+  /// the range is [DBL_MAX, -DBL_MAX]
+  void GetRange(double range[2]) const
+    {
+    range[0] = this->Min;
+    range[1] = this->Max;
+    }
+
+  /// Adds the fine bins to hist which has nBins on the range [min, max].
+  template <typename H>
+  void Rebin(double min, double max, int nBins, H *hist) const;
+
+  /// the number of values in a chunk.
+  enum { CHUNK_SIZE = 4096 };
+
+private:
+  // widen the fine grid until it covers [lo, hi]
+  void Grow(double lo, double hi);
+
+  double Min;
+  double Max;
+  double Lo;
+  double Width;
+  bool Integral;
+  std::vector<uint64_t> Counts;
+};
+
+namespace detail
+{
+// the number of ghost array elements classified at once
+enum { GHOST_TILE = 64 };
+
+// the number of pairs binned at once by the 2D kernel. the bin
+// indices of a tile are held in a small stack buffer
+enum { BIN2D_TILE = 512 };
+
+// count the elements that are not ghosts
+inline
+size_t CountKept(const unsigned char *ghost, size_t n, unsigned char ghostMask)
+{
+  size_t nKept = 0;
+  for (size_t i = 0; i < n; ++i)
+    nKept += (ghost[i] & ghostMask) == 0;
+  return nKept;
+}
+
+// the per-lane histograms, each has nBins + 2 entries. entry nBins holds
+// the values that are equal to the max, entry nBins + 1 collects ghost
+// elements and is discarded
+struct LaneBins
+{
+  LaneBins(int nLanes, int nBins) : NLanes(nLanes),
+    Stride(nBins + 2), Bins(nLanes*(nBins + 2), 0) {}
+
+  unsigned int *GetLane(int i) { return this->Bins.data() + i*this->Stride; }
+
+  // merge the lanes into the output folding the value == max bin
+  // into the last bin
+  template <typename H>
+  void Merge(int nBins, H *hist)
+    {
+    unsigned int *lane0 = this->GetLane(0);
+    for (int j = 1; j < this->NLanes; ++j)
+      {
+      const unsigned int *lane = this->GetLane(j);
+      for (int i = 0; i <= nBins; ++i)
+        lane0[i] += lane[i];
+      }
+    for (int i = 0; i < nBins; ++i)
+      hist[i] += lane0[i];
+    hist[nBins-1] += lane0[nBins];
+    }
+
+  int NLanes;
+  int Stride;
+  std::vector<unsigned int> Bins;
+};
+
+// compute scalar bin index, clamped to [0, nBins]. the clamp is done
+// before the conversion since values far outside of the range don't fit
+// in an int. NaNs land in the first bin
+template <typename T, typename calc_t>
+int BinIndex(T x, calc_t min, calc_t scale, int nBins)
+{
+  calc_t t = (static_cast<calc_t>(x) - min)*scale;
+  t = t > calc_t(0) ? t : calc_t(0);
+  t = t < calc_t(nBins) ? t : calc_t(nBins);
+  return static_cast<int>(t);
+}
+
+// the type used to compute bin indices. float data is binned in single
+// precision as VTKHistogram has always done, all others in double
+template <typename T> struct CalcType { using Type = double; };
+template <> struct CalcType<float> { using Type = float; };
+
+// bins values using nLanes private histograms. this is the generic
+// fallback and bins the remainder for the vectorized binners. when
+// masked is set ghost elements are sent to the discard bin
+template <typename T>
+struct ScalarBinner
+{
+  using calc_t = typename CalcType<T>::Type;
+
+  ScalarBinner(double min, double max, int nBins, int nLanes = 4) :
+    Min(static_cast<calc_t>(min)),
+    Scale(static_cast<calc_t>(nBins/(max - min))),
+    NBins(nBins), Lanes(nLanes, nBins) {}
+
+  template <bool masked>
+  void Run(const T *data, const unsigned char *ghost,
+    unsigned char ghostMask, size_t n)
+    {
+    const int nLanes = this->Lanes.NLanes;
+    const int discard = this->NBins + 1;
+    size_t i = 0;
+    size_t nVec = (n/nLanes)*nLanes;
+    for (; i < nVec; i += nLanes)
+      {
+      for (int j = 0; j < nLanes; ++j)
+        {
+        int bin = BinIndex(data[i+j], this->Min, this->Scale, this->NBins);
+        if (masked)
+          bin = (ghost[i+j] & ghostMask) ? discard : bin;
+        ++this->Lanes.GetLane(j)[bin];
+        }
+      }
+    unsigned int *lane0 = this->Lanes.GetLane(0);
+    for (; i < n; ++i)
+      {
+      int bin = BinIndex(data[i], this->Min, this->Scale, this->NBins);
+      if (masked)
+        bin = (ghost[i] & ghostMask) ? discard : bin;
+      ++lane0[bin];
+      }
+    }
+
+  template <typename H>
+  void Merge(H *hist) { this->Lanes.Merge(this->NBins, hist); }
+
+  calc_t Min;
+  calc_t Scale;
+  int NBins;
+  LaneBins Lanes;
+};
+
+template <typename T>
+struct Binner : public ScalarBinner<T>
+{
+  Binner(double min, double max, int nBins) :
+    ScalarBinner<T>(min, max, nBins) {}
+};
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+// 32 bit lanes set where the corresponding element is not a ghost
+inline
+__m128i KeepMask4(const unsigned char *ghost, __m128i vghostMask)
+{
+  int g4;
+  memcpy(&g4, ghost, 4);
+  __m128i g = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(g4));
+  return _mm_cmpeq_epi32(_mm_and_si128(g, vghostMask), _mm_setzero_si128());
+}
+
+inline
+__m256i KeepMask8(const unsigned char *ghost, __m256i vghostMask)
+{
+  __m256i g = _mm256_cvtepu8_epi32(
+    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ghost)));
+  return _mm256_cmpeq_epi32(_mm256_and_si256(g, vghostMask),
+    _mm256_setzero_si256());
+}
+#endif
+
+#if defined(__AVX512F__)
+template <>
+struct Binner<float> : public ScalarBinner<float>
+{
+  Binner(double min, double max, int nBins) :
+    ScalarBinner<float>(min, max, nBins, 16) {}
+
+  template <bool masked>
+  void Run(const float *data, const unsigned char *ghost,
+    unsigned char ghostMask, size_t n)
+    {
+    const __m512 vmin = _mm512_set1_ps(this->Min);
+    const __m512 vscale = _mm512_set1_ps(this->Scale);
+    const __m512 vzero = _mm512_setzero_ps();
+    const __m512 vtop = _mm512_set1_ps(this->NBins);
+    const __m512i vdiscard = _mm512_set1_epi32(this->NBins + 1);
+    const __m512i vghostMask = _mm512_set1_epi32(ghostMask);
+    // lane j writes to bins offset by j*stride
+    const __m512i voffs = _mm512_mullo_epi32(_mm512_set1_epi32(this->Lanes.Stride),
+      _mm512_set_epi32(15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0));
+    alignas(64) int idx[16];
+    unsigned int *bins = this->Lanes.GetLane(0);
+    size_t nVec = (n/16)*16;
+    for (size_t i = 0; i < nVec; i += 16)
+      {
+      __m512 x = _mm512_loadu_ps(data + i);
+      // clamp before converting, max returns its second operand for NaNs
+      __m512 t = _mm512_mul_ps(_mm512_sub_ps(x, vmin), vscale);
+      t = _mm512_min_ps(_mm512_max_ps(t, vzero), vtop);
+      __m512i b = _mm512_cvttps_epi32(t);
+      if (masked)
+        {
+        __m512i g = _mm512_cvtepu8_epi32(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(ghost + i)));
+        b = _mm512_mask_blend_epi32(_mm512_testn_epi32_mask(g, vghostMask), vdiscard, b);
+        }
+      _mm512_store_si512(idx, _mm512_add_epi32(b, voffs));
+      for (int j = 0; j < 16; ++j)
+        ++bins[idx[j]];
+      }
+    this->ScalarBinner<float>::Run<masked>(data + nVec,
+      masked ? ghost + nVec : nullptr, ghostMask, n - nVec);
+    }
+};
+
+template <typename T>
+struct BinnerPd : public ScalarBinner<T>
+{
+  BinnerPd(double min, double max, int nBins) :
+    ScalarBinner<T>(min, max, nBins, 8) {}
+
+  static __m512d Load(const double *data)
+    { return _mm512_loadu_pd(data); }
+
+  static __m512d Load(const int *data)
+    {
+    return _mm512_cvtepi32_pd(_mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(data)));
+    }
+
+  template <bool masked>
+  void Run(const T *data, const unsigned char *ghost,
+    unsigned char ghostMask, size_t n)
+    {
+    const __m512d vmin = _mm512_set1_pd(this->Min);
+    const __m512d vscale = _mm512_set1_pd(this->Scale);
+    const __m512d vzero = _mm512_setzero_pd();
+    const __m512d vtop = _mm512_set1_pd(this->NBins);
+    const __m256i vdiscard = _mm256_set1_epi32(this->NBins + 1);
+    const __m256i vghostMask = _mm256_set1_epi32(ghostMask);
+    const __m256i voffs = _mm256_mullo_epi32(_mm256_set1_epi32(this->Lanes.Stride),
+      _mm256_set_epi32(7,6,5,4,3,2,1,0));
+    alignas(32) int idx[8];
+    unsigned int *bins = this->Lanes.GetLane(0);
+    size_t nVec = (n/8)*8;
+    for (size_t i = 0; i < nVec; i += 8)
+      {
+      __m512d x = Load(data + i);
+      __m512d t = _mm512_mul_pd(_mm512_sub_pd(x, vmin), vscale);
+      t = _mm512_min_pd(_mm512_max_pd(t, vzero), vtop);
+      __m256i b = _mm512_cvttpd_epi32(t);
+      if (masked)
+        b = _mm256_blendv_epi8(vdiscard, b, KeepMask8(ghost + i, vghostMask));
+      _mm256_store_si256(reinterpret_cast<__m256i*>(idx), _mm256_add_epi32(b, voffs));
+      for (int j = 0; j < 8; ++j)
+        ++bins[idx[j]];
+      }
+    this->ScalarBinner<T>::template Run<masked>(data + nVec,
+      masked ? ghost + nVec : nullptr, ghostMask, n - nVec);
+    }
+};
+#elif defined(__AVX2__)
+template <>
+struct Binner<float> : public ScalarBinner<float>
+{
+  Binner(double min, double max, int nBins) :
+    ScalarBinner<float>(min, max, nBins, 8) {}
+
+  template <bool masked>
+  void Run(const float *data, const unsigned char *ghost,
+    unsigned char ghostMask, size_t n)
+    {
+    const __m256 vmin = _mm256_set1_ps(this->Min);
+    const __m256 vscale = _mm256_set1_ps(this->Scale);
+    const __m256 vzero = _mm256_setzero_ps();
+    const __m256 vtop = _mm256_set1_ps(this->NBins);
+    const __m256i vdiscard = _mm256_set1_epi32(this->NBins + 1);
+    const __m256i vghostMask = _mm256_set1_epi32(ghostMask);
+    // lane j writes to bins offset by j*stride
+    const __m256i voffs = _mm256_mullo_epi32(_mm256_set1_epi32(this->Lanes.Stride),
+      _mm256_set_epi32(7,6,5,4,3,2,1,0));
+    alignas(32) int idx[8];
+    unsigned int *bins = this->Lanes.GetLane(0);
+    size_t nVec = (n/8)*8;
+    for (size_t i = 0; i < nVec; i += 8)
+      {
+      __m256 x = _mm256_loadu_ps(data + i);
+      // clamp before converting, max returns its second operand for NaNs
+      __m256 t = _mm256_mul_ps(_mm256_sub_ps(x, vmin), vscale);
+      t = _mm256_min_ps(_mm256_max_ps(t, vzero), vtop);
+      __m256i b = _mm256_cvttps_epi32(t);
+      if (masked)
+        b = _mm256_blendv_epi8(vdiscard, b, KeepMask8(ghost + i, vghostMask));
+      _mm256_store_si256(reinterpret_cast<__m256i*>(idx), _mm256_add_epi32(b, voffs));
+      for (int j = 0; j < 8; ++j)
+        ++bins[idx[j]];
+      }
+    this->ScalarBinner<float>::Run<masked>(data + nVec,
+      masked ? ghost + nVec : nullptr, ghostMask, n - nVec);
+    }
+};
+
+template <typename T>
+struct BinnerPd : public ScalarBinner<T>
+{
+  BinnerPd(double min, double max, int nBins) :
+    ScalarBinner<T>(min, max, nBins, 4) {}
+
+  static __m256d Load(const double *data)
+    { return _mm256_loadu_pd(data); }
+
+  static __m256d Load(const int *data)
+    {
+    return _mm256_cvtepi32_pd(_mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(data)));
+    }
+
+  template <bool masked>
+  void Run(const T *data, const unsigned char *ghost,
+    unsigned char ghostMask, size_t n)
+    {
+    const __m256d vmin = _mm256_set1_pd(this->Min);
+    const __m256d vscale = _mm256_set1_pd(this->Scale);
+    const __m256d vzero = _mm256_setzero_pd();
+    const __m256d vtop = _mm256_set1_pd(this->NBins);
+    const __m128i vdiscard = _mm_set1_epi32(this->NBins + 1);
+    const __m128i vghostMask = _mm_set1_epi32(ghostMask);
+    const __m128i voffs = _mm_mullo_epi32(_mm_set1_epi32(this->Lanes.Stride),
+      _mm_set_epi32(3,2,1,0));
+    alignas(16) int idx[4];
+    unsigned int *bins = this->Lanes.GetLane(0);
+    size_t nVec = (n/4)*4;
+    for (size_t i = 0; i < nVec; i += 4)
+      {
+      __m256d x = Load(data + i);
+      __m256d t = _mm256_mul_pd(_mm256_sub_pd(x, vmin), vscale);
+      t = _mm256_min_pd(_mm256_max_pd(t, vzero), vtop);
+      __m128i b = _mm256_cvttpd_epi32(t);
+      if (masked)
+        b = _mm_blendv_epi8(vdiscard, b, KeepMask4(ghost + i, vghostMask));
+      _mm_store_si128(reinterpret_cast<__m128i*>(idx), _mm_add_epi32(b, voffs));
+      for (int j = 0; j < 4; ++j)
+        ++bins[idx[j]];
+      }
+    this->ScalarBinner<T>::template Run<masked>(data + nVec,
+      masked ? ghost + nVec : nullptr, ghostMask, n - nVec);
+    }
+};
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+// double and int are both binned in double precision
+template <>
+struct Binner<double> : public BinnerPd<double>
+{
+  Binner(double min, double max, int nBins) :
+    BinnerPd<double>(min, max, nBins) {}
+};
+
+template <>
+struct Binner<int> : public BinnerPd<int>
+{
+  Binner(double min, double max, int nBins) :
+    BinnerPd<int>(min, max, nBins) {}
+};
+#endif
+
+// range of the elements that are not ghosts, returns how many there
+// are. ghosts are replaced with values that can't change the result
+// rather than branched around
+template <typename T>
+size_t MaskedRange(const T *data, const unsigned char *ghost,
+  unsigned char ghostMask, size_t n, T &lo, T &hi)
+{
+  const T tmax = std::numeric_limits<T>::max();
+  const T tmin = std::numeric_limits<T>::lowest();
+  size_t nKept = 0;
+  for (size_t i = 0; i < n; ++i)
+    {
+    bool keep = (ghost[i] & ghostMask) == 0;
+    T xlo = keep ? data[i] : tmax;
+    T xhi = keep ? data[i] : tmin;
+    lo = xlo < lo ? xlo : lo;
+    hi = xhi > hi ? xhi : hi;
+    nKept += keep;
+    }
+  return nKept;
+}
+}
+
+// --------------------------------------------------------------------------
+template <typename T, typename H>
+void Bin(const T *data, const unsigned char *ghost, size_t n,
+  double min, double max, int nBins, H *hist,
+  unsigned char ghostMask)
+{
+  if (nBins < 1)
+    return;
+
+  if (!(max > min))
+    {
+    // degenerate range, everything lands in the first bin
+    hist[0] += ghost ? detail::CountKept(ghost, n, ghostMask) : n;
+    return;
+    }
+
+  detail::Binner<T> binner(min, max, nBins);
+
+  if (!ghost)
+    {
+    binner.template Run<false>(data, nullptr, ghostMask, n);
+    }
+  else
+    {
+    for (size_t i = 0; i < n; i += detail::GHOST_TILE)
+      {
+      size_t nTile = std::min(n - i, size_t(detail::GHOST_TILE));
+      size_t nKept = detail::CountKept(ghost + i, nTile, ghostMask);
+      if (nKept == nTile)
+        binner.template Run<false>(data + i, nullptr, ghostMask, nTile);
+      else if (nKept)
+        binner.template Run<true>(data + i, ghost + i, ghostMask, nTile);
+      }
+    }
+
+  binner.Merge(hist);
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+void Range(const T *data, const unsigned char *ghost, size_t n,
+  double range[2], unsigned char ghostMask)
+{
+  // reduce in the native type, comparisons written this way skip NaNs
+  T lo = std::numeric_limits<T>::max();
+  T hi = std::numeric_limits<T>::lowest();
+  size_t nKept = 0;
+
+  if (ghost)
+    {
+    for (size_t i = 0; i < n; i += detail::GHOST_TILE)
+      {
+      size_t nTile = std::min(n - i, size_t(detail::GHOST_TILE));
+      nKept += detail::MaskedRange(data + i, ghost + i, ghostMask, nTile, lo, hi);
+      }
+    }
+  else
+    {
+    for (size_t i = 0; i < n; ++i)
+      {
+      lo = data[i] < lo ? data[i] : lo;
+      hi = data[i] > hi ? data[i] : hi;
+      }
+    nKept = n;
+    }
+
+  if (nKept)
+    {
+    range[0] = std::min(range[0], static_cast<double>(lo));
+    range[1] = std::max(range[1], static_cast<double>(hi));
+    }
+}
+
+// --------------------------------------------------------------------------
+template <typename T1, typename T2, typename H>
+void Bin2D(const T1 *x, const T2 *y, const unsigned char *ghost, size_t n,
+  const double xRange[2], int nx, const double yRange[2], int ny,
+  H *hist, unsigned char ghostMask)
+{
+  if ((nx < 1) || (ny < 1))
+    return;
+
+  using xcalc_t = typename detail::CalcType<T1>::Type;
+  using ycalc_t = typename detail::CalcType<T2>::Type;
+
+  // a degenerate range has a scale of 0, its values land in the first bin
+  xcalc_t xMin = static_cast<xcalc_t>(xRange[0]);
+  xcalc_t xScale = static_cast<xcalc_t>(xRange[1] > xRange[0] ?
+    nx/(xRange[1] - xRange[0]) : 0.0);
+
+  ycalc_t yMin = static_cast<ycalc_t>(yRange[0]);
+  ycalc_t yScale = static_cast<ycalc_t>(yRange[1] > yRange[0] ?
+    ny/(yRange[1] - yRange[0]) : 0.0);
+
+  // the extra bin collects the ghosts
+  const int nxy = nx*ny;
+  std::vector<uint64_t> bins(nxy + 1, 0);
+  int idx[detail::BIN2D_TILE];
+
+  for (size_t i = 0; i < n; i += detail::BIN2D_TILE)
+    {
+    int nTile = std::min(n - i, size_t(detail::BIN2D_TILE));
+    const T1 *xt = x + i;
+    const T2 *yt = y + i;
+
+    // the x and y indices are computed in separate passes over the
+    // tile, each simple enough to vectorize. values equal to the max
+    // land in the last bin
+    for (int j = 0; j < nTile; ++j)
+      idx[j] = std::min(detail::BinIndex(xt[j], xMin, xScale, nx), nx - 1);
+
+    for (int j = 0; j < nTile; ++j)
+      idx[j] += nx*std::min(detail::BinIndex(yt[j], yMin, yScale, ny), ny - 1);
+
+    if (ghost)
+      {
+      const unsigned char *gt = ghost + i;
+      for (int j = 0; j < nTile; ++j)
+        idx[j] = (gt[j] & ghostMask) ? nxy : idx[j];
+      }
+
+    for (int j = 0; j < nTile; ++j)
+      ++bins[idx[j]];
+    }
+
+  for (int i = 0; i < nxy; ++i)
+    hist[i] += bins[i];
+}
+
+// --------------------------------------------------------------------------
+inline
+StreamingBins::StreamingBins(int nFine) : Min(DBL_MAX), Max(-DBL_MAX),
+  Lo(0.0), Width(0.0), Integral(true), Counts(nFine + (nFine % 2), 0)
+{
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+void StreamingBins::Add(const T *data, const unsigned char *ghost, size_t n,
+  unsigned char ghostMask)
+{
+  const int nFine = this->Counts.size();
+  this->Integral = this->Integral && std::is_integral<T>::value;
+  for (size_t i = 0; i < n; i += CHUNK_SIZE)
+    {
+    size_t nChunk = std::min(n - i, size_t(CHUNK_SIZE));
+    const T *chunk = data + i;
+    const unsigned char *chunkGhost = ghost ? ghost + i : nullptr;
+
+    double range[2] = {DBL_MAX, -DBL_MAX};
+    Range(chunk, chunkGhost, nChunk, range, ghostMask);
+    if (range[0] > range[1])
+      continue;
+
+    this->Grow(range[0], range[1]);
+    this->Min = std::min(this->Min, range[0]);
+    this->Max = std::max(this->Max, range[1]);
+
+    // the chunk is in cache, bin it on the fine grid. there are many
+    // more fine bins than values in a chunk so they are incremented in
+    // place rather than through private per-lane copies. values equal
+    // to the top of the grid land in the last bin and ghosts add 0
+    const double lo = this->Lo;
+    const double scale = 1.0/this->Width;
+    uint64_t *counts = this->Counts.data();
+    if (chunkGhost)
+      {
+      for (size_t j = 0; j < nChunk; ++j)
+        {
+        int bin = std::min(detail::BinIndex(chunk[j], lo, scale, nFine), nFine - 1);
+        counts[bin] += (chunkGhost[j] & ghostMask) == 0;
+        }
+      }
+    else
+      {
+      for (size_t j = 0; j < nChunk; ++j)
+        ++counts[std::min(detail::BinIndex(chunk[j], lo, scale, nFine), nFine - 1)];
+      }
+    }
+}
+
+// --------------------------------------------------------------------------
+inline
+void StreamingBins::Grow(double lo, double hi)
+{
+  const int nFine = this->Counts.size();
+  const int half = nFine/2;
+
+  if ((this->Width <= 0.0) && this->Integral)
+    {
+    // first values seen, they are integers. center the bins on them,
+    // the width is doubled below until the values fit, keeping the
+    // edges half way between integers
+    this->Lo = lo - 0.5;
+    this->Width = 1.0;
+    }
+  else if (this->Width <= 0.0)
+    {
+    // first values seen. when they are all the same pick a width
+    // relative to their magnitude
+    this->Lo = lo;
+    this->Width = (hi - lo)/nFine;
+    if (!(this->Width > 0.0))
+      this->Width = std::max(std::fabs(lo), 1.0)*DBL_EPSILON;
+    }
+
+  while ((lo < this->Lo) || (hi > this->Lo + nFine*this->Width))
+    {
+    // when the values seen so far and the new ones fit, the grid is
+    // shifted by whole bins, keeping its width
+    double shift = lo < this->Lo ? -std::ceil((this->Lo - lo)/this->Width) :
+      std::floor((hi - this->Lo)/this->Width) - nFine + 1;
+    double newLo = this->Lo + shift*this->Width;
+    if ((std::fabs(shift) < nFine) && (newLo <= std::min(lo, this->Min)) &&
+      (std::max(hi, this->Max) < newLo + nFine*this->Width))
+      {
+      int k = static_cast<int>(std::fabs(shift));
+      if (shift < 0.0)
+        {
+        std::copy_backward(this->Counts.begin(), this->Counts.end() - k,
+          this->Counts.end());
+        std::fill(this->Counts.begin(), this->Counts.begin() + k, 0);
+        }
+      else
+        {
+        std::copy(this->Counts.begin() + k, this->Counts.end(),
+          this->Counts.begin());
+        std::fill(this->Counts.end() - k, this->Counts.end(), 0);
+        }
+      this->Lo = newLo;
+      return;
+      }
+
+    if (lo < this->Lo)
+      {
+      // extend down, the current bins merge into the upper half. go
+      // from the top so that bins are read before they are overwritten
+      for (int j = half - 1; j >= 0; --j)
+        this->Counts[half + j] = this->Counts[2*j] + this->Counts[2*j + 1];
+      std::fill(this->Counts.begin(), this->Counts.begin() + half, 0);
+      this->Lo -= nFine*this->Width;
+      }
+    else
+      {
+      // extend up, the current bins merge into the lower half
+      for (int j = 0; j < half; ++j)
+        this->Counts[j] = this->Counts[2*j] + this->Counts[2*j + 1];
+      std::fill(this->Counts.begin() + half, this->Counts.end(), 0);
+      }
+    this->Width *= 2.0;
+    }
+}
+
+// --------------------------------------------------------------------------
+template <typename H>
+void StreamingBins::Rebin(double min, double max, int nBins,
+  H *hist) const
+{
+  const int nFine = this->Counts.size();
+
+  uint64_t total = 0;
+  for (int j = 0; j < nFine; ++j)
+    total += this->Counts[j];
+
+  if (!(max > min))
+    {
+    hist[0] += total;
+    return;
+    }
+
+  // integers are spread over the interval of half a unit about them
+  double dataMin = this->Integral ? this->Min - 0.5 : this->Min;
+  double dataMax = this->Integral ? this->Max + 0.5 : this->Max;
+
+  // walk the final bin edges evaluating the cumulative count of the fine
+  // bins at each. the fine bin the edge falls in is interpolated over the
+  // part of it that is inside the range of the data. rounding the
+  // cumulative counts keeps the total exact.
+  double width = (max - min)/nBins;
+  double scale = nBins/(max - min);
+  double below = 0.0;
+  uint64_t prev = 0;
+  int j = 0;
+  for (int i = 1; i < nBins; ++i)
+    {
+    double edge = min + i*width;
+
+    if (this->Integral)
+      {
+      // the edge is moved half way between the last integer the final
+      // binning places below it and the first it places above it. the
+      // test is the one Bin makes so that the two agree
+      double first = std::ceil(edge);
+      while ((first - 1.0 - min)*scale >= i)
+        first -= 1.0;
+      while ((first - min)*scale < i)
+        first += 1.0;
+      edge = first - 0.5;
+      }
+
+    while ((j < nFine) && (this->Lo + (j + 1)*this->Width <= edge))
+      below += this->Counts[j++];
+
+    double cum = below;
+    if ((j < nFine) && this->Counts[j])
+      {
+      double lo = std::max(this->Lo + j*this->Width, dataMin);
+      double hi = std::min(this->Lo + (j + 1)*this->Width, dataMax);
+      double frac = hi > lo ? (edge - lo)/(hi - lo) : (edge > lo ? 1.0 : 0.0);
+      cum += this->Counts[j]*std::min(std::max(frac, 0.0), 1.0);
+      }
+
+    uint64_t cur = std::max(prev,
+      std::min(total, static_cast<uint64_t>(cum + 0.5)));
+    hist[i - 1] += cur - prev;
+    prev = cur;
+    }
+  hist[nBins - 1] += total - prev;
+}
+
+}
+}
+
+#endif
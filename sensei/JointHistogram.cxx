@@ -0,0 +1,376 @@
+#include "senseiConfig.h"
+#include "JointHistogram.h"
+#include "DataAdaptor.h"
+#include "Histogram.h"
+#include "HistogramKernels.h"
+#include "Timer.h"
+#include "Error.h"
+
+#include <vtkCompositeDataIterator.h>
+#include <vtkCompositeDataSet.h>
+#include <vtkDataArray.h>
+#include <vtkDataObject.h>
+#include <vtkFieldData.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+#include <vtkAOSDataArrayTemplate.h>
+#include <vtkArrayDispatch.h>
+#else
+#include <vtkDataArrayDispatcher.h>
+#include <vtkDataArrayTemplate.h>
+#endif
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace sensei
+{
+
+namespace
+{
+// Private worker that hands a pointer to an array's values to an
+// operation, op(const T *values). Contiguous arrays are used in
+// place, others are copied.
+template <typename OpT>
+struct ValuesWorker
+{
+  OpT &Op;
+
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+  template <typename T>
+  void operator()(vtkAOSDataArrayTemplate<T> *array)
+  {
+    this->Op(array->GetPointer(0));
+  }
+
+  template <typename ArrayT>
+  void operator()(ArrayT *array)
+  {
+    vtkIdType numTuples = array->GetNumberOfTuples();
+    std::vector<double> tmp(numTuples);
+    for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
+      tmp[tIdx] = array->GetComponent(tIdx, 0);
+    this->Op(tmp.data());
+  }
+#else
+  template <typename T>
+  void operator()(const vtkDataArrayDispatcherPointer<T>& array)
+  {
+    this->Op(array.RawPointer);
+  }
+#endif
+};
+
+// --------------------------------------------------------------------------
+template <typename OpT>
+void VisitValues(vtkDataArray *array, OpT &op)
+{
+  ValuesWorker<OpT> worker{op};
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+  if (!vtkArrayDispatch::Dispatch::Execute(array, worker))
+    worker(array);
+#else
+  vtkDataArrayDispatcher<ValuesWorker<OpT>> dispatcher(worker);
+  dispatcher.Go(array);
+#endif
+}
+
+// updates the range of an array skipping ghosts
+struct RangeOp
+{
+  const unsigned char *Ghost;
+  size_t N;
+  double *Range;
+
+  template <typename T>
+  void operator()(const T *values)
+  {
+    HistogramKernels::Range(values, this->Ghost, this->N, this->Range);
+  }
+};
+
+// the parameters of the 2D binning
+struct JointBins
+{
+  const unsigned char *Ghost;
+  size_t N;
+  const double *XRange;
+  int XBins;
+  const double *YRange;
+  int YBins;
+  uint64_t *Hist;
+};
+
+// bins the pairs once the types of both arrays are known
+template <typename T1>
+struct YBinOp
+{
+  const T1 *X;
+  JointBins &Bins;
+
+  template <typename T2>
+  void operator()(const T2 *y)
+  {
+    HistogramKernels::Bin2D(this->X, y, this->Bins.Ghost, this->Bins.N,
+      this->Bins.XRange, this->Bins.XBins, this->Bins.YRange,
+      this->Bins.YBins, this->Bins.Hist);
+  }
+};
+
+// dispatches the y array once the type of the x array is known
+struct XBinOp
+{
+  vtkDataArray *Y;
+  JointBins &Bins;
+
+  template <typename T1>
+  void operator()(const T1 *x)
+  {
+    YBinOp<T1> op{x, this->Bins};
+    VisitValues(this->Y, op);
+  }
+};
+
+// a local block's arrays
+struct JointBlock
+{
+  vtkDataArray *X;
+  vtkDataArray *Y;
+  vtkUnsignedCharArray *Ghost;
+};
+}
+
+//-----------------------------------------------------------------------------
+senseiNewMacro(JointHistogram);
+
+//-----------------------------------------------------------------------------
+JointHistogram::JointHistogram() :
+  Association(vtkDataObject::FIELD_ASSOCIATION_POINTS), XBins(0), YBins(0)
+{
+  this->XRange[0] = this->YRange[0] = VTK_DOUBLE_MAX;
+  this->XRange[1] = this->YRange[1] = VTK_DOUBLE_MIN;
+}
+
+//-----------------------------------------------------------------------------
+JointHistogram::~JointHistogram()
+{
+}
+
+//-----------------------------------------------------------------------------
+void JointHistogram::Initialize(const std::string &meshName,
+  int association, const std::string &xArrayName, int xBins,
+  const std::string &yArrayName, int yBins)
+{
+  this->MeshName = meshName;
+  this->Association = association;
+  this->XArrayName = xArrayName;
+  this->XBins = xBins;
+  this->YArrayName = yArrayName;
+  this->YBins = yBins;
+}
+
+//-----------------------------------------------------------------------------
+vtkDataArray* JointHistogram::GetArray(vtkDataObject* dobj,
+  const std::string& arrayname)
+{
+  if (vtkFieldData* fd = dobj->GetAttributesAsFieldData(this->Association))
+    {
+    return fd->GetArray(arrayname.c_str());
+    }
+  return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+bool JointHistogram::Execute(DataAdaptor* data)
+{
+  timer::MarkEvent mark("JointHistogram::Execute");
+
+  // gather the arrays of the local blocks. all ranks take part in the
+  // reductions even when they have no data or there was an error
+  bool ok = true;
+  std::vector<JointBlock> blocks;
+
+  vtkDataObject* mesh = nullptr;
+  if (data->GetMesh(this->MeshName, true, mesh))
+    {
+    SENSEI_ERROR("GetMesh failed")
+    ok = false;
+    }
+
+  if (mesh)
+    {
+    if (data->AddArray(mesh, this->MeshName, this->Association, this->XArrayName) ||
+      data->AddArray(mesh, this->MeshName, this->Association, this->YArrayName))
+      {
+      SENSEI_ERROR(<< data->GetClassName() << " failed to add "
+        << (this->Association == vtkDataObject::POINT ? "point" : "cell")
+        << " data arrays \""  << this->XArrayName << "\" and \""
+        << this->YArrayName << "\"")
+      ok = false;
+      }
+
+    int nLayers = 0;
+    if (data->GetMeshHasGhostCells(this->MeshName, nLayers) ||
+      ((nLayers > 0) && data->AddGhostCellsArray(mesh, this->MeshName)))
+      {
+      SENSEI_ERROR(<< data->GetClassName() << " failed to add ghost cells.")
+      ok = false;
+      }
+
+    std::vector<vtkDataObject*> dobjs;
+    if (vtkCompositeDataSet* cd = dynamic_cast<vtkCompositeDataSet*>(mesh))
+      {
+      vtkSmartPointer<vtkCompositeDataIterator> iter;
+      iter.TakeReference(cd->NewIterator());
+      for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
+        dobjs.push_back(iter->GetCurrentDataObject());
+      }
+    else
+      {
+      dobjs.push_back(mesh);
+      }
+
+    for (size_t i = 0; i < dobjs.size(); ++i)
+      {
+      vtkDataArray *x = this->GetArray(dobjs[i], this->XArrayName);
+      vtkDataArray *y = this->GetArray(dobjs[i], this->YArrayName);
+      if (!x || !y || (x->GetNumberOfTuples() != y->GetNumberOfTuples()))
+        {
+        SENSEI_WARNING("Dataset " << i << " has no co-located arrays named \""
+          << this->XArrayName << "\" and \"" << this->YArrayName << "\"")
+        continue;
+        }
+
+      vtkUnsignedCharArray *ghost = dynamic_cast<vtkUnsignedCharArray*>(
+        this->GetArray(dobjs[i], Histogram::GetGhostArrayName()));
+
+      blocks.push_back({x, y, ghost});
+      }
+    }
+
+  // compute the local ranges
+  double ranges[4] = {VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+    VTK_DOUBLE_MAX, VTK_DOUBLE_MIN};
+
+  size_t nBlocks = blocks.size();
+  for (size_t i = 0; i < nBlocks; ++i)
+    {
+    const unsigned char *ghost = blocks[i].Ghost ?
+      blocks[i].Ghost->GetPointer(0) : nullptr;
+    size_t n = blocks[i].X->GetNumberOfTuples();
+
+    RangeOp xop{ghost, n, ranges};
+    VisitValues(blocks[i].X, xop);
+
+    RangeOp yop{ghost, n, ranges + 2};
+    VisitValues(blocks[i].Y, yop);
+    }
+
+  // compute the global ranges. the maxima are negated so that a
+  // single MPI_MIN finds all four values
+  ranges[1] = -ranges[1];
+  ranges[3] = -ranges[3];
+
+  MPI_Allreduce(MPI_IN_PLACE, ranges, 4, MPI_DOUBLE, MPI_MIN,
+    this->GetCommunicator());
+
+  this->XRange[0] = ranges[0];
+  this->XRange[1] = -ranges[1];
+  this->YRange[0] = ranges[2];
+  this->YRange[1] = -ranges[3];
+
+  // compute the local histogram
+  std::vector<uint64_t> bins(this->XBins*this->YBins, 0);
+  for (size_t i = 0; i < nBlocks; ++i)
+    {
+    JointBins jb{blocks[i].Ghost ? blocks[i].Ghost->GetPointer(0) : nullptr,
+      static_cast<size_t>(blocks[i].X->GetNumberOfTuples()), this->XRange,
+      this->XBins, this->YRange, this->YBins, bins.data()};
+
+    XBinOp op{blocks[i].Y, jb};
+    VisitValues(blocks[i].X, op);
+    }
+
+  // compute the global histogram
+  int rank = 0;
+  MPI_Comm_rank(this->GetCommunicator(), &rank);
+
+  this->Bins.assign(bins.size(), 0);
+
+  MPI_Reduce(bins.data(), this->Bins.data(), bins.size(), MPI_UINT64_T,
+    MPI_SUM, 0, this->GetCommunicator());
+
+  if (rank == 0)
+    {
+    // if there was an error range is initialized to [DOUBLE_MAX, DOUBLE_MIN]
+    if ((this->XRange[0] > this->XRange[1]) || (this->YRange[0] > this->YRange[1]))
+      {
+      SENSEI_ERROR("Invalid joint histogram range ["
+        << this->XRange[0] << " - " << this->XRange[1] << "] x ["
+        << this->YRange[0] << " - " << this->YRange[1] << "]")
+      return false;
+      }
+
+    // print the ranges and counts, one row per y bin
+    int origPrec = cout.precision();
+    cout.precision(4);
+
+    const int wid = 15;
+    std::cout << "Joint histogram '" << this->XArrayName << "' x '"
+      << this->YArrayName << "' (VTK):\n" << std::scientific
+      << this->XArrayName << ": " << this->XRange[0] << " - "
+      << this->XRange[1] << " " << this->XBins << " bins\n"
+      << this->YArrayName << ": " << this->YRange[0] << " - "
+      << this->YRange[1] << " " << this->YBins << " bins\n";
+
+    double width = (this->YRange[1] - this->YRange[0]) / this->YBins;
+    for (int j = 0; j < this->YBins; ++j)
+      {
+      cout << std::scientific << std::setw(wid) << std::right
+        << this->YRange[0] + j*width << " - " << std::setw(wid) << std::left
+        << this->YRange[0] + (j+1)*width << ":" << std::right;
+      const uint64_t *row = this->Bins.data() + j*this->XBins;
+      for (int i = 0; i < this->XBins; ++i)
+        cout << " " << row[i];
+      cout << endl;
+      }
+
+    cout.precision(origPrec);
+    }
+
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+int JointHistogram::GetHistogram(double xRange[2], double yRange[2],
+  std::vector<uint64_t> &bins)
+{
+  if (this->Bins.empty())
+    return -1;
+
+  int rank = 0;
+  MPI_Comm_rank(this->GetCommunicator(), &rank);
+
+  if (rank == 0)
+    {
+    xRange[0] = this->XRange[0];
+    xRange[1] = this->XRange[1];
+    yRange[0] = this->YRange[0];
+    yRange[1] = this->YRange[1];
+    bins = this->Bins;
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int JointHistogram::Finalize()
+{
+  this->Bins.clear();
+  return 0;
+}
+
+}
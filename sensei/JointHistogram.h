@@ -0,0 +1,66 @@
+#ifndef sensei_JointHistogram_h
+#define sensei_JointHistogram_h
+
+#include "AnalysisAdaptor.h"
+#include <mpi.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class vtkDataObject;
+class vtkDataArray;
+
+namespace sensei
+{
+
+/// @class JointHistogram
+/// @brief Computes a parallel 2D histogram of two co-located arrays
+///
+/// The joint distribution of a pair of arrays with the same association
+/// on the same mesh is binned onto an nx by ny grid spanning the global
+/// ranges of the arrays. The ranges are found with a single
+/// MPI_Allreduce and the bins are summed on rank 0 with a single
+/// MPI_Reduce. Ghost cells are skipped.
+class JointHistogram : public AnalysisAdaptor
+{
+public:
+  static JointHistogram* New();
+  senseiTypeMacro(JointHistogram, AnalysisAdaptor);
+
+  void Initialize(const std::string &meshName, int association,
+    const std::string &xArrayName, int xBins,
+    const std::string &yArrayName, int yBins);
+
+  bool Execute(DataAdaptor* data) override;
+
+  int Finalize() override;
+
+  // return the last computed histogram. the bins are ordered with x
+  // varying fastest. valid on rank 0.
+  int GetHistogram(double xRange[2], double yRange[2],
+    std::vector<uint64_t> &bins);
+
+protected:
+  JointHistogram();
+  ~JointHistogram();
+
+  JointHistogram(const JointHistogram&) = delete;
+  void operator=(const JointHistogram&) = delete;
+
+  vtkDataArray* GetArray(vtkDataObject* dobj, const std::string& arrayname);
+
+  std::string MeshName;
+  int Association;
+  std::string XArrayName;
+  int XBins;
+  std::string YArrayName;
+  int YBins;
+
+  double XRange[2];
+  double YRange[2];
+  std::vector<uint64_t> Bins;
+};
+
+}
+
+#endif
@@ -0,0 +1,254 @@
+#include "MultiHistogram.h"
+#include "DataAdaptor.h"
+#include "Histogram.h"
+#include "Timer.h"
+#include "VTKHistogram.h"
+#include "Error.h"
+
+#include <vtkCompositeDataIterator.h>
+#include <vtkCompositeDataSet.h>
+#include <vtkDataObject.h>
+#include <vtkFieldData.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace sensei
+{
+
+//-----------------------------------------------------------------------------
+senseiNewMacro(MultiHistogram);
+
+//-----------------------------------------------------------------------------
+MultiHistogram::MultiHistogram() : SinglePass(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+MultiHistogram::~MultiHistogram()
+{
+  this->Finalize();
+}
+
+//-----------------------------------------------------------------------------
+void MultiHistogram::Initialize(const std::string &meshName)
+{
+  this->MeshName = meshName;
+}
+
+//-----------------------------------------------------------------------------
+int MultiHistogram::AddArray(int association, const std::string &arrayName,
+  int bins)
+{
+  this->Arrays.push_back({arrayName, association, bins});
+  return this->Arrays.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+vtkDataArray *MultiHistogram::GetArray(vtkDataObject *dobj, int association,
+  const std::string &arrayName)
+{
+  if (vtkFieldData* fd = dobj->GetAttributesAsFieldData(association))
+    {
+    return fd->GetArray(arrayName.c_str());
+    }
+  return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+bool MultiHistogram::Execute(DataAdaptor* data)
+{
+  timer::MarkEvent mark("MultiHistogram::Execute");
+
+  this->Finalize();
+
+  size_t nArrays = this->Arrays.size();
+  for (size_t i = 0; i < nArrays; ++i)
+    this->Internals.push_back(new VTKHistogram);
+
+  // fetch the mesh and all of the arrays once
+  vtkDataObject* mesh = nullptr;
+  if (data->GetMesh(this->MeshName, true, mesh))
+    {
+    SENSEI_ERROR("GetMesh failed")
+    }
+
+  bool ok = true;
+  std::vector<vtkDataObject*> blocks;
+  if (mesh)
+    {
+    for (size_t i = 0; i < nArrays; ++i)
+      {
+      const ArrayInfo &ai = this->Arrays[i];
+      if (data->AddArray(mesh, this->MeshName, ai.Association, ai.Name))
+        {
+        SENSEI_ERROR(<< data->GetClassName() << " failed to add "
+          << (ai.Association == vtkDataObject::POINT ? "point" : "cell")
+          << " data array \""  << ai.Name << "\"")
+        ok = false;
+        }
+      }
+
+    int nLayers = 0;
+    if (data->GetMeshHasGhostCells(this->MeshName, nLayers) ||
+      ((nLayers > 0) && data->AddGhostCellsArray(mesh, this->MeshName)))
+      {
+      SENSEI_ERROR(<< data->GetClassName() << " failed to add ghost cells.")
+      ok = false;
+      }
+
+    if (vtkCompositeDataSet* cd = dynamic_cast<vtkCompositeDataSet*>(mesh))
+      {
+      vtkSmartPointer<vtkCompositeDataIterator> iter;
+      iter.TakeReference(cd->NewIterator());
+      for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
+        blocks.push_back(iter->GetCurrentDataObject());
+      }
+    else
+      {
+      blocks.push_back(mesh);
+      }
+    }
+
+  // compute the local ranges. each block is visited once and all of
+  // its arrays are processed while its ghost array is in cache. all
+  // ranks take part in the reductions even if they have no data
+  const char *ghostName = Histogram::GetGhostArrayName();
+  size_t nBlocks = blocks.size();
+  for (size_t j = 0; j < nBlocks; ++j)
+    {
+    for (size_t i = 0; i < nArrays; ++i)
+      {
+      const ArrayInfo &ai = this->Arrays[i];
+      vtkDataArray *array = this->GetArray(blocks[j], ai.Association, ai.Name);
+      if (!array)
+        continue;
+
+      vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
+        this->GetArray(blocks[j], ai.Association, ghostName));
+
+      if (this->SinglePass)
+        this->Internals[i]->AddRangeAndCompute(array, ghostArray, ai.Bins);
+      else
+        this->Internals[i]->AddRange(array, ghostArray);
+      }
+    }
+
+  // compute global histogram ranges
+  this->ReduceRanges();
+
+  // compute local histograms
+  for (size_t j = 0; !this->SinglePass && (j < nBlocks); ++j)
+    {
+    for (size_t i = 0; i < nArrays; ++i)
+      {
+      const ArrayInfo &ai = this->Arrays[i];
+      vtkDataArray *array = this->GetArray(blocks[j], ai.Association, ai.Name);
+      if (!array)
+        continue;
+
+      vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
+        this->GetArray(blocks[j], ai.Association, ghostName));
+
+      this->Internals[i]->Compute(array, ghostArray);
+      }
+    }
+
+  // compute the global histograms
+  this->ReduceBins();
+
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+void MultiHistogram::ReduceRanges()
+{
+  timer::MarkEvent mark("MultiHistogram::ReduceRanges");
+
+  // pack [min, -max] for each array so that a single MPI_MIN
+  // reduction finds both ends of every range
+  size_t nArrays = this->Arrays.size();
+  std::vector<double> ranges(2*nArrays);
+  for (size_t i = 0; i < nArrays; ++i)
+    {
+    double range[2];
+    this->Internals[i]->GetRange(range);
+    ranges[2*i] = range[0];
+    ranges[2*i+1] = -range[1];
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, ranges.data(), 2*nArrays, MPI_DOUBLE,
+    MPI_MIN, this->GetCommunicator());
+
+  for (size_t i = 0; i < nArrays; ++i)
+    {
+    double range[2] = {ranges[2*i], -ranges[2*i+1]};
+    this->Internals[i]->Initialize(range, this->Arrays[i].Bins);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void MultiHistogram::ReduceBins()
+{
+  timer::MarkEvent mark("MultiHistogram::ReduceBins");
+
+  // pack the bins of all arrays into one buffer
+  size_t nArrays = this->Arrays.size();
+  size_t nBins = 0;
+  for (size_t i = 0; i < nArrays; ++i)
+    nBins += this->Arrays[i].Bins;
+
+  std::vector<uint64_t> bins(nBins);
+  uint64_t *pbins = bins.data();
+  for (size_t i = 0; i < nArrays; ++i)
+    {
+    int n = this->Arrays[i].Bins;
+    std::copy(this->Internals[i]->GetBins(),
+      this->Internals[i]->GetBins() + n, pbins);
+    pbins += n;
+    }
+
+  std::vector<uint64_t> gBins(nBins, 0);
+  MPI_Reduce(bins.data(), gBins.data(), nBins, MPI_UINT64_T,
+    MPI_SUM, 0, this->GetCommunicator());
+
+  int rank = 0;
+  MPI_Comm_rank(this->GetCommunicator(), &rank);
+
+  if (rank == 0)
+    {
+    pbins = gBins.data();
+    for (size_t i = 0; i < nArrays; ++i)
+      {
+      int n = this->Arrays[i].Bins;
+      this->Internals[i]->Report(n, pbins, this->Arrays[i].Name);
+      pbins += n;
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+int MultiHistogram::GetHistogram(int i, double &min, double &max,
+  std::vector<uint64_t> &bins)
+{
+  if ((i < 0) || (i >= static_cast<int>(this->Internals.size())))
+    return -1;
+
+  return this->Internals[i]->GetHistogram(this->GetCommunicator(),
+    min, max, bins);
+}
+
+//-----------------------------------------------------------------------------
+int MultiHistogram::Finalize()
+{
+  size_t n = this->Internals.size();
+  for (size_t i = 0; i < n; ++i)
+    delete this->Internals[i];
+  this->Internals.clear();
+  return 0;
+}
+
+}
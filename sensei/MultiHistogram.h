@@ -0,0 +1,89 @@
+#ifndef sensei_MultiHistogram_h
+#define sensei_MultiHistogram_h
+
+#include "AnalysisAdaptor.h"
+#include <mpi.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class vtkDataObject;
+class vtkDataArray;
+
+namespace sensei
+{
+
+class VTKHistogram;
+
+/// @class MultiHistogram
+/// @brief Computes parallel histograms of several arrays on a mesh
+///
+/// MultiHistogram computes the same histograms as a set of Histogram
+/// analyses configured on the same mesh, but the mesh is fetched from
+/// the data adaptor once per time step, and the global ranges and global
+/// bins of all of the arrays are each reduced in a single collective.
+class MultiHistogram : public AnalysisAdaptor
+{
+public:
+  static MultiHistogram* New();
+  senseiTypeMacro(MultiHistogram, AnalysisAdaptor);
+
+  /// @brief Set the name of the mesh the arrays are on
+  void Initialize(const std::string &meshName);
+
+  /// @brief Add an array to compute a histogram of
+  ///
+  /// Returns the index of the array which may be used to
+  /// retrieve the histogram with GetHistogram.
+  int AddArray(int association, const std::string &arrayName, int bins);
+
+  /// @brief Get the number of arrays
+  int GetNumberOfArrays() const { return this->Arrays.size(); }
+
+  /// @brief Enable single pass mode
+  ///
+  /// see Histogram::SetSinglePass. The default is off.
+  void SetSinglePass(bool val) { this->SinglePass = val; }
+
+  bool Execute(DataAdaptor* data) override;
+
+  int Finalize() override;
+
+  // return the last computed histogram of the i-th array
+  int GetHistogram(int i, double &min, double &max,
+    std::vector<uint64_t> &bins);
+
+protected:
+  MultiHistogram();
+  ~MultiHistogram();
+
+  MultiHistogram(const MultiHistogram&) = delete;
+  void operator=(const MultiHistogram&) = delete;
+
+  struct ArrayInfo
+  {
+    std::string Name;
+    int Association;
+    int Bins;
+  };
+
+  // find the global range of all arrays in one collective and
+  // initialize the bins
+  void ReduceRanges();
+
+  // sum the bins of all arrays on rank 0 in one collective
+  void ReduceBins();
+
+  vtkDataArray *GetArray(vtkDataObject *dobj, int association,
+    const std::string &arrayName);
+
+  std::string MeshName;
+  std::vector<ArrayInfo> Arrays;
+  bool SinglePass;
+
+  std::vector<VTKHistogram*> Internals;
+};
+
+}
+
+#endif
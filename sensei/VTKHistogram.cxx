@@ -1,5 +1,6 @@
 #include "senseiConfig.h"
 #include "VTKHistogram.h"
+#include "HistogramKernels.h"
 #include "Timer.h"
 #include "Error.h"
 
@@ -31,18 +32,32 @@ namespace sensei
 // range: Global range of data
 // bins: Number of Histogram bins
 // array: Local data.
+// ghost: Ghost array, elements flagged as ghosts are skipped. may be null.
 //
 // Outputs:
 // Histogram: The Histogram of the local data.
 #ifdef ENABLE_VTK_GENERIC_ARRAYS
 struct VTKHistogram::Internals
 {
+  const unsigned char *Ghost;
   const double *Range;
   int Bins;
-  std::vector<unsigned int> Histogram;
+  std::vector<uint64_t> Histogram;
 
   Internals(const double *range, int bins) :
-    Range(range), Bins(bins), Histogram(bins,0.0) {}
+    Ghost(NULL), Range(range), Bins(bins), Histogram(bins,0) {}
+
+  // contiguous arrays are handed to the vectorized kernels
+  template <typename T>
+  void operator()(vtkAOSDataArrayTemplate<T> *array)
+  {
+    assert(array);
+    assert(array->GetNumberOfComponents() == 1);
+
+    HistogramKernels::Bin(array->GetPointer(0), this->Ghost,
+      array->GetNumberOfTuples(), this->Range[0], this->Range[1],
+      this->Bins, this->Histogram.data());
+  }
 
   template <typename ArrayT>
   void operator()(ArrayT *array)
@@ -50,75 +65,78 @@ struct VTKHistogram::Internals
     assert(array);
     assert(array->GetNumberOfComponents() == 1);
 
-    typedef typename ArrayT::ValueType ValueType;
+    // other layouts are copied to doubles and binned by the same kernel,
+    // which computes the indices in double precision and clamps values
+    // outside of the range into the first and last bins
+    vtkIdType numTuples = array->GetNumberOfTuples();
+    std::vector<double> tmp(numTuples);
+    for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
+      tmp[tIdx] = array->GetComponent(tIdx, 0);
+
+    HistogramKernels::Bin(tmp.data(), this->Ghost, numTuples,
+      this->Range[0], this->Range[1], this->Bins, this->Histogram.data());
+  }
+};
 
-    ValueType width = static_cast<ValueType>((this->Range[1]
-      - this->Range[0]) / this->Bins);
+// Compute array range by skipping ghost elements.
+struct ComponentRangeWorker
+{
+  const unsigned char *Ghost;
+  double Range[2];
 
-    ValueType min = static_cast<ValueType>(this->Range[0]);
-    vtkIdType numTuples = array->GetNumberOfTuples();
+  ComponentRangeWorker(const unsigned char *ghost) : Ghost(ghost)
+    {
+    this->Range[0] = VTK_DOUBLE_MAX;
+    this->Range[1] = VTK_DOUBLE_MIN;
+    }
 
-    // + 1 to store val == max. These will be moved to this last bin before
-    // returning (Avoids having to branch in the loop below);
-    this->Histogram.resize(this->Bins + 1, 0);
-    for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
+  template <typename T>
+  void operator()(vtkAOSDataArrayTemplate<T> *array)
+    {
+    assert(array->GetNumberOfComponents() == 1);
+    HistogramKernels::Range(array->GetPointer(0), this->Ghost,
+      array->GetNumberOfTuples(), this->Range);
+    }
+
+  template <typename ArrayT>
+  void operator()(ArrayT *array)
+    {
+    assert(array->GetNumberOfComponents() == 1);
+    vtkIdType numTuples = array->GetNumberOfTuples();
+    for (vtkIdType cc = 0; cc < numTuples; ++cc)
       {
-      int bin = static_cast<int>((array->GetComponent(tIdx, 0) - min) / width);
-      ++this->Histogram[bin];
+      if (this->Ghost && this->Ghost[cc])
+        continue;
+      double val = array->GetComponent(cc, 0);
+      this->Range[0] = std::min(this->Range[0], val);
+      this->Range[1] = std::max(this->Range[1], val);
       }
+    }
 
-    // Merge the last two bins (the last is only when val == max)
-    this->Histogram[this->Bins-1] += this->Histogram[this->Bins];
-    this->Histogram.resize(this->Bins);
-  }
+  void GetRange(double r[2])
+    {
+    std::copy(this->Range, this->Range+2, r);
+    }
 };
 #else
 struct VTKHistogram::Internals
 {
-  vtkUnsignedCharArray* GhostArray;
+  const unsigned char *Ghost;
   const double *Range;
   int Bins;
-  std::vector<unsigned int> Histogram;
+  std::vector<uint64_t> Histogram;
 
   Internals(const double *range, int bins) :
-    GhostArray(NULL), Range(range), Bins(bins), Histogram(bins,0.0) {}
+    Ghost(NULL), Range(range), Bins(bins), Histogram(bins,0) {}
 
   template <typename T>
   void operator()(const vtkDataArrayDispatcherPointer<T>& array)
   {
     assert(array.NumberOfComponents == 1);
 
-    typedef T ValueType;
-    ValueType width = static_cast<ValueType>((this->Range[1] - this->Range[0]) / this->Bins);
-    ValueType min = static_cast<ValueType>(this->Range[0]);
-    vtkIdType numTuples = array.NumberOfTuples;
-
-    // + 1 to store val == max. These will be moved to this last bin before
-    // returning (Avoids having to branch in the loop below);
-    this->Histogram.resize(this->Bins + 1, 0);
-    if (this->GhostArray)
-      {
-      for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
-        {
-        if (this->GhostArray->GetValue(tIdx) == 0)
-          {
-          int bin = static_cast<int>((array.RawPointer[tIdx] - min) / width);
-          ++this->Histogram[bin];
-          }
-        }
-      }
-    else
-      {
-      for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
-        {
-        int bin = static_cast<int>((array.RawPointer[tIdx] - min) / width);
-        ++this->Histogram[bin];
-        }
-      }
-
-    // Merge the last two bins (the last is only when val == max)
-    this->Histogram[this->Bins-1] += this->Histogram[this->Bins];
-    this->Histogram.resize(this->Bins);
+    HistogramKernels::Bin(array.RawPointer, this->Ghost,
+      array.NumberOfTuples, this->Range[0], this->Range[1],
+      this->Bins, this->Histogram.data());
   }
 };
 
@@ -126,8 +144,7 @@ struct VTKHistogram::Internals
 class ComponentRangeWorker
 {
 public:
-  ComponentRangeWorker(vtkUnsignedCharArray* ghostArray) :
-    GhostArray(ghostArray)
+  ComponentRangeWorker(const unsigned char *ghost) : Ghost(ghost)
     {
     this->Range[0] = vtkTypeTraits<double>::Max();
     this->Range[1] = vtkTypeTraits<double>::Min();
@@ -137,15 +154,8 @@ public:
   void operator()(const vtkDataArrayDispatcherPointer<T>& array)
     {
     assert(array.NumberOfComponents == 1);
-    vtkIdType numTuples = array.NumberOfTuples;
-    for (vtkIdType cc=0; cc < numTuples; cc++)
-      {
-      if (this->GhostArray->GetValue(cc) == 0)
-        {
-        this->Range[0] = std::min(this->Range[0], static_cast<double>(array.RawPointer[cc]));
-        this->Range[1] = std::max(this->Range[1], static_cast<double>(array.RawPointer[cc]));
-        }
-      }
+    HistogramKernels::Range(array.RawPointer, this->Ghost,
+      array.NumberOfTuples, this->Range);
     }
 
   void GetRange(double r[2])
@@ -154,53 +164,130 @@ public:
     }
 private:
   double Range[2];
-  vtkUnsignedCharArray* GhostArray;
+  const unsigned char *Ghost;
 };
 #endif
 
+// Private worker for the single pass mode. Adds the array to the
+// provisional bins, ghost elements are skipped.
+struct StreamingWorker
+{
+  HistogramKernels::StreamingBins *Bins;
+  const unsigned char *Ghost;
+
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+  template <typename T>
+  void operator()(vtkAOSDataArrayTemplate<T> *array)
+  {
+    assert(array->GetNumberOfComponents() == 1);
+    this->Bins->Add(array->GetPointer(0), this->Ghost,
+      array->GetNumberOfTuples());
+  }
+
+  // other layouts are copied in the array's type so that integers are
+  // binned as such, arrays the dispatch doesn't know are copied to double
+  template <typename ArrayT>
+  void operator()(ArrayT *array)
+  {
+    this->AddCopy<typename ArrayT::ValueType>(array);
+  }
+
+  void operator()(vtkDataArray *array)
+  {
+    this->AddCopy<double>(array);
+  }
+
+  template <typename ValueType>
+  void AddCopy(vtkDataArray *array)
+  {
+    assert(array->GetNumberOfComponents() == 1);
+    vtkIdType numTuples = array->GetNumberOfTuples();
+    std::vector<ValueType> tmp(numTuples);
+    for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
+      tmp[tIdx] = static_cast<ValueType>(array->GetComponent(tIdx, 0));
+    this->Bins->Add(tmp.data(), this->Ghost, numTuples);
+  }
+#else
+  template <typename T>
+  void operator()(const vtkDataArrayDispatcherPointer<T>& array)
+  {
+    assert(array.NumberOfComponents == 1);
+    this->Bins->Add(array.RawPointer, this->Ghost, array.NumberOfTuples);
+  }
+#endif
+};
+
 // --------------------------------------------------------------------------
 VTKHistogram::VTKHistogram()
 {
   this->Range[0] = VTK_DOUBLE_MAX;
   this->Range[1] = VTK_DOUBLE_MIN;
   this->Worker = NULL;
+  this->Provisional = NULL;
+  this->RangeRequest = MPI_REQUEST_NULL;
+  this->PendingRank = 0;
+  this->BinsRequest = MPI_REQUEST_NULL;
 }
 
 // --------------------------------------------------------------------------
 VTKHistogram::~VTKHistogram()
 {
+  // the buffers may not be released while communication is in flight
+  MPI_Wait(&this->RangeRequest, MPI_STATUS_IGNORE);
+  MPI_Wait(&this->BinsRequest, MPI_STATUS_IGNORE);
   delete this->Worker;
+  delete this->Provisional;
+}
+
+// --------------------------------------------------------------------------
+void VTKHistogram::AddRangeAndCompute(vtkDataArray* da,
+  vtkUnsignedCharArray* ghostArray, int bins)
+{
+  if (!da)
+    return;
+
+  // the fine grid resolves each final bin with 256 bins
+  if (!this->Provisional)
+    this->Provisional = new HistogramKernels::StreamingBins(256*bins);
+
+  StreamingWorker worker;
+  worker.Bins = this->Provisional;
+  worker.Ghost = ghostArray ? ghostArray->GetPointer(0) : NULL;
+
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+  if (!vtkArrayDispatch::Dispatch::Execute(da, worker))
+    worker(da);
+#else
+  vtkDataArrayDispatcher<StreamingWorker> dispatcher(worker);
+  dispatcher.Go(da);
+#endif
+
+  double crange[2];
+  this->Provisional->GetRange(crange);
+  this->Range[0] = std::min(this->Range[0], crange[0]);
+  this->Range[1] = std::max(this->Range[1], crange[1]);
 }
 
 // --------------------------------------------------------------------------
 void VTKHistogram::AddRange(vtkDataArray* da,
   vtkUnsignedCharArray* ghostArray)
 {
+  if (!da)
+    return;
+
+  ComponentRangeWorker worker(ghostArray ? ghostArray->GetPointer(0) : NULL);
 #ifdef ENABLE_VTK_GENERIC_ARRAYS
-  (void)ghostArray;
-  if (da)
-    {
-    double crange[2];
-    da->GetRange(crange);
-    this->Range[0] = std::min(this->Range[0], crange[0]);
-    this->Range[1] = std::max(this->Range[1], crange[1]);
-    }
+  if (!vtkArrayDispatch::Dispatch::Execute(da, worker))
+    worker(da);
 #else
-  double crange[2] = { vtkTypeTraits<double>::Max(), vtkTypeTraits<double>::Min() };
-  if (da && ghostArray)
-    {
-    ComponentRangeWorker worker(ghostArray);
-    vtkDataArrayDispatcher<ComponentRangeWorker> dispatcher(worker);
-    dispatcher.Go(da);
-    worker.GetRange(crange);
-    }
-  else if (da)
-    {
-    da->GetRange(crange);
-    }
+  vtkDataArrayDispatcher<ComponentRangeWorker> dispatcher(worker);
+  dispatcher.Go(da);
+#endif
+
+  double crange[2];
+  worker.GetRange(crange);
   this->Range[0] = std::min(this->Range[0], crange[0]);
   this->Range[1] = std::max(this->Range[1], crange[1]);
-#endif
 }
 
 // --------------------------------------------------------------------------
@@ -209,79 +296,175 @@ void VTKHistogram::Compute(vtkDataArray* da,
 {
   if (da)
     {
+    this->Worker->Ghost = ghostArray ? ghostArray->GetPointer(0) : NULL;
 #ifdef ENABLE_VTK_GENERIC_ARRAYS
-    (void)ghostArray;
     vtkArrayDispatch::Dispatch::Execute(da, *this->Worker);
 #else
-    this->Worker->GhostArray = ghostArray;
     vtkDataArrayDispatcher<Internals> dispatcher(*this->Worker);
     dispatcher.Go(da);
-    this->Worker->GhostArray = NULL;
 #endif
+    this->Worker->Ghost = NULL;
     }
 }
 
 // --------------------------------------------------------------------------
 void VTKHistogram::PreCompute(MPI_Comm comm, int bins)
 {
-  double g_range[2];
-  // Find the global max/min
-  MPI_Allreduce(&this->Range[0], &g_range[0], 1, MPI_DOUBLE, MPI_MIN, comm);
-  MPI_Allreduce(&this->Range[1], &g_range[1], 1, MPI_DOUBLE, MPI_MAX, comm);
-  this->Range[0] = g_range[0];
-  this->Range[1] = g_range[1];
+  this->StartPreCompute(comm);
+  this->FinishPreCompute(bins);
+}
+
+// --------------------------------------------------------------------------
+void VTKHistogram::StartPreCompute(MPI_Comm comm)
+{
+  // Find the global max/min. the max is negated so that both are
+  // found by a single MPI_MIN reduction
+  this->RangeBuffer[0] = this->Range[0];
+  this->RangeBuffer[1] = -this->Range[1];
+
+  MPI_Iallreduce(this->RangeBuffer, this->RangeBuffer + 2, 2,
+    MPI_DOUBLE, MPI_MIN, comm, &this->RangeRequest);
+}
+
+// --------------------------------------------------------------------------
+void VTKHistogram::FinishPreCompute(int bins)
+{
+  MPI_Wait(&this->RangeRequest, MPI_STATUS_IGNORE);
+
+  double g_range[2] = {this->RangeBuffer[2], -this->RangeBuffer[3]};
+  this->Initialize(g_range, bins);
+}
+
+// --------------------------------------------------------------------------
+void VTKHistogram::Initialize(const double range[2], int bins)
+{
+  this->Range[0] = range[0];
+  this->Range[1] = range[1];
+
+  delete this->Worker;
   this->Worker = new Internals(this->Range, bins);
+
+  // in single pass mode the local data has already been binned. once
+  // moved the provisional bins are no longer needed
+  if (this->Provisional)
+    {
+    this->Provisional->Rebin(this->Range[0], this->Range[1],
+      bins, this->Worker->Histogram.data());
+    delete this->Provisional;
+    this->Provisional = NULL;
+    }
+}
+
+// --------------------------------------------------------------------------
+void VTKHistogram::Merge(const VTKHistogram &other)
+{
+  this->Range[0] = std::min(this->Range[0], other.Range[0]);
+  this->Range[1] = std::max(this->Range[1], other.Range[1]);
+
+  if (this->Worker && other.Worker)
+    {
+    std::vector<uint64_t> &hist = this->Worker->Histogram;
+    const std::vector<uint64_t> &otherHist = other.Worker->Histogram;
+    size_t n = std::min(hist.size(), otherHist.size());
+    for (size_t i = 0; i < n; ++i)
+      hist[i] += otherHist[i];
+    }
+}
+
+// --------------------------------------------------------------------------
+void VTKHistogram::GetRange(double range[2]) const
+{
+  range[0] = this->Range[0];
+  range[1] = this->Range[1];
+}
+
+// --------------------------------------------------------------------------
+uint64_t *VTKHistogram::GetBins()
+{
+  return this->Worker ? this->Worker->Histogram.data() : NULL;
 }
 
 // --------------------------------------------------------------------------
 void VTKHistogram::PostCompute(MPI_Comm comm, int bins, const std::string& name)
 {
-  std::vector<unsigned int> gHist(bins, 0);
+  this->StartPostCompute(comm, bins, name);
+  this->FinishPostCompute();
+}
 
-  MPI_Reduce(&this->Worker->Histogram[0], &gHist[0],
-    bins, MPI_UNSIGNED, MPI_SUM, 0, comm);
+// --------------------------------------------------------------------------
+void VTKHistogram::StartPostCompute(MPI_Comm comm, int bins,
+  const std::string& name)
+{
+  // complete the previous reduction before its buffers are reused
+  this->FinishPostCompute();
 
-  int rank = 0;
-  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_rank(comm, &this->PendingRank);
+  this->PendingName = name;
 
-  if (rank == 0)
-    {
-    // if there was an error range is initialized to [DOUBLE_MAX, DOUBLE_MIN]
-    if (this->Range[0] >= this->Range[1])
-      {
-      SENSEI_ERROR("Invalid histgram range ["
-        << this->Range[0] << " - " << this->Range[1] << "]")
-      return;
-      }
+  // the local bins are copied so that they may continue to be
+  // updated while the reduction is in flight
+  this->LocalBins = this->Worker->Histogram;
+  this->GlobalBins.assign(bins, 0);
 
-    // print the histogram bins, range of each bin and count.
-    int origPrec = cout.precision();
-    cout.precision(4);
+  MPI_Ireduce(&this->LocalBins[0], &this->GlobalBins[0],
+    bins, MPI_UINT64_T, MPI_SUM, 0, comm, &this->BinsRequest);
+}
 
-    std::cout << "Histogram '" << name << "' (VTK):\n";
-    double width = (this->Range[1] - this->Range[0]) / bins;
-    for (int i = 0; i < bins; ++i)
-      {
-      const int wid = 15;
-      cout << std::scientific << std::setw(wid) << std::right << this->Range[0] + i*width
-        << " - " << std::setw(wid) << std::left << this->Range[0] + (i+1)*width
-        << ": " << std::fixed << gHist[i] << endl;
-      }
+// --------------------------------------------------------------------------
+void VTKHistogram::FinishPostCompute()
+{
+  if (this->BinsRequest == MPI_REQUEST_NULL)
+    return;
 
-    // cache the last result
-    this->Worker->Histogram = gHist;
+  MPI_Wait(&this->BinsRequest, MPI_STATUS_IGNORE);
 
-    cout.precision(origPrec);
+  if (this->PendingRank == 0)
+    this->Report(this->GlobalBins.size(), this->GlobalBins.data(),
+      this->PendingName);
+}
+
+// --------------------------------------------------------------------------
+void VTKHistogram::Report(int bins, const uint64_t *gHist,
+  const std::string &name)
+{
+  // if there was an error range is initialized to [DOUBLE_MAX, DOUBLE_MIN]
+  if (this->Range[0] >= this->Range[1])
+    {
+    SENSEI_ERROR("Invalid histgram range ["
+      << this->Range[0] << " - " << this->Range[1] << "]")
+    return;
     }
+
+  // print the histogram bins, range of each bin and count.
+  int origPrec = cout.precision();
+  cout.precision(4);
+
+  std::cout << "Histogram '" << name << "' (VTK):\n";
+  double width = (this->Range[1] - this->Range[0]) / bins;
+  for (int i = 0; i < bins; ++i)
+    {
+    const int wid = 15;
+    cout << std::scientific << std::setw(wid) << std::right << this->Range[0] + i*width
+      << " - " << std::setw(wid) << std::left << this->Range[0] + (i+1)*width
+      << ": " << std::fixed << gHist[i] << endl;
+    }
+
+  // cache the last result
+  this->Result.assign(gHist, gHist + bins);
+
+  cout.precision(origPrec);
 }
 
 // --------------------------------------------------------------------------
 int VTKHistogram::GetHistogram(MPI_Comm comm, double &min, double &max,
-  std::vector<unsigned int> &bins)
+  std::vector<uint64_t> &bins)
 {
   if (!this->Worker)
     return -1;
 
+  // a nonblocking reduction may still be in flight
+  this->FinishPostCompute();
+
   int rank = 0;
   MPI_Comm_rank(comm, &rank);
 
@@ -289,7 +472,7 @@ int VTKHistogram::GetHistogram(MPI_Comm comm, double &min, double &max,
     {
     min = this->Range[0];
     max = this->Range[1];
-    bins = this->Worker->Histogram;
+    bins = this->Result;
     }
 
   return 0;
@@ -5,12 +5,15 @@ class vtkUnsignedCharArray;
 class vtkDataArray;
 
 #include <mpi.h>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace sensei
 {
 
+namespace HistogramKernels { class StreamingBins; }
+
 class VTKHistogram
 {
 public:
@@ -22,14 +25,58 @@ public:
     void Compute(vtkDataArray* da, vtkUnsignedCharArray* ghostArray);
     void PostCompute(MPI_Comm comm, int bins, const std::string& name);
 
+    // nonblocking versions of PreCompute and PostCompute. the Start
+    // methods post the reduction and return, the Finish methods wait
+    // for it to complete. it is safe to call FinishPostCompute when
+    // nothing is pending.
+    void StartPreCompute(MPI_Comm comm);
+    void FinishPreCompute(int bins);
+    void StartPostCompute(MPI_Comm comm, int bins, const std::string& name);
+    void FinishPostCompute();
+
+    // single pass mode. used in place of AddRange and Compute, the array
+    // is read once, its range is found while it is binned on a
+    // provisional fine grid. PreCompute moves the provisional bins onto
+    // the global range.
+    void AddRangeAndCompute(vtkDataArray* da,
+      vtkUnsignedCharArray* ghostArray, int bins);
+
+    // support for processing blocks in parallel. each thread works
+    // on a private instance. Merge adds the private instance's range
+    // and bins into this one, Initialize sets the global range on a
+    // private instance without communicating.
+    void Merge(const VTKHistogram &other);
+    void Initialize(const double range[2], int bins);
+    void GetRange(double range[2]) const;
+
+    // support for reducing several histograms in one collective.
+    // GetBins returns the local bins, valid after PreCompute or
+    // Initialize. Report takes the global bins on rank 0, prints them
+    // and caches them as PostCompute does. the bins are 64 bit since
+    // they may be accumulated over many time steps.
+    uint64_t *GetBins();
+    void Report(int bins, const uint64_t *gHist, const std::string &name);
+
     // return the last computed results
     int GetHistogram(MPI_Comm comm, double &min, double &max,
-      std::vector<unsigned int> &bins);
+      std::vector<uint64_t> &bins);
 
 private:
+  VTKHistogram(const VTKHistogram&) = delete;
+  void operator=(const VTKHistogram&) = delete;
+
   double Range[2];
+  double RangeBuffer[4];
+  MPI_Request RangeRequest;
+  std::vector<uint64_t> LocalBins;
+  std::vector<uint64_t> GlobalBins;
+  std::vector<uint64_t> Result;
+  std::string PendingName;
+  int PendingRank;
+  MPI_Request BinsRequest;
   struct Internals;
   Internals *Worker;
+  HistogramKernels::StreamingBins *Provisional;
 };
 
 }
@@ -0,0 +1,134 @@
+#include "AutocorrelationKernels.h"
+
+#include <grid/grid.h>
+#include <grid/vertices.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// micro-benchmark comparing the per-step cost of the per-vertex
+// autocorrelation update Autocorrelation used to use, which indexes a
+// 4D grid with the window in the 4th dimension, against the flat
+// kernels. both are run on a cubic block with and without a ghost
+// layer and the correlations are compared. usage:
+//
+//    benchmarkAutocorrelation [block size] [window] [number of steps]
+
+using clock_type = std::chrono::high_resolution_clock;
+
+using GridRef = grid::GridRef<float,3>;
+using Vertex  = GridRef::Vertex;
+using Grid4D = grid::Grid<float,4>;
+
+// the loop Autocorrelation used
+void updateVertex(float *data, unsigned char *ghostArray, const Vertex &shape,
+  size_t window, size_t offset, size_t count, Grid4D &values, Grid4D &corr)
+{
+  GridRef g(data, shape);
+  grid::GridRef<unsigned char, 3> ghost(ghostArray, shape);
+  grid::for_each(g.shape(), [&](const Vertex& v)
+    {
+    auto gv = (ghost(v) == 0) ? g(v) : 0;
+
+    for (size_t i = 1; i <= window; ++i)
+      {
+      if (i > count) continue;
+
+      auto uc = v.lift(3, i-1);
+      auto uv = v.lift(3, (offset + window - i) % window);
+      corr(uc) += values(uv)*gv;
+      }
+
+    auto u = v.lift(3, offset);
+    values(u) = gv;
+    });
+}
+
+int benchmark(int nx, size_t window, int nSteps, bool ghosts)
+{
+  Vertex shape{nx, nx, nx};
+  size_t n = static_cast<size_t>(nx)*nx*nx;
+
+  // a field oscillating in time with a one cell ghost layer
+  std::vector<std::vector<float>> data(nSteps, std::vector<float>(n));
+  std::mt19937 gen(1234);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  for (int s = 0; s < nSteps; ++s)
+    for (size_t j = 0; j < n; ++j)
+      data[s][j] = std::sin(0.3f*s + 0.01f*j) + 0.1f*dist(gen);
+
+  std::vector<unsigned char> ghost(n, 0);
+  if (ghosts)
+    {
+    for (size_t j = 0; j < n; ++j)
+      {
+      int x = j % nx;
+      int y = (j / nx) % nx;
+      int z = j / (nx*nx);
+      ghost[j] = ((x == 0) || (y == 0) || (z == 0) || (x == nx - 1)
+        || (y == nx - 1) || (z == nx - 1)) ? 1 : 0;
+      }
+    }
+
+  Grid4D vValues(shape.lift(3, window));
+  Grid4D vCorr(shape.lift(3, window));
+  vCorr = 0;
+
+  clock_type::time_point t0 = clock_type::now();
+  for (int s = 0; s < nSteps; ++s)
+    updateVertex(data[s].data(), ghost.data(), shape, window,
+      s % window, s, vValues, vCorr);
+  clock_type::time_point t1 = clock_type::now();
+
+  std::vector<float> kValues(window*n);
+  std::vector<float> kCorr(window*n, 0.0f);
+
+  clock_type::time_point t2 = clock_type::now();
+  for (int s = 0; s < nSteps; ++s)
+    sensei::AutocorrelationKernels::Update(data[s].data(),
+      ghosts ? ghost.data() : nullptr, n, window, s % window, s,
+      kValues.data(), kCorr.data());
+  clock_type::time_point t3 = clock_type::now();
+
+  double tv = std::chrono::duration<double>(t1 - t0).count()/nSteps;
+  double tk = std::chrono::duration<double>(t3 - t2).count()/nSteps;
+
+  const char *name = ghosts ? "with ghosts" : "without ghosts";
+  std::cerr << name << " per vertex: " << tv*1.0e3 << " ms/step" << std::endl
+    << name << " kernel: " << tk*1.0e3 << " ms/step" << std::endl
+    << name << " speed up: " << tv/tk << std::endl;
+
+  // both should have computed the same correlations
+  const float *pv = vCorr.data();
+  for (size_t j = 0; j < window*n; ++j)
+    {
+    if (std::fabs(pv[j] - kCorr[j]) > 1.0e-5f*(1.0f + std::fabs(pv[j])))
+      {
+      std::cerr << "ERROR: " << name << " correlation " << j << " "
+        << kCorr[j] << " differs from " << pv[j] << std::endl;
+      return -1;
+      }
+    }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  int nx = argc > 1 ? atoi(argv[1]) : 64;
+  size_t window = argc > 2 ? atoi(argv[2]) : 10;
+  int nSteps = argc > 3 ? atoi(argv[3]) : 50;
+
+  std::cerr << "autocorrelation of a " << nx << "^3 block with window "
+    << window << " over " << nSteps << " steps" << std::endl;
+
+  int ierr = 0;
+  ierr += benchmark(nx, window, nSteps, false);
+  ierr += benchmark(nx, window, nSteps, true);
+
+  return ierr ? -1 : 0;
+}
@@ -0,0 +1,121 @@
+#include "AutocorrelationKernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// micro-benchmark comparing the per-step cost of the direct and FFT
+// autocorrelation engines over a range of windows to locate the window
+// above which the FFT engine is faster. the correlations computed by
+// the two engines are compared. usage:
+//
+//    benchmarkAutocorrelationFFT [block size] [number of steps] [max window]
+
+using clock_type = std::chrono::high_resolution_clock;
+
+using namespace sensei;
+
+int benchmark(size_t n, size_t window, int nSteps,
+  const std::vector<std::vector<float>> &data, double &td, double &tf)
+{
+  // direct
+  std::vector<float> values(window*n);
+  std::vector<float> dCorr(window*n, 0.0f);
+
+  clock_type::time_point t0 = clock_type::now();
+  for (int s = 0; s < nSteps; ++s)
+    AutocorrelationKernels::Update(data[s].data(),
+      static_cast<unsigned char*>(nullptr), n, window, s % window, s,
+      values.data(), dCorr.data());
+  clock_type::time_point t1 = clock_type::now();
+
+  // fft
+  size_t nFFT = AutocorrelationKernels::FFTLength(window);
+  std::vector<float> history(nFFT*n, 0.0f);
+  std::vector<float> fCorr(window*n, 0.0f);
+  size_t fill = 0;
+
+  clock_type::time_point t2 = clock_type::now();
+  for (int s = 0; s < nSteps; ++s)
+    {
+    AutocorrelationKernels::Record(data[s].data(),
+      static_cast<unsigned char*>(nullptr), n, window, fill, history.data());
+    if (++fill == nFFT - window)
+      {
+      AutocorrelationKernels::Correlate(history.data(), n, window, nFFT,
+        fill, fCorr.data());
+      fill = 0;
+      }
+    }
+  AutocorrelationKernels::Correlate(history.data(), n, window, nFFT,
+    fill, fCorr.data());
+  clock_type::time_point t3 = clock_type::now();
+
+  td = std::chrono::duration<double>(t1 - t0).count()/nSteps;
+  tf = std::chrono::duration<double>(t3 - t2).count()/nSteps;
+
+  // both should have computed the same correlations, to within the
+  // round off of the transforms
+  float cMax = 0.0f;
+  for (size_t j = 0; j < window*n; ++j)
+    cMax = std::max(cMax, std::fabs(dCorr[j]));
+
+  for (size_t j = 0; j < window*n; ++j)
+    {
+    if (std::fabs(dCorr[j] - fCorr[j]) > 1.0e-4f*cMax)
+      {
+      std::cerr << "ERROR: window " << window << " correlation " << j
+        << " " << fCorr[j] << " differs from " << dCorr[j] << std::endl;
+      return -1;
+      }
+    }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  int nx = argc > 1 ? atoi(argv[1]) : 32;
+  int nSteps = argc > 2 ? atoi(argv[2]) : 256;
+  size_t maxWindow = argc > 3 ? atoi(argv[3]) : 128;
+
+  size_t n = static_cast<size_t>(nx)*nx*nx;
+
+  std::cerr << "autocorrelation of a " << nx << "^3 block over " << nSteps
+    << " steps with windows up to " << maxWindow << std::endl;
+
+  // a field oscillating in time
+  std::vector<std::vector<float>> data(nSteps, std::vector<float>(n));
+  std::mt19937 gen(1234);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  for (int s = 0; s < nSteps; ++s)
+    for (size_t j = 0; j < n; ++j)
+      data[s][j] = std::sin(0.3f*s + 0.01f*j) + 0.1f*dist(gen);
+
+  int ierr = 0;
+  size_t crossover = 0;
+  for (size_t window = 2; window <= maxWindow; window *= 2)
+    {
+    double td = 0.0;
+    double tf = 0.0;
+    ierr += benchmark(n, window, nSteps, data, td, tf);
+
+    std::cerr << "window " << window << " direct: " << td*1.0e3
+      << " ms/step fft: " << tf*1.0e3 << " ms/step speed up: "
+      << td/tf << std::endl;
+
+    if (!crossover && (tf < td))
+      crossover = window;
+    }
+
+  if (crossover)
+    std::cerr << "the fft engine is faster from window " << crossover << std::endl;
+  else
+    std::cerr << "the direct engine is faster for all windows" << std::endl;
+
+  return ierr ? -1 : 0;
+}
@@ -0,0 +1,160 @@
+#include "CompressionKernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+// micro-benchmark of the compression stages of the ADIOS schema on a
+// smooth float field with a little noise. the ratio and throughput of
+// shuffle + lz, and of quantization followed by shuffle + lz, are
+// reported and the values decoded are checked against the originals.
+// usage:
+//
+//    benchmarkCompression [number of values] [tolerance] [repetitions]
+
+using clock_type = std::chrono::high_resolution_clock;
+
+using namespace sensei;
+
+// compresses and decompresses the n values of data nReps times. returns
+// the compressed size and the error of the values decoded
+int benchmark(const std::string &name, const std::vector<float> &data,
+  double tolerance, int nReps, size_t &nBytes, double &te, double &td,
+  double &maxErr)
+{
+  size_t n = data.size();
+  size_t size = sizeof(float);
+  const unsigned char *raw = reinterpret_cast<const unsigned char*>(data.data());
+
+  std::vector<unsigned char> codes(n*size);
+  std::vector<unsigned char> shuffled(n*size);
+  std::vector<unsigned char> packed(CompressionKernels::LZBound(n*size));
+  std::vector<float> out(n);
+
+  CompressionKernels::QuantizeHeader header;
+
+  clock_type::time_point t0 = clock_type::now();
+  for (int r = 0; r < nReps; ++r)
+    {
+    const unsigned char *src = raw;
+    size = sizeof(float);
+    if (tolerance > 0.0)
+      {
+      if (CompressionKernels::Quantize(data.data(), n, tolerance, header,
+        codes.data()))
+        {
+        std::cerr << "ERROR: " << name << " failed to quantize" << std::endl;
+        return -1;
+        }
+      src = codes.data();
+      size = header.CodeSize;
+      }
+    CompressionKernels::Shuffle(src, n, size, shuffled.data());
+    nBytes = CompressionKernels::LZCompress(shuffled.data(), n*size,
+      packed.data());
+    }
+  clock_type::time_point t1 = clock_type::now();
+
+  for (int r = 0; r < nReps; ++r)
+    {
+    if (CompressionKernels::LZDecompress(packed.data(), nBytes,
+      shuffled.data(), n*size))
+      {
+      std::cerr << "ERROR: " << name << " failed to decompress" << std::endl;
+      return -1;
+      }
+    if (tolerance > 0.0)
+      {
+      CompressionKernels::Unshuffle(shuffled.data(), n, size, codes.data());
+      CompressionKernels::Dequantize(codes.data(), n, header, out.data());
+      }
+    else
+      {
+      CompressionKernels::Unshuffle(shuffled.data(), n, size,
+        reinterpret_cast<unsigned char*>(out.data()));
+      }
+    }
+  clock_type::time_point t2 = clock_type::now();
+
+  te = std::chrono::duration<double>(t1 - t0).count()/nReps;
+  td = std::chrono::duration<double>(t2 - t1).count()/nReps;
+
+  maxErr = 0.0;
+  double maxAbs = 0.0;
+  for (size_t i = 0; i < n; ++i)
+    {
+    maxErr = std::max(maxErr, std::fabs(double(out[i]) - double(data[i])));
+    maxAbs = std::max(maxAbs, std::fabs(double(data[i])));
+    }
+
+  // lossless stages reproduce the values and the quantizer stays within
+  // the tolerance, up to the round off of converting back to float
+  double bound = tolerance + maxAbs*std::numeric_limits<float>::epsilon();
+  if ((tolerance > 0.0) ? (maxErr > bound) : (maxErr != 0.0))
+    {
+    std::cerr << "ERROR: " << name << " max error " << maxErr
+      << " exceeds " << (tolerance > 0.0 ? bound : 0.0) << std::endl;
+    return -1;
+    }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  long n = argc > 1 ? atol(argv[1]) : 1000000;
+  double tolerance = argc > 2 ? atof(argv[2]) : 1.0e-3;
+  int nReps = argc > 3 ? atoi(argv[3]) : 4;
+
+  std::cerr << "compression of " << n << " floats, " << nReps
+    << " repetitions" << std::endl;
+
+  std::mt19937 gen(1234);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+  std::vector<float> data(n);
+  for (long i = 0; i < n; ++i)
+    data[i] = 100.0f*std::sin(1.0e-4f*i) + 1.0e-3f*dist(gen);
+
+  // a short input with long runs, and inputs shorter than a match, are
+  // handled
+  int ierr = 0;
+  for (size_t m = 0; m < 40; ++m)
+    {
+    std::vector<unsigned char> in(m, 7);
+    std::vector<unsigned char> packed(CompressionKernels::LZBound(m));
+    std::vector<unsigned char> out(m + 1, 0);
+    size_t nb = CompressionKernels::LZCompress(in.data(), m, packed.data());
+    if (CompressionKernels::LZDecompress(packed.data(), nb, out.data(), m) ||
+      !std::equal(in.begin(), in.end(), out.begin()))
+      {
+      std::cerr << "ERROR: failed to round trip " << m << " bytes" << std::endl;
+      ierr = -1;
+      }
+    }
+
+  const char *names[] = {"shuffle+lz", "quantize+shuffle+lz"};
+  double tols[] = {0.0, tolerance};
+  for (int i = 0; i < 2; ++i)
+    {
+    size_t nBytes = 0;
+    double te = 0.0;
+    double td = 0.0;
+    double maxErr = 0.0;
+    ierr += benchmark(names[i], data, tols[i], nReps, nBytes, te, td, maxErr);
+
+    double mb = n*sizeof(float)/1048576.0;
+    std::cerr << names[i] << " ratio: " << double(n*sizeof(float))/nBytes
+      << " encode: " << mb/te << " MB/s decode: " << mb/td
+      << " MB/s max error: " << maxErr << std::endl;
+    }
+
+  return ierr ? -1 : 0;
+}
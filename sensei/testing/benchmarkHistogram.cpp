@@ -0,0 +1,145 @@
+#include "HistogramKernels.h"
+
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIntArray.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// micro-benchmark comparing the throughput of the per-tuple
+// GetComponent loop VTKHistogram used to use against the vectorized
+// binning kernels. the kernels are also timed with a ghost array
+// flagging a layer at both ends of each row of a square block. usage:
+//
+//    benchmarkHistogram [number of values] [number of bins] [repetitions]
+
+using clock_type = std::chrono::high_resolution_clock;
+
+// the loop VTKHistogram used for generic arrays
+void binComponent(vtkDataArray *array, double min, double max,
+  int nBins, unsigned int *hist)
+{
+  double width = (max - min)/nBins;
+  std::vector<unsigned int> tmp(nBins + 1, 0);
+  vtkIdType n = array->GetNumberOfTuples();
+  for (vtkIdType i = 0; i < n; ++i)
+    {
+    int bin = static_cast<int>((array->GetComponent(i, 0) - min)/width);
+    ++tmp[bin];
+    }
+  tmp[nBins-1] += tmp[nBins];
+  for (int i = 0; i < nBins; ++i)
+    hist[i] += tmp[i];
+}
+
+template <typename array_t>
+int benchmark(const std::string &name, long n, int nBins, int nReps)
+{
+  using n_t = typename array_t::ValueType;
+
+  std::mt19937 gen(1234);
+  std::normal_distribution<double> dist(0.0, 1000.0);
+
+  array_t *array = array_t::New();
+  array->SetNumberOfTuples(n);
+  n_t *pdata = array->GetPointer(0);
+  for (long i = 0; i < n; ++i)
+    pdata[i] = static_cast<n_t>(dist(gen));
+
+  double range[2];
+  array->GetRange(range);
+
+  std::vector<unsigned int> hc(nBins, 0);
+  clock_type::time_point t0 = clock_type::now();
+  for (int i = 0; i < nReps; ++i)
+    binComponent(array, range[0], range[1], nBins, hc.data());
+  clock_type::time_point t1 = clock_type::now();
+
+  std::vector<unsigned int> hk(nBins, 0);
+  for (int i = 0; i < nReps; ++i)
+    sensei::HistogramKernels::Bin(pdata, nullptr, n, range[0],
+      range[1], nBins, hk.data());
+  clock_type::time_point t2 = clock_type::now();
+
+  // one ghost layer on each side of the rows of a square block
+  long nx = std::max(3l, static_cast<long>(std::sqrt(static_cast<double>(n))));
+  std::vector<unsigned char> ghost(n, 0);
+  unsigned long nKept = 0;
+  for (long i = 0; i < n; ++i)
+    {
+    long x = i % nx;
+    ghost[i] = ((x == 0) || (x == nx - 1)) ? 1 : 0;
+    nKept += ghost[i] == 0;
+    }
+
+  std::vector<unsigned int> hg(nBins, 0);
+  clock_type::time_point t3 = clock_type::now();
+  for (int i = 0; i < nReps; ++i)
+    sensei::HistogramKernels::Bin(pdata, ghost.data(), n, range[0],
+      range[1], nBins, hg.data());
+  clock_type::time_point t4 = clock_type::now();
+
+  array->Delete();
+
+  double tc = std::chrono::duration<double>(t1 - t0).count();
+  double tk = std::chrono::duration<double>(t2 - t1).count();
+  double tg = std::chrono::duration<double>(t4 - t3).count();
+  double nTot = static_cast<double>(n)*nReps;
+
+  std::cerr << name << " GetComponent: " << nTot/tc << " elements/sec" << std::endl
+    << name << " kernel: " << nTot/tk << " elements/sec" << std::endl
+    << name << " speed up: " << tc/tk << std::endl
+    << name << " kernel with ghosts: " << nTot/tg << " elements/sec" << std::endl;
+
+  // both should have counted every value
+  unsigned long sc = 0;
+  unsigned long sk = 0;
+  unsigned long sg = 0;
+  for (int i = 0; i < nBins; ++i)
+    {
+    sc += hc[i];
+    sk += hk[i];
+    sg += hg[i];
+    }
+  if ((sc != sk) || (sk != static_cast<unsigned long>(nTot)))
+    {
+    std::cerr << "ERROR: " << name << " bin totals " << sc << " and "
+      << sk << " differ from " << static_cast<unsigned long>(nTot) << std::endl;
+    return -1;
+    }
+
+  // and the ghost cells should have been skipped
+  if (sg != nKept*nReps)
+    {
+    std::cerr << "ERROR: " << name << " bin total with ghosts " << sg
+      << " differs from " << nKept*nReps << std::endl;
+    return -1;
+    }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  long n = argc > 1 ? atol(argv[1]) : 1000000;
+  int nBins = argc > 2 ? atoi(argv[2]) : 64;
+  int nReps = argc > 3 ? atoi(argv[3]) : 10;
+
+  std::cerr << "binning " << n << " values into " << nBins
+    << " bins " << nReps << " times" << std::endl;
+
+  int ierr = 0;
+  ierr += benchmark<vtkFloatArray>("float", n, nBins, nReps);
+  ierr += benchmark<vtkDoubleArray>("double", n, nBins, nReps);
+  ierr += benchmark<vtkIntArray>("int", n, nBins, nReps);
+
+  return ierr ? -1 : 0;
+}
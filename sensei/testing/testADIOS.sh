@@ -2,7 +2,7 @@
 
 if [[ $# < 8 ]]
 then
-  echo "test_adios.sh [mpiexec] [npflag] [nproc] [src dir] [file] [write method] [read method] [nits]"
+  echo "test_adios.sh [mpiexec] [npflag] [nproc] [src dir] [file] [write method] [read method] [nits] [async depth]"
   exit 1
 fi
 
@@ -14,6 +14,7 @@ file=$5
 writeMethod=$6
 readMethod=$7
 nits=$8
+asyncDepth=${9:-0}
 delay=1s
 
 trap 'echo $BASH_COMMAND' DEBUG
@@ -22,7 +23,7 @@ rm -f ${file}
 
 echo "testing ${writeMethod} -> ${readMethod}"
 
-${mpiexec} ${npflag} ${nproc} python ${srcdir}/testADIOSWrite.py ${file} ${writeMethod} ${nits} &
+${mpiexec} ${npflag} ${nproc} python ${srcdir}/testADIOSWrite.py ${file} ${writeMethod} ${nits} ${asyncDepth} &
 writePid=$!
 
 if [[ "${readMethod}" == "BP" ]]
@@ -1,5 +1,5 @@
 from mpi4py import *
-from sensei import VTKDataAdaptor,ADIOSDataAdaptor,ADIOSAnalysisAdaptor
+from sensei import VTKDataAdaptor,ADIOSDataAdaptor,ADIOSAnalysisAdaptor,Histogram
 import sys,os
 import numpy as np
 import vtk, vtk.util.numpy_support as vtknp
@@ -94,11 +94,35 @@ def get_polydata(nx):
   get_data_arrays(nx, pd.GetCellData())
   return pd
 
-def write_data(file_name, method, n_its):
+def fill_data_arrays(mesh, val):
+  # sets array[i] = i, or every value to val when it is given
+  it = mesh.NewIterator()
+  while not it.IsDoneWithTraversal():
+    ds = it.GetCurrentDataObject()
+    for dsa in [ds.GetPointData(), ds.GetCellData()]:
+      j = 0
+      while j < dsa.GetNumberOfArrays():
+        a = vtknp.vtk_to_numpy(dsa.GetArray(j))
+        if val is None:
+          a[:] = np.arange(len(a))
+        else:
+          a[:] = val
+        j += 1
+    it.GoToNextItem()
+
+def write_data(file_name, method, n_its, async_depth):
   # initialize the analysis adaptor
   aw = ADIOSAnalysisAdaptor.New()
   aw.SetFileName(file_name)
   aw.SetMethod(method)
+  aw.SetAsynchronous(async_depth)
+
+  # in asynchronous mode an analysis makes collective calls on the
+  # main thread while the steps are written in the background
+  ha = None
+  if async_depth > 0:
+    ha = Histogram.New()
+    ha.Initialize(8, 'image', vtk.vtkDataObject.POINT, 'double_array')
 
   # create the datasets
   # the first mesh is an image
@@ -117,6 +141,9 @@ def write_data(file_name, method, n_its):
   while i < n_its:
     t = float(i)
     it = i
+    if ha is not None:
+      for mesh in meshes.values():
+        fill_data_arrays(mesh, None)
     # pass into the data adaptor
     status_message('initializing the VTKDataAdaptor ' \
       'step %d time %0.1f'%(it,t))
@@ -134,6 +161,13 @@ def write_data(file_name, method, n_its):
 
     aw.Execute(da)
 
+    if ha is not None:
+      ha.Execute(da)
+      # the step written is a snapshot, the simulation may modify its
+      # data once Execute returns. it's restored for the next step
+      for mesh in meshes.values():
+        fill_data_arrays(mesh, 100)
+
     # free up data
     da.ReleaseData()
     da = None
@@ -141,6 +175,8 @@ def write_data(file_name, method, n_its):
 
   # force free up the adaptor
   aw.Finalize()
+  if ha is not None:
+    ha.Finalize()
   status_message('finished writing %d steps'%(n_its))
   # set the return value
   return 0
@@ -150,8 +186,9 @@ if __name__ == '__main__':
   file_name = sys.argv[1]
   method = sys.argv[2]
   n_its = int(sys.argv[3])
+  async_depth = int(sys.argv[4]) if len(sys.argv) > 4 else 0
   # write data
-  ierr = write_data(file_name, method, n_its)
+  ierr = write_data(file_name, method, n_its, async_depth)
   if ierr:
     error_message('write failed')
   # return the error code
@@ -0,0 +1,230 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <mpi.h>
+#include <vtkDoubleArray.h>
+#include <vtkImageData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+#include "Autocorrelation.h"
+#include "VTKDataAdaptor.h"
+
+// tests that a run of Autocorrelation restored from a checkpoint and
+// continued reaches the state of an uninterrupted run. the states are
+// compared through the checkpoints the runs write at their end, which
+// hold the history and the correlations of every block. checkpoints
+// that can't be used, a missing file, another window, precision, or
+// decomposition, must be rejected on all ranks and the run must start
+// afresh. usage:
+//
+//    testAutocorrelationCheckpoint [file name prefix]
+
+struct Config
+{
+  size_t Window;
+  int Engine;
+  int BlocksPerRank;
+  bool DoublePrecision;
+};
+
+// makes a multiblock with blocksPerRank blocks on each rank, the blocks
+// of the other ranks are empty. block b is a cube of nx^3 points stacked
+// on block b-1 in z
+vtkMultiBlockDataSet *newMesh(int blocksPerRank, int nx)
+{
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+  mb->SetNumberOfBlocks(nRanks*blocksPerRank);
+
+  for (int i = 0; i < blocksPerRank; ++i)
+    {
+    int b = rank*blocksPerRank + i;
+
+    vtkDoubleArray *da = vtkDoubleArray::New();
+    da->SetNumberOfTuples(nx*nx*nx);
+    da->SetName("data");
+
+    vtkImageData *im = vtkImageData::New();
+    im->SetExtent(0, nx - 1, 0, nx - 1, b*nx, (b + 1)*nx - 1);
+    im->GetPointData()->AddArray(da);
+    da->Delete();
+
+    mb->SetBlock(b, im);
+    im->Delete();
+    }
+
+  return mb;
+}
+
+// sets the values of the local blocks for the given step
+void setStep(vtkMultiBlockDataSet *mb, int step)
+{
+  unsigned int nBlocks = mb->GetNumberOfBlocks();
+  for (unsigned int b = 0; b < nBlocks; ++b)
+    {
+    vtkImageData *im = vtkImageData::SafeDownCast(mb->GetBlock(b));
+    if (!im)
+      continue;
+
+    vtkDoubleArray *da = vtkDoubleArray::SafeDownCast(
+      im->GetPointData()->GetArray("data"));
+
+    vtkIdType n = da->GetNumberOfTuples();
+    for (vtkIdType i = 0; i < n; ++i)
+      *da->GetPointer(i) = std::sin(0.3*step + 0.05*(b*n + i));
+    }
+}
+
+// runs steps [first, last) on a new Autocorrelation, restored from the
+// readFile when it is given, and checkpoints it to writeFile
+int run(const Config &cfg, int first, int last, const std::string &readFile,
+  const std::string &writeFile)
+{
+  int nx = 6;
+  vtkMultiBlockDataSet *mb = newMesh(cfg.BlocksPerRank, nx);
+
+  sensei::VTKDataAdaptor *dataAdaptor = sensei::VTKDataAdaptor::New();
+  dataAdaptor->SetDataObject("mesh", mb);
+
+  sensei::Autocorrelation *analysis = sensei::Autocorrelation::New();
+  analysis->SetEngine(cfg.Engine);
+  analysis->SetDoublePrecision(cfg.DoublePrecision);
+  analysis->Initialize(cfg.Window, "mesh", vtkDataObject::POINT, "data", 3);
+
+  int ierr = 0;
+  if (!readFile.empty() && analysis->ReadCheckpoint(readFile))
+    {
+    std::cerr << "ERROR: failed to restore from " << readFile << std::endl;
+    ierr = -1;
+    }
+
+  for (int step = first; !ierr && (step < last); ++step)
+    {
+    setStep(mb, step);
+    if (!analysis->Execute(dataAdaptor))
+      {
+      std::cerr << "ERROR: failed to execute step " << step << std::endl;
+      ierr = -1;
+      }
+    }
+
+  if (!ierr && analysis->WriteCheckpoint(writeFile))
+    {
+    std::cerr << "ERROR: failed to checkpoint to " << writeFile << std::endl;
+    ierr = -1;
+    }
+
+  analysis->Delete();
+  dataAdaptor->Delete();
+  mb->Delete();
+
+  return ierr;
+}
+
+// compares two checkpoints byte for byte on rank 0
+int compare(const std::string &name, const std::string &fileA,
+  const std::string &fileB)
+{
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (rank != 0)
+    return 0;
+
+  std::ifstream a(fileA, std::ios::binary);
+  std::ifstream b(fileB, std::ios::binary);
+  std::vector<char> bytesA((std::istreambuf_iterator<char>(a)),
+    std::istreambuf_iterator<char>());
+  std::vector<char> bytesB((std::istreambuf_iterator<char>(b)),
+    std::istreambuf_iterator<char>());
+
+  if (bytesA.empty() || (bytesA != bytesB))
+    {
+    std::cerr << "ERROR: " << name << " " << fileA << " (" << bytesA.size()
+      << " bytes) differs from " << fileB << " (" << bytesB.size()
+      << " bytes)" << std::endl;
+    return -1;
+    }
+
+  std::cerr << name << " passed" << std::endl;
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  std::string prefix = argc > 1 ? argv[1] : "testAutocorrelationCheckpoint";
+  std::string whole = prefix + ".whole";
+  std::string half = prefix + ".half";
+  std::string resumed = prefix + ".resumed";
+  std::string fresh = prefix + ".fresh";
+  std::string restarted = prefix + ".restarted";
+
+  int nSteps = 25;
+  int mid = 12;
+
+  int ierr = 0;
+  int engines[] = {sensei::Autocorrelation::ENGINE_DIRECT,
+    sensei::Autocorrelation::ENGINE_FFT};
+  for (int engine : engines)
+    {
+    const char *engineName =
+      engine == sensei::Autocorrelation::ENGINE_FFT ? "fft" : "direct";
+    Config cfg{5, engine, 2, false};
+
+    // an uninterrupted run, and one checkpointed half way through,
+    // restored, and continued
+    ierr += run(cfg, 0, nSteps, "", whole);
+    ierr += run(cfg, 0, mid, "", half);
+    ierr += run(cfg, mid, nSteps, half, resumed);
+    ierr += compare(std::string(engineName) + " resumed", whole, resumed);
+
+    // a missing checkpoint starts afresh
+    ierr += run(cfg, 0, nSteps, prefix + ".missing", restarted);
+    ierr += compare(std::string(engineName) + " missing", whole, restarted);
+
+    // a checkpoint made with another window starts afresh
+    Config other{7, engine, 2, false};
+    ierr += run(other, 0, nSteps, "", fresh);
+    ierr += run(other, 0, nSteps, half, restarted);
+    ierr += compare(std::string(engineName) + " window", fresh, restarted);
+
+    // a checkpoint missing some of the blocks starts afresh
+    Config more{5, engine, 3, false};
+    ierr += run(more, 0, nSteps, "", fresh);
+    ierr += run(more, 0, nSteps, half, restarted);
+    ierr += compare(std::string(engineName) + " blocks", fresh, restarted);
+
+    // a checkpoint made in another precision starts afresh
+    Config wide{5, engine, 2, true};
+    ierr += run(wide, 0, nSteps, "", fresh);
+    ierr += run(wide, 0, nSteps, half, restarted);
+    ierr += compare(std::string(engineName) + " precision", fresh,
+      restarted);
+    }
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  if (rank == 0)
+    {
+    std::remove(whole.c_str());
+    std::remove(half.c_str());
+    std::remove(resumed.c_str());
+    std::remove(fresh.c_str());
+    std::remove(restarted.c_str());
+    }
+
+  MPI_Finalize();
+
+  return ierr ? -1 : 0;
+}
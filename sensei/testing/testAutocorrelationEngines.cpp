@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <mpi.h>
+#include <vtkDoubleArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include "Autocorrelation.h"
+#include "VTKDataAdaptor.h"
+
+// tests that Autocorrelation computes the same correlations with the
+// fft engine as with the direct engine. the analysis is run end to end,
+// so that the fft engine's history is the one the analysis allocates,
+// and the sums of the correlations of each shift are compared. the
+// number of steps is not a multiple of the fft engine's chunk so that
+// the last partial chunk is flushed. usage:
+//
+//    testAutocorrelationEngines [number of steps]
+
+// runs nSteps steps on a block of nx^3 points per rank and returns the
+// sums of the correlations on rank 0
+int run(int engine, bool doublePrecision, size_t window, int nSteps,
+  std::vector<double> &sums)
+{
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  int nx = 8;
+  vtkDoubleArray *da = vtkDoubleArray::New();
+  da->SetNumberOfTuples(nx*nx*nx);
+  da->SetName("data");
+
+  vtkImageData *im = vtkImageData::New();
+  im->SetExtent(0, nx - 1, 0, nx - 1, rank*nx, (rank + 1)*nx - 1);
+  im->GetPointData()->AddArray(da);
+
+  sensei::VTKDataAdaptor *dataAdaptor = sensei::VTKDataAdaptor::New();
+  dataAdaptor->SetDataObject("mesh", im);
+
+  sensei::Autocorrelation *analysis = sensei::Autocorrelation::New();
+  analysis->SetEngine(engine);
+  analysis->SetDoublePrecision(doublePrecision);
+  analysis->Initialize(window, "mesh", vtkDataObject::POINT, "data", 3);
+
+  int ierr = 0;
+  vtkIdType n = da->GetNumberOfTuples();
+  for (int step = 0; !ierr && (step < nSteps); ++step)
+    {
+    for (vtkIdType i = 0; i < n; ++i)
+      *da->GetPointer(i) = std::sin(0.3*step + 0.05*(rank*n + i)) + 0.5;
+
+    if (!analysis->Execute(dataAdaptor))
+      {
+      std::cerr << "ERROR: failed to execute step " << step << std::endl;
+      ierr = -1;
+      }
+    }
+
+  analysis->Finalize();
+  analysis->GetCorrelationSums(sums);
+
+  analysis->Delete();
+  dataAdaptor->Delete();
+  im->Delete();
+  da->Delete();
+
+  return ierr;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  int nSteps = argc > 1 ? atoi(argv[1]) : 37;
+
+  int ierr = 0;
+  size_t windows[] = {4, 10};
+  for (size_t window : windows)
+    {
+    for (int dp = 0; dp < 2; ++dp)
+      {
+      std::vector<double> direct;
+      std::vector<double> fft;
+      ierr += run(sensei::Autocorrelation::ENGINE_DIRECT, dp, window, nSteps,
+        direct);
+      ierr += run(sensei::Autocorrelation::ENGINE_FFT, dp, window, nSteps,
+        fft);
+
+      if (rank != 0)
+        continue;
+
+      if ((direct.size() != window) || (fft.size() != window))
+        {
+        std::cerr << "ERROR: window " << window << " expected " << window
+          << " sums, direct has " << direct.size() << " and fft "
+          << fft.size() << std::endl;
+        ierr = -1;
+        continue;
+        }
+
+      // the fft engine rounds differently, compare relative to the
+      // largest sum
+      double scale = 0.0;
+      for (size_t i = 0; i < window; ++i)
+        scale = std::max(scale, std::fabs(direct[i]));
+      double tol = (dp ? 1.0e-9 : 1.0e-5)*scale;
+
+      for (size_t i = 0; i < window; ++i)
+        {
+        if (std::fabs(direct[i] - fft[i]) > tol)
+          {
+          std::cerr << "ERROR: window " << window << " precision "
+            << (dp ? "double" : "float") << " shift " << i << " fft sum "
+            << fft[i] << " differs from direct sum " << direct[i]
+            << std::endl;
+          ierr = -1;
+          }
+        }
+      }
+    }
+
+  MPI_Finalize();
+
+  return ierr ? -1 : 0;
+}
@@ -0,0 +1,111 @@
+#include "CellLocationKernels.h"
+
+#include <vtkCellType.h>
+#include <vtkType.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// tests the cell locations built for unstructured grids read from ADIOS
+// streams written without them against a walk of the cells array. meshes
+// of fixed size cell types take the parallel scan, meshes that include a
+// variable size cell take the walk. usage:
+//
+//    testCellLocations [number of cells]
+
+using namespace sensei;
+
+// makes a mesh of n cells of the given types drawn at random, a polygon
+// has between 3 and 8 points
+void newMesh(unsigned long n, const std::vector<unsigned char> &cellTypes,
+  std::vector<unsigned char> &types, std::vector<vtkIdType> &cells)
+{
+  std::mt19937 gen(1234);
+  std::uniform_int_distribution<size_t> pick(0, cellTypes.size() - 1);
+  std::uniform_int_distribution<int> polySize(3, 8);
+
+  types.resize(n);
+  cells.clear();
+  for (unsigned long i = 0; i < n; ++i)
+    {
+    unsigned char type = cellTypes[pick(gen)];
+    int size = CellLocationKernels::GetCellSize(type);
+    if (size < 0)
+      size = polySize(gen);
+
+    types[i] = type;
+    cells.push_back(size);
+    for (int j = 0; j < size; ++j)
+      cells.push_back(i + j);
+    }
+}
+
+// compares the locations built to those of the walk
+int validate(const char *name, unsigned long n,
+  const std::vector<unsigned char> &cellTypes, unsigned int nThreads,
+  unsigned long minChunk)
+{
+  std::vector<unsigned char> types;
+  std::vector<vtkIdType> cells;
+  newMesh(n, cellTypes, types, cells);
+
+  std::vector<vtkIdType> ref(n);
+  CellLocationKernels::WalkCellLocations(n, cells.data(), ref.data());
+
+  std::vector<vtkIdType> locs(n, -1);
+  CellLocationKernels::BuildCellLocations(n, types.data(), cells.data(),
+    locs.data(), nThreads, minChunk);
+
+  for (unsigned long i = 0; i < n; ++i)
+    {
+    if (locs[i] != ref[i])
+      {
+      std::cerr << "ERROR: " << name << " " << n << " cells, " << nThreads
+        << " threads, min chunk " << minChunk << ", cell " << i
+        << " location " << locs[i] << " != " << ref[i] << std::endl;
+      return -1;
+      }
+    }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long n = argc > 1 ? atol(argv[1]) : 1000000;
+
+  std::vector<unsigned char> fixedTypes = {VTK_VERTEX, VTK_LINE,
+    VTK_TRIANGLE, VTK_QUAD, VTK_TETRA, VTK_PYRAMID, VTK_WEDGE,
+    VTK_HEXAHEDRON, VTK_QUADRATIC_TETRA, VTK_QUADRATIC_HEXAHEDRON};
+
+  std::vector<unsigned char> hexTypes = {VTK_HEXAHEDRON};
+
+  std::vector<unsigned char> mixedTypes = fixedTypes;
+  mixedTypes.push_back(VTK_POLYGON);
+
+  // the default chunk, which runs threads only on large meshes, and
+  // small chunks, which run them on every mesh. the sizes include empty
+  // meshes, meshes smaller than the number of chunks, and sizes that do
+  // not divide evenly
+  unsigned long sizes[] = {0, 1, 7, 1000, 65537, n};
+  unsigned int threads[] = {1, 4, 7};
+  unsigned long minChunks[] = {65536, 1, 3};
+
+  int ierr = 0;
+  for (unsigned long size : sizes)
+    {
+    for (unsigned int nThreads : threads)
+      {
+      for (unsigned long minChunk : minChunks)
+        {
+        ierr += validate("fixed", size, fixedTypes, nThreads, minChunk);
+        ierr += validate("hexahedra", size, hexTypes, nThreads, minChunk);
+        ierr += validate("mixed", size, mixedTypes, nThreads, minChunk);
+        }
+      }
+    }
+
+  return ierr ? -1 : 0;
+}
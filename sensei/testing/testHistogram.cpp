@@ -1,11 +1,23 @@
 #include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
 #include <mpi.h>
 #include <vtkDoubleArray.h>
 #include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkMultiBlockDataSet.h>
 #include <vtkPointData.h>
+#include <vtkUnsignedCharArray.h>
 #include "Error.h"
 #include "Histogram.h"
+#include "HistogramKernels.h"
+#include "JointHistogram.h"
+#include "MultiHistogram.h"
 #include "VTKDataAdaptor.h"
 
 //#define GENERATE_SEQUENCE
@@ -54,7 +66,8 @@ int getSequence(std::vector<n_t> &vals)
   return 0;
 }
 
-int validateHistogram(double min, double max, std::vector<unsigned int> &bins)
+int validateHistogram(double min, double max, const std::vector<uint64_t> &bins,
+  double scale = 1.0, unsigned int nSteps = 1)
 {
 #if defined(GENERATE_HISTOGRAM)
   unsigned int nBins = bins.size();
@@ -80,20 +93,20 @@ int validateHistogram(double min, double max, std::vector<unsigned int> &bins)
 
   for (unsigned int i = 0; i < gNBins; ++i)
     {
-    if (gHist[i] != bins[i])
+    if (nSteps*gHist[i] != bins[i])
       {
       SENSEI_ERROR("Bin count is wrong at bin " << i)
       return -1;
       }
     }
 
-  if (fabs(gMin - min) > 1.0e-6)
+  if (fabs(scale*gMin - min) > 1.0e-6)
     {
     SENSEI_ERROR("Incorrect minimum")
     return -1;
     }
 
-  if (fabs(gMax - max) > 1.0e-6)
+  if (fabs(scale*gMax - max) > 1.0e-6)
     {
     SENSEI_ERROR("Incorrect maximum")
     return -1;
@@ -103,6 +116,178 @@ int validateHistogram(double min, double max, std::vector<unsigned int> &bins)
   return 0;
 }
 
+// values far outside of a fixed range, beyond what an int bin index
+// can hold, are counted in the first and last bins. the length is not
+// a multiple of the vector width so that both the vector and scalar
+// loops are used
+template <typename T>
+int validateOutOfRange(const char *typeName)
+{
+  const int nBins = 8;
+  const size_t n = 1001;
+  std::vector<T> data(n);
+  for (size_t i = 0; i < n; ++i)
+    data[i] = (i % 3 == 0) ? std::numeric_limits<T>::max() :
+      ((i % 3 == 1) ? std::numeric_limits<T>::lowest() : T(1));
+
+  std::vector<unsigned int> bins(nBins, 0);
+  sensei::HistogramKernels::Bin(data.data(), nullptr, n, 0.0, 2.0,
+    nBins, bins.data());
+
+  std::vector<unsigned int> expected(nBins, 0);
+  expected[0] = (n + 1)/3;
+  expected[nBins/2] = n/3;
+  expected[nBins-1] = (n + 2)/3;
+
+  for (int i = 0; i < nBins; ++i)
+    {
+    if (bins[i] != expected[i])
+      {
+      SENSEI_ERROR("Out of range " << typeName << " values binned wrong, bin "
+        << i << " has " << bins[i] << " expected " << expected[i])
+      return -1;
+      }
+    }
+
+  return 0;
+}
+
+
+// bins accumulated over time are 64 bit, counts continue past what
+// an unsigned int holds
+int validateWideBins()
+{
+  const int nBins = 4;
+  const uint64_t start = std::numeric_limits<unsigned int>::max();
+  std::vector<double> data(100, 0.5);
+  std::vector<uint64_t> bins(nBins, start);
+
+  sensei::HistogramKernels::Bin(data.data(), nullptr, data.size(), 0.0, 1.0,
+    nBins, bins.data());
+
+  if ((bins[nBins/2] != start + data.size()) || (bins[0] != start))
+    {
+    SENSEI_ERROR("64 bit bins were not accumulated")
+    return -1;
+    }
+
+  return 0;
+}
+
+// split the values over nBlocks image data blocks, each with a point
+// data array named "normal"
+vtkMultiBlockDataSet *newMultiBlock(const std::vector<double> &vals,
+  unsigned int nBlocks)
+{
+  vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+  mb->SetNumberOfBlocks(nBlocks);
+
+  size_t nVals = vals.size();
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    size_t start = nVals*i/nBlocks;
+    size_t end = nVals*(i + 1)/nBlocks;
+
+    vtkDoubleArray *da = vtkDoubleArray::New();
+    da->SetNumberOfTuples(end - start);
+    da->SetName("normal");
+    for (size_t j = start; j < end; ++j)
+      *da->GetPointer(j - start) = vals[j];
+
+    vtkImageData *im = vtkImageData::New();
+    im->SetDimensions(end - start, 1, 1);
+    im->GetPointData()->AddArray(da);
+    da->Delete();
+
+    mb->SetBlock(i, im);
+    im->Delete();
+    }
+
+  return mb;
+}
+
+// the values with outliers flagged as ghosts interleaved among them and
+// a run of ghosts at the end, so that the ghost array has tiles without
+// ghosts, mixed tiles, and tiles of only ghosts
+vtkImageData *newGhosted(const std::vector<double> &vals)
+{
+  vtkDoubleArray *da = vtkDoubleArray::New();
+  da->SetName("normal");
+
+  vtkUnsignedCharArray *ghost = vtkUnsignedCharArray::New();
+  ghost->SetName(sensei::Histogram::GetGhostArrayName());
+
+  size_t nVals = vals.size();
+  for (size_t i = 0; i < nVals; ++i)
+    {
+    if ((i >= nVals/2) && (i % 5 == 0))
+      {
+      da->InsertNextValue(i % 2 ? 1.0e6 : -1.0e6);
+      ghost->InsertNextValue(vtkDataSetAttributes::DUPLICATEPOINT);
+      }
+    da->InsertNextValue(vals[i]);
+    ghost->InsertNextValue(0);
+    }
+
+  for (int i = 0; i < 200; ++i)
+    {
+    da->InsertNextValue(1.0e6);
+    ghost->InsertNextValue(vtkDataSetAttributes::DUPLICATEPOINT);
+    }
+
+  vtkImageData *im = vtkImageData::New();
+  im->SetDimensions(da->GetNumberOfTuples(), 1, 1);
+  im->GetPointData()->AddArray(da);
+  im->GetPointData()->AddArray(ghost);
+  da->Delete();
+  ghost->Delete();
+
+  return im;
+}
+
+// compare a histogram to a reference computed from the same data. the
+// ranges and the totals must match, the counts may differ by up to tol,
+// as they do near the bin edges in single pass mode
+int validateAgainst(const char *mode, double min, double max,
+  const std::vector<uint64_t> &bins, double refMin, double refMax,
+  const std::vector<uint64_t> &refBins, uint64_t tol)
+{
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (rank != 0)
+    return 0;
+
+  if ((bins.size() != refBins.size()) || (min != refMin) || (max != refMax))
+    {
+    SENSEI_ERROR(<< mode << " histogram has the wrong range or size")
+    return -1;
+    }
+
+  uint64_t total = 0;
+  uint64_t refTotal = 0;
+  for (size_t i = 0; i < bins.size(); ++i)
+    {
+    uint64_t diff = bins[i] > refBins[i] ?
+      bins[i] - refBins[i] : refBins[i] - bins[i];
+    if (diff > tol)
+      {
+      SENSEI_ERROR(<< mode << " histogram bin " << i << " has " << bins[i]
+        << " expected " << refBins[i])
+      return -1;
+      }
+    total += bins[i];
+    refTotal += refBins[i];
+    }
+
+  if (total != refTotal)
+    {
+    SENSEI_ERROR(<< mode << " histogram total " << total
+      << " expected " << refTotal)
+    return -1;
+    }
+
+  return 0;
+}
 
 int main(int argc, char **argv)
 {
@@ -123,6 +308,15 @@ int main(int argc, char **argv)
   im->GetPointData()->AddArray(da);
   da->Delete();
 
+  // a scaled copy, its histogram has the same counts
+  vtkDoubleArray *da2 = vtkDoubleArray::New();
+  da2->SetNumberOfTuples(nVals);
+  da2->SetName("scaled");
+  for (unsigned int i = 0; i < nVals; ++i)
+    *da2->GetPointer(i) = 2.0*vals[i];
+  im->GetPointData()->AddArray(da2);
+  da2->Delete();
+
   sensei::VTKDataAdaptor *dataAdaptor = sensei::VTKDataAdaptor::New();
   dataAdaptor->SetDataObject("mesh", im);
 
@@ -134,12 +328,286 @@ int main(int argc, char **argv)
 
   double min = 0.0;
   double max = 0.0;
-  std::vector<unsigned int> bins;
+  std::vector<uint64_t> bins;
   analysisAdaptor->GetHistogram(min, max, bins);
 
   int testResult = validateHistogram(min, max, bins);
 
   analysisAdaptor->Finalize();
+  analysisAdaptor->Delete();
+
+  // single pass mode reads the data once. compared to the two pass
+  // result the counts near the bin edges are off by a few values from
+  // the fine bins that straddle them
+  analysisAdaptor = sensei::Histogram::New();
+  analysisAdaptor->Initialize(gNBins, "mesh", vtkDataObject::POINT, "normal");
+  analysisAdaptor->SetSinglePass(true);
+  analysisAdaptor->Execute(dataAdaptor);
+
+  double spMin = 0.0;
+  double spMax = 0.0;
+  std::vector<uint64_t> spBins;
+  analysisAdaptor->GetHistogram(spMin, spMax, spBins);
+
+  testResult += validateAgainst("single pass", spMin, spMax, spBins,
+    min, max, bins, 10);
+
+  analysisAdaptor->Finalize();
+  analysisAdaptor->Delete();
+
+  // the local values split over several blocks processed by a pool of
+  // threads. each block is binned into private bins that are merged,
+  // the result is the same as when the blocks are processed in turn
+  vtkMultiBlockDataSet *mb = newMultiBlock(vals, 7);
+  sensei::VTKDataAdaptor *mbAdaptor = sensei::VTKDataAdaptor::New();
+  mbAdaptor->SetDataObject("blocks", mb);
+  mb->Delete();
+
+  for (int singlePass = 0; singlePass < 2; ++singlePass)
+    {
+    double refMin = 0.0;
+    double refMax = 0.0;
+    std::vector<uint64_t> refBins;
+
+    int threads[] = {1, 4};
+    for (int i = 0; i < 2; ++i)
+      {
+      analysisAdaptor = sensei::Histogram::New();
+      analysisAdaptor->Initialize(gNBins, "blocks", vtkDataObject::POINT, "normal");
+      analysisAdaptor->SetSinglePass(singlePass);
+      analysisAdaptor->SetThreads(threads[i]);
+      analysisAdaptor->Execute(mbAdaptor);
+
+      double tMin = 0.0;
+      double tMax = 0.0;
+      std::vector<uint64_t> tBins;
+      analysisAdaptor->GetHistogram(tMin, tMax, tBins);
+
+      if (i == 0)
+        {
+        // blocks processed in turn have the two pass result
+        testResult += validateAgainst(singlePass ? "multiblock single pass" :
+          "multiblock", tMin, tMax, tBins, min, max, bins, singlePass ? 10 : 0);
+        refMin = tMin;
+        refMax = tMax;
+        refBins = tBins;
+        }
+      else
+        {
+        // in single pass mode each block has its own fine grid, the
+        // counts near the edges may differ
+        testResult += validateAgainst(singlePass ? "threaded single pass" :
+          "threaded", tMin, tMax, tBins, refMin, refMax, refBins,
+          singlePass ? 10 : 0);
+        }
+
+      analysisAdaptor->Finalize();
+      analysisAdaptor->Delete();
+      }
+    }
+
+  mbAdaptor->Delete();
+
+  // ghosts carry outliers, they must not change the range or the counts
+  vtkImageData *gim = newGhosted(vals);
+  sensei::VTKDataAdaptor *ghostAdaptor = sensei::VTKDataAdaptor::New();
+  ghostAdaptor->SetDataObject("ghosted", gim);
+  gim->Delete();
+
+  for (int singlePass = 0; singlePass < 2; ++singlePass)
+    {
+    analysisAdaptor = sensei::Histogram::New();
+    analysisAdaptor->Initialize(gNBins, "ghosted", vtkDataObject::POINT, "normal");
+    analysisAdaptor->SetSinglePass(singlePass);
+    analysisAdaptor->Execute(ghostAdaptor);
+
+    double gMinOut = 0.0;
+    double gMaxOut = 0.0;
+    std::vector<uint64_t> gBins;
+    analysisAdaptor->GetHistogram(gMinOut, gMaxOut, gBins);
+
+    testResult += validateAgainst(singlePass ? "ghosted single pass" :
+      "ghosted", gMinOut, gMaxOut, gBins, min, max, bins, singlePass ? 10 : 0);
+
+    analysisAdaptor->Finalize();
+    analysisAdaptor->Delete();
+    }
+
+  ghostAdaptor->Delete();
+
+  // integer values land on the edges of the fine grid, in single pass mode
+  // it is aligned to them. a narrow range, fewer integers than fine bins,
+  // is binned exactly. on a wide range a fine bin straddling an edge is
+  // split evenly among its integers, a fine bin spans at most 1/128 of a
+  // final bin and each final bin has two edges
+  for (int wide = 0; wide < 2; ++wide)
+    {
+    const char *name = wide ? "wide integer" : "integer";
+    double scale = wide ? 1000.0 : 1.0;
+
+    vtkIntArray *ia = vtkIntArray::New();
+    ia->SetNumberOfTuples(nVals);
+    ia->SetName(name);
+    for (unsigned int i = 0; i < nVals; ++i)
+      *ia->GetPointer(i) = static_cast<int>(std::lround(scale*vals[i]));
+    im->GetPointData()->AddArray(ia);
+    ia->Delete();
+
+    double iMin[2] = {0.0};
+    double iMax[2] = {0.0};
+    std::vector<uint64_t> iBins[2];
+    for (int singlePass = 0; singlePass < 2; ++singlePass)
+      {
+      analysisAdaptor = sensei::Histogram::New();
+      analysisAdaptor->Initialize(gNBins, "mesh", vtkDataObject::POINT, name);
+      analysisAdaptor->SetSinglePass(singlePass);
+      analysisAdaptor->Execute(dataAdaptor);
+      analysisAdaptor->GetHistogram(iMin[singlePass], iMax[singlePass],
+        iBins[singlePass]);
+      analysisAdaptor->Finalize();
+      analysisAdaptor->Delete();
+      }
+
+    uint64_t tol = 0;
+    if (wide)
+      {
+      uint64_t fullest = 0;
+      for (size_t i = 0; i < iBins[0].size(); ++i)
+        fullest = std::max(fullest, iBins[0][i]);
+      tol = 1 + 2*fullest/128;
+      }
+
+    std::string mode = std::string(name) + " single pass";
+    testResult += validateAgainst(mode.c_str(), iMin[1], iMax[1], iBins[1],
+      iMin[0], iMax[0], iBins[0], tol);
+    }
+
+  // the asynchronous reduction is completed by the next step
+  // or when the result is requested
+  analysisAdaptor = sensei::Histogram::New();
+  analysisAdaptor->Initialize(gNBins, "mesh", vtkDataObject::POINT, "normal");
+  analysisAdaptor->SetAsynchronous(true);
+
+  for (int i = 0; i < 2; ++i)
+    analysisAdaptor->Execute(dataAdaptor);
+
+  analysisAdaptor->GetHistogram(min, max, bins);
+  testResult += validateHistogram(min, max, bins);
+
+  analysisAdaptor->Finalize();
+  analysisAdaptor->Delete();
+
+  // accumulate over time on a fixed range, the reduction is
+  // done by Finalize
+  analysisAdaptor = sensei::Histogram::New();
+  analysisAdaptor->Initialize(gNBins, "mesh", vtkDataObject::POINT, "normal");
+  analysisAdaptor->SetRange(gMin, gMax);
+
+  for (int i = 0; i < 3; ++i)
+    analysisAdaptor->Execute(dataAdaptor);
+
+  analysisAdaptor->Finalize();
+
+  analysisAdaptor->GetHistogram(min, max, bins);
+  testResult += validateHistogram(min, max, bins, 1.0, 3);
+
+  analysisAdaptor->Delete();
+
+  // on a very narrow fixed range the bin indices of all but the
+  // minimum overflow an int, they are counted in the last bin
+  analysisAdaptor = sensei::Histogram::New();
+  analysisAdaptor->Initialize(gNBins, "mesh", vtkDataObject::POINT, "normal");
+  analysisAdaptor->SetRange(gMin, gMin + 1.0e-9);
+  analysisAdaptor->Execute(dataAdaptor);
+  analysisAdaptor->Finalize();
+
+  analysisAdaptor->GetHistogram(min, max, bins);
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (rank == 0)
+    {
+    uint64_t nMiddle = 0;
+    for (unsigned int i = 1; i < gNBins - 1; ++i)
+      nMiddle += bins[i];
+    if ((bins.size() != gNBins) || nMiddle || (bins[0] != 1) ||
+      (bins[gNBins-1] != gSequenceLen - 1))
+      {
+      SENSEI_ERROR("Values above the fixed range are binned wrong")
+      testResult += 1;
+      }
+    }
+
+  analysisAdaptor->Delete();
+
+  if (rank == 0)
+    {
+    testResult += validateOutOfRange<float>("float");
+    testResult += validateOutOfRange<double>("double");
+    testResult += validateOutOfRange<int>("int");
+    testResult += validateWideBins();
+    }
+
+  // compute both arrays at once
+  sensei::MultiHistogram *multiAdaptor = sensei::MultiHistogram::New();
+  multiAdaptor->Initialize("mesh");
+  multiAdaptor->AddArray(vtkDataObject::POINT, "normal", gNBins);
+  multiAdaptor->AddArray(vtkDataObject::POINT, "scaled", gNBins);
+
+  multiAdaptor->Execute(dataAdaptor);
+
+  for (int i = 0; i < 2; ++i)
+    {
+    multiAdaptor->GetHistogram(i, min, max, bins);
+    testResult += validateHistogram(min, max, bins, i ? 2.0 : 1.0);
+    }
+
+  multiAdaptor->Finalize();
+  multiAdaptor->Delete();
+
+  // the joint histogram of the array and its scaled copy has the
+  // counts on the diagonal
+  sensei::JointHistogram *jointAdaptor = sensei::JointHistogram::New();
+  jointAdaptor->Initialize("mesh", vtkDataObject::POINT,
+    "normal", gNBins, "scaled", gNBins);
+
+  jointAdaptor->Execute(dataAdaptor);
+
+  double xRange[2] = {0.0};
+  double yRange[2] = {0.0};
+  std::vector<uint64_t> jointBins;
+  jointAdaptor->GetHistogram(xRange, yRange, jointBins);
+
+  if ((rank == 0) && (jointBins.size() == gNBins*gNBins))
+    {
+    std::vector<uint64_t> diag(gNBins);
+    for (unsigned int i = 0; i < gNBins; ++i)
+      {
+      diag[i] = jointBins[i*gNBins + i];
+      jointBins[i*gNBins + i] = 0;
+      }
+    testResult += validateHistogram(xRange[0], xRange[1], diag);
+    testResult += validateHistogram(yRange[0], yRange[1], diag, 2.0);
+    for (unsigned int i = 0; i < gNBins*gNBins; ++i)
+      {
+      if (jointBins[i])
+        {
+        SENSEI_ERROR("Joint histogram has counts off the diagonal")
+        testResult += 1;
+        break;
+        }
+      }
+    }
+  else if (rank == 0)
+    {
+    SENSEI_ERROR("Joint histogram has the wrong number of bins")
+    testResult += 1;
+    }
+
+  jointAdaptor->Finalize();
+  jointAdaptor->Delete();
+  dataAdaptor->Delete();
+  im->Delete();
 
   MPI_Finalize();
 
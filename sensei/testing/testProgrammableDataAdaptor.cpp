@@ -25,7 +25,7 @@ int main(int argc, char **argv)
   //                                            * * * *
   //                                          * * * * *
   //                                        * * * * * * *
-  std::vector<unsigned int> baselineHist = {1,2,4,6,5,3,1};
+  std::vector<uint64_t> baselineHist = {1,2,4,6,5,3,1};
   //                                        0,1,2,3,4,5,6
 
   std::vector<double> data = {0, 1,1, 2,2,2,2,
@@ -145,7 +145,7 @@ int main(int argc, char **argv)
 
     double min = 0.0;
     double max = 0.0;
-    std::vector<unsigned int> hist;
+    std::vector<uint64_t> hist;
     ha->GetHistogram(min, max, hist);
 
     if (hist == baselineHist)
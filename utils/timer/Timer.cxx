@@ -79,7 +79,11 @@ namespace impl
     uint64_t VmHWM[3];
     int Count;
 
-    Event() : Count(0)
+    // set for values logged by MarkValue, which are kept in Duration
+    bool IsValue;
+    std::string Units;
+
+    Event() : Count(0), IsValue(false)
     {
     bzero(this->Duration, sizeof(double)*3);
     bzero(this->VmHWM, sizeof(uint64_t)*3);
@@ -116,6 +120,24 @@ namespace impl
       {
       if (this->Count == 0) { return; }
 
+      if (this->IsValue)
+        {
+        if (this->Count == 1)
+          {
+          stream << indent << this->Name.c_str() << " = ("
+                 << this->Duration[MIN] << " " << this->Units.c_str() << ")" << endl;
+          }
+        else
+          {
+          stream << indent << this->Name.c_str() << " = "
+                 << "( min: " << this->Duration[MIN]
+                 << ", max: " << this->Duration[MAX]
+                 << ", avg: " << this->Duration[SUM] / this->Count
+                 << " " << this->Units.c_str() << " )" << endl;
+          }
+        return;
+        }
+
       if (this->Count == 1)
         {
         stream << indent << this->Name.c_str() << " = ("
@@ -227,6 +249,29 @@ void MarkEndEvent(const char* eventname)
     }
 }
 
+//-----------------------------------------------------------------------------
+void MarkValue(const char* name, double value, const char* units)
+{
+  if (impl::LoggingEnabled)
+    {
+    impl::Event evt;
+    evt.Name = name? name : "(none)";
+    evt.Units = units? units : "";
+    evt.IsValue = true;
+    evt.Duration[0] = evt.Duration[1] = evt.Duration[2] = value;
+    evt.Count = 1;
+
+    if (impl::Mark.empty())
+      {
+      impl::GlobalEvents.push_back(evt);
+      }
+    else
+      {
+      impl::Mark.back().SubEvents.push_back(evt);
+      }
+    }
+}
+
 //-----------------------------------------------------------------------------
 void MarkStartTimeStep(int timestep, double time)
 {
@@ -367,6 +412,11 @@ void TIMER_MarkEndEvent(const char* val)
   timer::MarkEndEvent(val);
 }
 
+void TIMER_MarkValue(const char* name, double value, const char* units)
+{
+  timer::MarkValue(name, value, units);
+}
+
 void TIMER_MarkStartTimeStep(int timestep, double time)
 {
   timer::MarkStartTimeStep(timestep, time);
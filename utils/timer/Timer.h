@@ -40,6 +40,13 @@ namespace timer
   void MarkStartEvent(const char* eventname);
   void MarkEndEvent(const char* eventname);
 
+  /// @brief Log a value measured during the current event.
+  ///
+  /// The value, a rate or a ratio for instance, is logged under the
+  /// given name and units as a sub event of the active event. Values are
+  /// summarized over timesteps like the durations of events.
+  void MarkValue(const char* name, double value, const char* units);
+
   /// @brief Mark the beginning of a timestep.
   ///
   /// This marks the beginning of a timestep. All MarkStartEvent and
@@ -8,6 +8,7 @@ extern "C" {
   void TIMER_SetLogging(bool val);
   void TIMER_MarkStartEvent(const char* val);
   void TIMER_MarkEndEvent(const char* val);
+  void TIMER_MarkValue(const char* name, double value, const char* units);
   void TIMER_MarkStartTimeStep(int timestep, double time);
   void TIMER_MarkEndTimeStep();
   void TIMER_Print();